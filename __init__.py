@@ -13,43 +13,532 @@ Date: 2025-10-10
 import esphome.codegen as cg
 import esphome.config_validation as cv
 from esphome import pins
+from esphome.components.esp32 import (
+    get_esp32_variant,
+    VARIANT_ESP32C2,
+    VARIANT_ESP32C3,
+    VARIANT_ESP32C6,
+    VARIANT_ESP32H2,
+    VARIANT_ESP32S2,
+)
 from esphome.const import (
     CONF_ID,
+    CONF_PIN,
+    CONF_TYPE,
     UNIT_HERTZ,
     ICON_PULSE,
     DEVICE_CLASS_FREQUENCY,
     STATE_CLASS_MEASUREMENT,
 )
 
+from .flicker import flicker_pattern_table
+
 # Define namespace
 zero_cross_relay_ns = cg.esphome_ns.namespace("zero_cross_relay")
 ZeroCrossRelayComponent = zero_cross_relay_ns.class_(
     "ZeroCrossRelayComponent", cg.Component
 )
+ZeroCrossRelay = zero_cross_relay_ns.class_("ZeroCrossRelay", ZeroCrossRelayComponent)
+ModulationMode = zero_cross_relay_ns.enum("ModulationMode")
+PatternDistribution = zero_cross_relay_ns.enum("PatternDistribution")
+EdgeCaptureMode = zero_cross_relay_ns.enum("EdgeCaptureMode")
+LoadType = zero_cross_relay_ns.enum("LoadType")
+FeedbackType = zero_cross_relay_ns.enum("FeedbackType")
 
 # Configuration key definitions
 CONF_ZERO_CROSS_PIN = "zero_cross_pin"
 CONF_RELAY_OUTPUT_PIN = "relay_output_pin"
+CONF_MODULATION_MODE = "modulation_mode"
+CONF_PATTERN_DISTRIBUTION = "pattern_distribution"
+CONF_PATTERN_LENGTH = "pattern_length"
+CONF_PATTERN_TABLE_ID = "pattern_table_id"
+CONF_FLICKER_MAINS_FREQUENCY = "flicker_mains_frequency"
+CONF_OUTPUT_MODE = "output_mode"
+CONF_DETECTOR = "detector"
+CONF_DETECTOR_FALLBACK = "detector_fallback"
+CONF_SECONDARY_ZERO_CROSS_PIN = "secondary_zero_cross_pin"
+CONF_IMMEDIATE_APPLY = "immediate_apply"
+CONF_SWITCH_PHASE = "switch_phase"
+CONF_WINDOW_LENGTH = "window_length"
+CONF_EDGE_CAPTURE = "edge_capture"
+CONF_FALLBACK_PWM_PERIOD = "fallback_pwm_period"
+CONF_FALLBACK_TIMEOUT = "fallback_timeout"
+CONF_CURRENT_ZERO_PIN = "current_zero_pin"
+CONF_CURRENT_SENSE = "current_sense"
+CONF_AMPS_PER_VOLT = "amps_per_volt"
+CONF_VOLTAGE_PIN = "voltage_pin"
+CONF_VOLTS_PER_VOLT = "volts_per_volt"
+CONF_RATED_POWER = "rated_power"
+CONF_LOAD_TYPE = "load_type"
+CONF_RAMP_RATE = "ramp_rate"
+CONF_OUTPUT_FEEDBACK = "output_feedback"
+CONF_FAULT_THRESHOLD = "fault_threshold"
+CONF_FAILSAFE_PIN = "failsafe_pin"
+CONF_THERMAL = "thermal"
+CONF_ON_VOLTAGE = "on_voltage"
+CONF_JUNCTION_RESISTANCE = "junction_resistance"
+CONF_HEATSINK_RESISTANCE = "heatsink_resistance"
+CONF_JUNCTION_TIME_CONSTANT = "junction_time_constant"
+CONF_HEATSINK_TIME_CONSTANT = "heatsink_time_constant"
+CONF_DERATE_START = "derate_start"
+CONF_MAX_TEMPERATURE = "max_temperature"
+CONF_AMBIENT_TEMPERATURE = "ambient_temperature"
+CONF_RATED_CURRENT = "rated_current"
+CONF_WATCHDOG = "watchdog"
+CONF_MAX_ON_TIME = "max_on_time"
+CONF_MIN_OFF_TIME = "min_off_time"
+CONF_MAX_AVERAGE_DUTY = "max_average_duty"
+CONF_AVERAGE_WINDOW = "average_window"
+CONF_SAFE_DUTY = "safe_duty"
+CONF_MECHANICAL_RELAY = "mechanical_relay"
+CONF_OPERATE_TIME = "operate_time"
+CONF_RELEASE_TIME = "release_time"
+CONF_CONTACT_FEEDBACK_PIN = "contact_feedback_pin"
+
+MODULATION_MODES = {
+    "flip_point": ModulationMode.MODULATION_FLIP_POINT,
+    "pattern": ModulationMode.MODULATION_PATTERN,
+    "time_proportioning": ModulationMode.MODULATION_TIME_PROPORTIONING,
+    "hybrid": ModulationMode.MODULATION_HYBRID,
+}
+
+PATTERN_DISTRIBUTIONS = {
+    "even": PatternDistribution.PATTERN_DISTRIBUTION_EVEN,
+    "burst": PatternDistribution.PATTERN_DISTRIBUTION_BURST,
+    "flicker": PatternDistribution.PATTERN_DISTRIBUTION_FLICKER,
+}
+
+# Edge detector policies (first template argument of ZeroCrossRelay)
+DETECTORS = {
+    "pcnt": zero_cross_relay_ns.class_("PcntDetector"),
+    "gpio_isr": zero_cross_relay_ns.class_("GpioIsrDetector"),
+    "etm_capture": zero_cross_relay_ns.class_("EtmCaptureDetector"),
+    "mcpwm_capture": zero_cross_relay_ns.class_("McpwmCaptureDetector"),
+    "dual_gpio_isr": zero_cross_relay_ns.class_("DualGpioDetector"),
+}
+
+# pcnt falls back to the GPIO interrupt detector when no PCNT unit is free at setup
+FallbackDetector = zero_cross_relay_ns.class_("FallbackDetector")
+
+# Relay output stage policies (second template argument of ZeroCrossRelay)
+OUTPUTS = {
+    "gptimer": zero_cross_relay_ns.class_("GptimerOutput"),
+    "rmt": zero_cross_relay_ns.class_("RmtOutput"),
+    "mcpwm": zero_cross_relay_ns.class_("McpwmOutput"),
+}
+
+# "auto" is LOAD_TYPE_UNKNOWN plus the commissioning test at the first boot
+LOAD_TYPES = {
+    "auto": LoadType.LOAD_TYPE_UNKNOWN,
+    "resistive": LoadType.LOAD_TYPE_RESISTIVE,
+    "inductive": LoadType.LOAD_TYPE_INDUCTIVE,
+    "lamp": LoadType.LOAD_TYPE_LAMP,
+    "capacitive": LoadType.LOAD_TYPE_CAPACITIVE,
+}
+
+FEEDBACK_TYPES = {
+    "level": FeedbackType.FEEDBACK_LEVEL,
+    "current": FeedbackType.FEEDBACK_CURRENT,
+}
+
+EDGE_CAPTURE_MODES = {
+    "none": EdgeCaptureMode.EDGE_CAPTURE_NONE,
+    "rmt": EdgeCaptureMode.EDGE_CAPTURE_RMT,
+}
+
+# Chips without an MCPWM peripheral
+NO_MCPWM_VARIANTS = [VARIANT_ESP32C2, VARIANT_ESP32C3, VARIANT_ESP32S2]
+
+# Chips whose GPTimer can capture a GPIO edge through the event task matrix
+ETM_CAPTURE_VARIANTS = [VARIANT_ESP32C6, VARIANT_ESP32H2]
+
+# Pattern mode shifts out one bit of a 64-bit mask per edge
+MAX_PATTERN_LENGTH = 64
+
+# Time proportioning windows are whole 20-edge detector segments (16-bit segment counter)
+SEGMENT_LENGTH = 20
+MAX_WINDOW_LENGTH = 65520
+
+
+def _validate_output_mode(config):
+    """Reject front ends the selected chip or modulation mode cannot provide"""
+    modulation_mode = config.get(CONF_MODULATION_MODE, "flip_point")
+    if config[CONF_OUTPUT_MODE] == "mcpwm":
+        if get_esp32_variant() in NO_MCPWM_VARIANTS:
+            raise cv.Invalid(
+                f"output_mode: mcpwm is not available on {get_esp32_variant()}",
+                path=[CONF_OUTPUT_MODE],
+            )
+        if modulation_mode == "pattern":
+            raise cv.Invalid(
+                "output_mode: mcpwm is phase control and cannot play back patterns",
+                path=[CONF_MODULATION_MODE],
+            )
+    if config[CONF_DETECTOR] == "mcpwm_capture" and get_esp32_variant() in NO_MCPWM_VARIANTS:
+        raise cv.Invalid(
+            f"detector: mcpwm_capture is not available on {get_esp32_variant()}",
+            path=[CONF_DETECTOR],
+        )
+    if config[CONF_DETECTOR] == "etm_capture" and get_esp32_variant() not in ETM_CAPTURE_VARIANTS:
+        raise cv.Invalid(
+            f"detector: etm_capture is not available on {get_esp32_variant()}",
+            path=[CONF_DETECTOR],
+        )
+    if (config[CONF_DETECTOR] == "dual_gpio_isr") != (CONF_SECONDARY_ZERO_CROSS_PIN in config):
+        raise cv.Invalid(
+            "detector: dual_gpio_isr and secondary_zero_cross_pin go together",
+            path=[CONF_SECONDARY_ZERO_CROSS_PIN],
+        )
+    if config[CONF_DETECTOR] == "dual_gpio_isr" and config[CONF_OUTPUT_MODE] == "mcpwm":
+        raise cv.Invalid(
+            "detector: dual_gpio_isr needs output_mode: gptimer or rmt (MCPWM syncs to the primary pin in hardware)",
+            path=[CONF_DETECTOR],
+        )
+    if modulation_mode == "time_proportioning":
+        if config[CONF_OUTPUT_MODE] != "gptimer":
+            raise cv.Invalid(
+                "modulation_mode: time_proportioning needs output_mode: gptimer",
+                path=[CONF_OUTPUT_MODE],
+            )
+        if config[CONF_WINDOW_LENGTH] % SEGMENT_LENGTH != 0:
+            raise cv.Invalid(
+                f"window_length must be a multiple of {SEGMENT_LENGTH} half-cycles",
+                path=[CONF_WINDOW_LENGTH],
+            )
+    if modulation_mode == "hybrid" and config[CONF_OUTPUT_MODE] != "gptimer":
+        raise cv.Invalid(
+            "modulation_mode: hybrid needs output_mode: gptimer (the phase cut reuses the delay timer)",
+            path=[CONF_OUTPUT_MODE],
+        )
+    if CONF_MECHANICAL_RELAY in config and (
+        modulation_mode != "time_proportioning" or config[CONF_OUTPUT_MODE] != "gptimer"
+    ):
+        raise cv.Invalid(
+            "mechanical_relay needs modulation_mode: time_proportioning and output_mode: gptimer",
+            path=[CONF_MECHANICAL_RELAY],
+        )
+    if CONF_CURRENT_ZERO_PIN in config and (
+        CONF_MECHANICAL_RELAY in config or config[CONF_OUTPUT_MODE] != "gptimer"
+    ):
+        raise cv.Invalid(
+            "current_zero_pin needs output_mode: gptimer and a solid state relay (no mechanical_relay)",
+            path=[CONF_CURRENT_ZERO_PIN],
+        )
+    if CONF_FALLBACK_PWM_PERIOD in config and config[CONF_OUTPUT_MODE] != "gptimer":
+        raise cv.Invalid(
+            "fallback_pwm_period needs output_mode: gptimer (the fallback drives the relay pin as a GPIO)",
+            path=[CONF_FALLBACK_PWM_PERIOD],
+        )
+    if config[CONF_IMMEDIATE_APPLY] and (
+        config[CONF_OUTPUT_MODE] != "gptimer" or modulation_mode != "flip_point"
+    ):
+        raise cv.Invalid(
+            "immediate_apply needs output_mode: gptimer and modulation_mode: flip_point",
+            path=[CONF_IMMEDIATE_APPLY],
+        )
+    if CONF_OUTPUT_FEEDBACK in config and config[CONF_OUTPUT_MODE] != "gptimer":
+        raise cv.Invalid(
+            "output_feedback needs output_mode: gptimer (transitions are verified against its switch log)",
+            path=[CONF_OUTPUT_FEEDBACK],
+        )
+    if CONF_THERMAL in config:
+        thermal = config[CONF_THERMAL]
+        if CONF_CURRENT_SENSE not in config and CONF_RATED_CURRENT not in thermal:
+            raise cv.Invalid(
+                "thermal needs current_sense or rated_current (the load current heats the SSR)",
+                path=[CONF_THERMAL],
+            )
+        if thermal[CONF_DERATE_START] >= thermal[CONF_MAX_TEMPERATURE]:
+            raise cv.Invalid(
+                "derate_start must be below max_temperature",
+                path=[CONF_THERMAL, CONF_DERATE_START],
+            )
+    if CONF_WATCHDOG in config:
+        watchdog = config[CONF_WATCHDOG]
+        if config[CONF_OUTPUT_MODE] == "mcpwm":
+            raise cv.Invalid(
+                "watchdog needs output_mode: gptimer or rmt (limits are enforced in the window boundary ISR)",
+                path=[CONF_WATCHDOG],
+            )
+        if not any(key in watchdog for key in (CONF_MAX_ON_TIME, CONF_MIN_OFF_TIME, CONF_MAX_AVERAGE_DUTY)):
+            raise cv.Invalid(
+                "watchdog needs at least one of max_on_time, min_off_time or max_average_duty",
+                path=[CONF_WATCHDOG],
+            )
+    if config.get(CONF_LOAD_TYPE) == "auto" and config[CONF_OUTPUT_MODE] != "gptimer":
+        raise cv.Invalid(
+            "load_type: auto needs output_mode: gptimer (the test is timed from its switch transitions)",
+            path=[CONF_LOAD_TYPE],
+        )
+    return config
+
+
+def _edge_capture_mcpwm(config):
+    """Map `edge_capture: mcpwm` (MCPWM edge timestamps) onto the MCPWM capture detector policy"""
+    if not isinstance(config, dict) or str(config.get(CONF_EDGE_CAPTURE, "")).lower() != "mcpwm":
+        return config
+    detector = str(config.get(CONF_DETECTOR, "mcpwm_capture")).lower()
+    if detector != "mcpwm_capture":
+        raise cv.Invalid(
+            f"edge_capture: mcpwm selects detector: mcpwm_capture and cannot be combined with detector: {detector}",
+            path=[CONF_EDGE_CAPTURE],
+        )
+    config = config.copy()
+    config[CONF_DETECTOR] = "mcpwm_capture"
+    config[CONF_EDGE_CAPTURE] = "none"
+    return config
+
 
 # Component configuration schema
-CONFIG_SCHEMA = cv.Schema(
-    {
-        cv.GenerateID(): cv.declare_id(ZeroCrossRelayComponent),
-        cv.Optional(CONF_ZERO_CROSS_PIN, default="GPIO3"): pins.gpio_input_pin_schema,
-        cv.Optional(CONF_RELAY_OUTPUT_PIN, default="GPIO4"): pins.gpio_output_pin_schema,
-    }
-).extend(cv.COMPONENT_SCHEMA)
+CONFIG_SCHEMA = cv.All(
+    _edge_capture_mcpwm,
+    cv.Schema(
+        {
+            cv.GenerateID(): cv.declare_id(ZeroCrossRelay),
+            cv.Optional(CONF_ZERO_CROSS_PIN, default="GPIO3"): pins.gpio_input_pin_schema,
+            cv.Optional(CONF_RELAY_OUTPUT_PIN, default="GPIO4"): pins.gpio_output_pin_schema,
+            # No schema default: a load profile may only pick the mode when the YAML leaves it open
+            cv.Optional(CONF_MODULATION_MODE): cv.enum(
+                MODULATION_MODES, lower=True
+            ),
+            cv.Optional(CONF_DETECTOR, default="pcnt"): cv.one_of(
+                *DETECTORS, lower=True
+            ),
+            cv.Optional(CONF_DETECTOR_FALLBACK, default=True): cv.boolean,
+            cv.Optional(CONF_SECONDARY_ZERO_CROSS_PIN): pins.internal_gpio_input_pin_schema,
+            cv.Optional(CONF_OUTPUT_MODE, default="gptimer"): cv.one_of(
+                *OUTPUTS, lower=True
+            ),
+            cv.Optional(CONF_EDGE_CAPTURE, default="none"): cv.enum(
+                EDGE_CAPTURE_MODES, lower=True
+            ),
+            cv.Optional(CONF_IMMEDIATE_APPLY, default=False): cv.boolean,
+            cv.Optional(CONF_SWITCH_PHASE, default=36.0): cv.float_range(
+                min=0.0, max=90.0
+            ),
+            cv.Optional(CONF_PATTERN_DISTRIBUTION, default="even"): cv.enum(
+                PATTERN_DISTRIBUTIONS, lower=True
+            ),
+            cv.Optional(CONF_PATTERN_LENGTH, default=20): cv.int_range(
+                min=1, max=MAX_PATTERN_LENGTH
+            ),
+            cv.GenerateID(CONF_PATTERN_TABLE_ID): cv.declare_id(cg.uint64),
+            cv.Optional(CONF_FLICKER_MAINS_FREQUENCY, default=50.0): cv.float_range(
+                min=40.0, max=70.0
+            ),
+            cv.Optional(CONF_WINDOW_LENGTH, default=1000): cv.int_range(
+                min=SEGMENT_LENGTH, max=MAX_WINDOW_LENGTH
+            ),
+            cv.Optional(CONF_FALLBACK_PWM_PERIOD): cv.All(
+                cv.positive_time_period_milliseconds,
+                cv.Range(min=cv.TimePeriod(milliseconds=100)),
+            ),
+            cv.Optional(
+                CONF_FALLBACK_TIMEOUT, default="500ms"
+            ): cv.positive_time_period_milliseconds,
+            cv.Optional(CONF_CURRENT_ZERO_PIN): pins.internal_gpio_input_pin_schema,
+            cv.Optional(CONF_CURRENT_SENSE): cv.Schema(
+                {
+                    cv.Required(CONF_PIN): pins.internal_gpio_input_pin_schema,
+                    cv.Required(CONF_AMPS_PER_VOLT): cv.positive_float,
+                    cv.Inclusive(CONF_VOLTAGE_PIN, "metering"): pins.internal_gpio_input_pin_schema,
+                    cv.Inclusive(CONF_VOLTS_PER_VOLT, "metering"): cv.positive_float,
+                }
+            ),
+            cv.Optional(CONF_RATED_POWER): cv.positive_float,
+            cv.Optional(CONF_OUTPUT_FEEDBACK): cv.Schema(
+                {
+                    cv.Required(CONF_PIN): pins.internal_gpio_input_pin_schema,
+                    cv.Optional(CONF_TYPE, default="level"): cv.enum(FEEDBACK_TYPES, lower=True),
+                    cv.Optional(CONF_FAULT_THRESHOLD, default=3): cv.int_range(min=1, max=100),
+                    cv.Optional(CONF_FAILSAFE_PIN): pins.internal_gpio_output_pin_schema,
+                }
+            ),
+            cv.Optional(CONF_THERMAL): cv.Schema(
+                {
+                    cv.Optional(CONF_ON_VOLTAGE, default=1.2): cv.float_range(min=0.1, max=5.0),
+                    cv.Optional(CONF_JUNCTION_RESISTANCE, default=1.0): cv.float_range(min=0.05, max=20.0),
+                    cv.Optional(CONF_HEATSINK_RESISTANCE, default=2.0): cv.float_range(min=0.05, max=50.0),
+                    cv.Optional(CONF_JUNCTION_TIME_CONSTANT, default="1s"): cv.positive_time_period_milliseconds,
+                    cv.Optional(CONF_HEATSINK_TIME_CONSTANT, default="300s"): cv.positive_time_period_milliseconds,
+                    cv.Optional(CONF_DERATE_START, default=80.0): cv.float_range(min=20.0, max=150.0),
+                    cv.Optional(CONF_MAX_TEMPERATURE, default=100.0): cv.float_range(min=30.0, max=150.0),
+                    # A number, or "chip" for the chip temperature sensor
+                    cv.Optional(CONF_AMBIENT_TEMPERATURE, default=40.0): cv.Any(
+                        cv.one_of("chip", lower=True), cv.float_range(min=-40.0, max=100.0)
+                    ),
+                    cv.Optional(CONF_RATED_CURRENT): cv.positive_float,
+                }
+            ),
+            cv.Optional(CONF_WATCHDOG): cv.Schema(
+                {
+                    cv.Optional(CONF_MAX_ON_TIME): cv.All(
+                        cv.positive_time_period_milliseconds,
+                        cv.Range(min=cv.TimePeriod(milliseconds=500), max=cv.TimePeriod(hours=24)),
+                    ),
+                    cv.Optional(CONF_MIN_OFF_TIME): cv.All(
+                        cv.positive_time_period_milliseconds,
+                        cv.Range(max=cv.TimePeriod(hours=24)),
+                    ),
+                    cv.Optional(CONF_MAX_AVERAGE_DUTY): cv.float_range(min=1.0, max=99.0),
+                    cv.Optional(CONF_AVERAGE_WINDOW, default="10min"): cv.All(
+                        cv.positive_time_period_milliseconds,
+                        cv.Range(min=cv.TimePeriod(seconds=10), max=cv.TimePeriod(hours=24)),
+                    ),
+                    cv.Optional(CONF_SAFE_DUTY, default=0.0): cv.float_range(min=0.0, max=99.0),
+                }
+            ),
+            cv.Optional(CONF_LOAD_TYPE): cv.enum(LOAD_TYPES, lower=True),
+            cv.Optional(CONF_RAMP_RATE, default=0.0): cv.float_range(min=0.0, max=100.0),
+            cv.Optional(CONF_MECHANICAL_RELAY): cv.Schema(
+                {
+                    cv.Optional(CONF_OPERATE_TIME, default="10ms"): cv.All(
+                        cv.positive_time_period_microseconds,
+                        cv.Range(max=cv.TimePeriod(milliseconds=50)),
+                    ),
+                    cv.Optional(CONF_RELEASE_TIME, default="5ms"): cv.All(
+                        cv.positive_time_period_microseconds,
+                        cv.Range(max=cv.TimePeriod(milliseconds=50)),
+                    ),
+                    cv.Optional(CONF_CONTACT_FEEDBACK_PIN): pins.internal_gpio_input_pin_schema,
+                }
+            ),
+        }
+    ).extend(cv.COMPONENT_SCHEMA),
+    _validate_output_mode,
+)
 
 
 async def to_code(config):
     """Generate C++ code"""
-    var = cg.new_Pvariable(config[CONF_ID])
+    # Detector and output stage are template policies: only the selected paths are compiled in
+    detector = DETECTORS[config[CONF_DETECTOR]]
+    if config[CONF_DETECTOR] == "pcnt" and config[CONF_DETECTOR_FALLBACK]:
+        detector = FallbackDetector.template(detector, DETECTORS["gpio_isr"])
+    var = cg.new_Pvariable(
+        config[CONF_ID],
+        cg.TemplateArguments(detector, OUTPUTS[config[CONF_OUTPUT_MODE]]),
+    )
     await cg.register_component(var, config)
 
     # Configure zero-cross detection input pin
     zero_cross_pin = await cg.gpio_pin_expression(config[CONF_ZERO_CROSS_PIN])
     cg.add(var.set_zero_cross_pin(zero_cross_pin))
+    # Redundant detection: the second input belongs to the dual detector policy
+    if CONF_SECONDARY_ZERO_CROSS_PIN in config:
+        secondary_pin = await cg.gpio_pin_expression(config[CONF_SECONDARY_ZERO_CROSS_PIN])
+        cg.add(var.get_detector().set_secondary_pin(secondary_pin))
 
     # Configure relay output pin
     relay_pin = await cg.gpio_pin_expression(config[CONF_RELAY_OUTPUT_PIN])
     cg.add(var.set_relay_output_pin(relay_pin))
+
+    # Configure window modulation (flip point, per-edge pattern, long window or hybrid phase cut)
+    if CONF_MODULATION_MODE in config:
+        cg.add(var.set_modulation_mode(config[CONF_MODULATION_MODE]))
+    cg.add(var.set_pattern_distribution(config[CONF_PATTERN_DISTRIBUTION]))
+    cg.add(var.set_pattern_length(config[CONF_PATTERN_LENGTH]))
+    if config[CONF_PATTERN_DISTRIBUTION] == "flicker":
+        # Lowest flicker cost pattern per on-count, searched here once and stored in flash (see flicker.py)
+        table = flicker_pattern_table(
+            config[CONF_PATTERN_LENGTH], config[CONF_FLICKER_MAINS_FREQUENCY]
+        )
+        pattern_table = cg.static_const_array(
+            config[CONF_PATTERN_TABLE_ID],
+            [cg.RawExpression(f"0x{pattern:016x}ULL") for pattern in table],
+        )
+        cg.add(var.set_pattern_table(pattern_table, len(table)))
+    cg.add(var.set_window_length(config[CONF_WINDOW_LENGTH]))
+    cg.add(var.set_immediate_apply(config[CONF_IMMEDIATE_APPLY]))
+
+    # Switch delay after each zero-cross edge, as a phase angle scaled to the tracked period
+    cg.add(var.set_switch_phase(config[CONF_SWITCH_PHASE]))
+
+    # Configure optional batched edge telemetry front end
+    cg.add(var.set_edge_capture_mode(config[CONF_EDGE_CAPTURE]))
+
+    # Timer-only PWM while no zero-cross edges arrive (DC SSR, failed detector)
+    if CONF_FALLBACK_PWM_PERIOD in config:
+        cg.add(var.set_fallback_pwm_period(config[CONF_FALLBACK_PWM_PERIOD].total_milliseconds))
+        cg.add(var.set_fallback_timeout(config[CONF_FALLBACK_TIMEOUT].total_milliseconds))
+
+    # Mechanical relay: coil driven ahead of the zero-cross, timing learned from contact feedback
+    if CONF_MECHANICAL_RELAY in config:
+        mechanical = config[CONF_MECHANICAL_RELAY]
+        cg.add(var.set_mechanical(True))
+        cg.add(
+            var.set_relay_timing(
+                mechanical[CONF_OPERATE_TIME].total_microseconds,
+                mechanical[CONF_RELEASE_TIME].total_microseconds,
+            )
+        )
+        if CONF_CONTACT_FEEDBACK_PIN in mechanical:
+            feedback_pin = await cg.gpio_pin_expression(mechanical[CONF_CONTACT_FEEDBACK_PIN])
+            cg.add(var.set_contact_feedback_pin(feedback_pin))
+
+    # Load current sign comparator: turn-off follows the measured current zero
+    if CONF_CURRENT_ZERO_PIN in config:
+        current_zero_pin = await cg.gpio_pin_expression(config[CONF_CURRENT_ZERO_PIN])
+        cg.add(var.set_current_zero_pin(current_zero_pin))
+
+    # Current transformer in the continuous ADC stream: RMS per half-cycle with the conduction state
+    if CONF_CURRENT_SENSE in config:
+        current_sense = config[CONF_CURRENT_SENSE]
+        sense_pin = await cg.gpio_pin_expression(current_sense[CONF_PIN])
+        cg.add(var.set_current_sense(sense_pin, current_sense[CONF_AMPS_PER_VOLT]))
+        if CONF_VOLTAGE_PIN in current_sense:
+            # Voltage in the same stream: P/Q/PF per mains cycle, measured watts for set_target_power()
+            voltage_pin = await cg.gpio_pin_expression(current_sense[CONF_VOLTAGE_PIN])
+            cg.add(var.set_voltage_sense(voltage_pin, current_sense[CONF_VOLTS_PER_VOLT]))
+
+    # Modelled full power for set_target_power() until metering has measured it
+    if CONF_RATED_POWER in config:
+        cg.add(var.set_rated_power(config[CONF_RATED_POWER]))
+
+    # Feedback checked after every transition; consecutive mismatches latch a fault and release the failsafe pin
+    if CONF_OUTPUT_FEEDBACK in config:
+        feedback = config[CONF_OUTPUT_FEEDBACK]
+        feedback_pin = await cg.gpio_pin_expression(feedback[CONF_PIN])
+        cg.add(var.set_output_feedback(feedback_pin, feedback[CONF_TYPE], feedback[CONF_FAULT_THRESHOLD]))
+        if CONF_FAILSAFE_PIN in feedback:
+            failsafe_pin = await cg.gpio_pin_expression(feedback[CONF_FAILSAFE_PIN])
+            cg.add(var.set_failsafe_pin(failsafe_pin))
+
+    # SSR junction/heatsink model stepped at window rate; derates every setpoint near the limit
+    if CONF_THERMAL in config:
+        thermal = config[CONF_THERMAL]
+        cg.add(
+            var.set_thermal_model(
+                thermal[CONF_ON_VOLTAGE],
+                thermal[CONF_JUNCTION_RESISTANCE],
+                thermal[CONF_HEATSINK_RESISTANCE],
+                thermal[CONF_JUNCTION_TIME_CONSTANT].total_milliseconds / 1000.0,
+                thermal[CONF_HEATSINK_TIME_CONSTANT].total_milliseconds / 1000.0,
+            )
+        )
+        cg.add(var.set_thermal_limits(thermal[CONF_DERATE_START], thermal[CONF_MAX_TEMPERATURE]))
+        ambient = thermal[CONF_AMBIENT_TEMPERATURE]
+        if ambient == "chip":
+            cg.add(var.set_ambient_temperature(40.0, True))
+        else:
+            cg.add(var.set_ambient_temperature(ambient, False))
+        if CONF_RATED_CURRENT in thermal:
+            cg.add(var.set_rated_current(thermal[CONF_RATED_CURRENT]))
+
+    # Duty watchdog checked at every window boundary; a limit hit holds safe_duty until clear_watchdog()
+    if CONF_WATCHDOG in config:
+        watchdog = config[CONF_WATCHDOG]
+        cg.add(
+            var.set_watchdog(
+                watchdog[CONF_MAX_ON_TIME].total_milliseconds if CONF_MAX_ON_TIME in watchdog else 0,
+                watchdog[CONF_MIN_OFF_TIME].total_milliseconds if CONF_MIN_OFF_TIME in watchdog else 0,
+                watchdog.get(CONF_MAX_AVERAGE_DUTY, 100.0),
+                watchdog[CONF_AVERAGE_WINDOW].total_milliseconds,
+                watchdog[CONF_SAFE_DUTY],
+            )
+        )
+
+    # Soft start; a lamp or inductive load type raises it to that load's minimum
+    cg.add(var.set_ramp_rate(config[CONF_RAMP_RATE]))
+    if CONF_LOAD_TYPE in config:
+        cg.add(var.set_load_type(config[CONF_LOAD_TYPE], config[CONF_LOAD_TYPE] == "auto"))
@@ -0,0 +1,218 @@
+"""
+Flicker-optimised conduction pattern table for pattern mode
+
+Every on-count of a pattern window can be laid out on its half-cycles in many ways.
+They all deliver the same power but modulate the supply voltage differently, and lamps on
+the same circuit show that modulation as flicker. This module scores a pattern with an
+IEC 61000-4-15 style cost:
+
+- The window repeats, so its load steps form a periodic signal. Each DFT bin k lies at
+  k * (2 * mains_hz) / length Hz.
+- Each bin is weighted by the flicker meter's lamp-eye-brain filter (230V lamp, peak near
+  8.8 Hz, normalised to 1).
+- For even window lengths the Nyquist bin is the polarity imbalance between positive and
+  negative half-cycles (DC into transformers), so it is penalised as well.
+
+__init__.py imports flicker_pattern_table() to generate the table at build time. Run this
+file directly to print or validate a table on the host:
+
+    python3 flicker.py --length 20 [--mains 50] [--check]
+"""
+
+import argparse
+import cmath
+import math
+
+# IEC 61000-4-15 weighting filter (230V / 60W lamp) parameters
+_K = 1.74802
+_LAMBDA = 2 * math.pi * 4.05981
+_OMEGA1 = 2 * math.pi * 9.15494
+_OMEGA2 = 2 * math.pi * 2.27979
+_OMEGA3 = 2 * math.pi * 1.22535
+_OMEGA4 = 2 * math.pi * 21.9
+
+# Weight of the polarity imbalance bin relative to the flicker filter peak
+POLARITY_WEIGHT = 1.0
+
+# Local search limit per on-count (each pass tries every single on/off swap)
+MAX_PASSES = 64
+
+
+def _filter_gain(freq_hz):
+    """Magnitude of the flicker weighting filter at freq_hz"""
+    s = complex(0.0, 2 * math.pi * freq_hz)
+    gain = _K * _OMEGA1 * s / (s * s + 2 * _LAMBDA * s + _OMEGA1 * _OMEGA1)
+    gain *= (1 + s / _OMEGA2) / ((1 + s / _OMEGA3) * (1 + s / _OMEGA4))
+    return abs(gain)
+
+
+def bin_weights(length, mains_hz=50.0):
+    """Squared cost weight of DFT bins 1..length//2 of a window of length half-cycles"""
+    peak = max(_filter_gain(f / 10.0) for f in range(5, 300))
+    weights = []
+    for k in range(1, length // 2 + 1):
+        if length % 2 == 0 and k == length // 2:
+            weights.append(POLARITY_WEIGHT**2)
+        else:
+            freq = k * 2.0 * mains_hz / length
+            weights.append((_filter_gain(freq) / peak) ** 2)
+    return weights
+
+
+def _spectrum(bits, length):
+    """DFT bins 1..length//2 of the periodic on/off sequence"""
+    return [
+        sum(cmath.exp(-2j * math.pi * k * i / length) for i in range(length) if bits[i])
+        for k in range(1, length // 2 + 1)
+    ]
+
+
+def pattern_cost(pattern, length, mains_hz=50.0, weights=None):
+    """Flicker cost of a pattern (bit i = half-cycle i); lower is better"""
+    if weights is None:
+        weights = bin_weights(length, mains_hz)
+    bits = [(pattern >> i) & 1 for i in range(length)]
+    spectrum = _spectrum(bits, length)
+    return math.sqrt(sum(w * abs(x) ** 2 for w, x in zip(weights, spectrum))) / length
+
+
+def even_pattern(on_count, length):
+    """Bresenham spread, same layout as ZeroCrossRelayComponent::build_pattern()"""
+    if on_count <= 0:
+        return 0
+    if on_count >= length:
+        return (1 << length) - 1
+    pattern = 0
+    accumulator = length - on_count
+    for i in range(length):
+        accumulator += on_count
+        if accumulator >= length:
+            accumulator -= length
+            pattern |= 1 << i
+    return pattern
+
+
+def burst_pattern(on_count, length):
+    """All on half-cycles back-to-back at the window start"""
+    return (1 << max(0, min(on_count, length))) - 1
+
+
+def _grouped_pattern(on_count, length, group):
+    """Runs of `group` on half-cycles spread evenly (the remainder forms a shorter run)"""
+    runs = -(-on_count // group)
+    starts = even_pattern(runs, length)
+    pattern = 0
+    left = on_count
+    for i in range(length):
+        if (starts >> i) & 1:
+            for j in range(min(group, left)):
+                pattern |= 1 << ((i + j) % length)
+            left -= min(group, left)
+    # Overlapping runs lose bits; such candidates are simply skipped
+    return pattern if bin(pattern).count("1") == on_count else None
+
+
+def _optimise(on_count, length, weights):
+    """Best pattern with on_count bits: best of the seed families, then single-swap descent"""
+    seeds = [even_pattern(on_count, length), burst_pattern(on_count, length)]
+    for group in range(2, on_count + 1):
+        candidate = _grouped_pattern(on_count, length, group)
+        if candidate is not None:
+            seeds.append(candidate)
+    best = min(seeds, key=lambda p: (pattern_cost(p, length, weights=weights), p))
+
+    bins = len(weights)
+    roots = [[cmath.exp(-2j * math.pi * k * i / length) for i in range(length)] for k in range(1, bins + 1)]
+    bits = [(best >> i) & 1 for i in range(length)]
+    spectrum = _spectrum(bits, length)
+    cost = sum(w * abs(x) ** 2 for w, x in zip(weights, spectrum))
+
+    for _ in range(MAX_PASSES):
+        best_move = None
+        best_cost = cost
+        for off in range(length):
+            if not bits[off]:
+                continue
+            for on in range(length):
+                if bits[on]:
+                    continue
+                # Moving one on half-cycle from `off` to `on` changes every bin by two roots of unity
+                trial = sum(
+                    w * abs(x - roots[k][off] + roots[k][on]) ** 2
+                    for k, (w, x) in enumerate(zip(weights, spectrum))
+                )
+                if trial < best_cost - 1e-12:
+                    best_cost = trial
+                    best_move = (off, on)
+        if best_move is None:
+            break
+        off, on = best_move
+        bits[off], bits[on] = 0, 1
+        spectrum = [x - roots[k][off] + roots[k][on] for k, x in enumerate(spectrum)]
+        cost = best_cost
+
+    return sum(1 << i for i in range(length) if bits[i])
+
+
+def flicker_pattern_table(length, mains_hz=50.0):
+    """Lowest-cost pattern for every on-count 0..length (index = on-count)"""
+    weights = bin_weights(length, mains_hz)
+    mask = (1 << length) - 1
+    table = [0] * (length + 1)
+    table[length] = mask
+    for on_count in range(1, length // 2 + 1):
+        table[on_count] = _optimise(on_count, length, weights)
+        # The complement has the same spectrum magnitude in every bin used by the cost
+        table[length - on_count] = ~table[on_count] & mask
+    return table
+
+
+def validate_table(table, length, mains_hz=50.0):
+    """Error strings for a table: wrong size, wrong on-counts, or worse than even/burst spread"""
+    errors = []
+    if len(table) != length + 1:
+        errors.append(f"table has {len(table)} entries, expected {length + 1}")
+        return errors
+    weights = bin_weights(length, mains_hz)
+    for on_count, pattern in enumerate(table):
+        if pattern >> length:
+            errors.append(f"on={on_count}: bits beyond the window length")
+        if bin(pattern).count("1") != on_count:
+            errors.append(f"on={on_count}: pattern has {bin(pattern).count('1')} bits set")
+        cost = pattern_cost(pattern, length, weights=weights)
+        for name, reference in (("even", even_pattern), ("burst", burst_pattern)):
+            if cost > pattern_cost(reference(on_count, length), length, weights=weights) + 1e-9:
+                errors.append(f"on={on_count}: cost {cost:.4f} worse than {name} spread")
+    return errors
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Generate or validate the flicker-optimised pattern table")
+    parser.add_argument("--length", type=int, default=20, help="pattern window length in half-cycles (1-64)")
+    parser.add_argument("--mains", type=float, default=50.0, help="mains frequency in Hz")
+    parser.add_argument("--check", action="store_true", help="validate the generated table, exit 1 on errors")
+    args = parser.parse_args()
+    if not 1 <= args.length <= 64:
+        parser.error("--length must be 1-64")
+
+    table = flicker_pattern_table(args.length, args.mains)
+    weights = bin_weights(args.length, args.mains)
+    print(f"# length={args.length} mains={args.mains:g}Hz   cost: flicker / even / burst")
+    for on_count, pattern in enumerate(table):
+        costs = [
+            pattern_cost(p, args.length, weights=weights)
+            for p in (pattern, even_pattern(on_count, args.length), burst_pattern(on_count, args.length))
+        ]
+        print(f"{on_count:3d}: 0x{pattern:016x}   {costs[0]:.4f} / {costs[1]:.4f} / {costs[2]:.4f}")
+
+    if args.check:
+        errors = validate_table(table, args.length, args.mains)
+        for error in errors:
+            print(f"ERROR: {error}")
+        if errors:
+            raise SystemExit(1)
+        print("OK")
+
+
+if __name__ == "__main__":
+    main()
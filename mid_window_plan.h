@@ -0,0 +1,56 @@
+/**
+ * @file mid_window_plan.h
+ * @brief Flip point window constants and the mid-window update planner of the zero-cross relay
+ *
+ * Pure C++ with no ESP-IDF or ESPHome dependency, so tests/test_mid_window.cpp can check the
+ * planner on the host.
+ */
+
+#pragma once
+
+namespace esphome {
+namespace zero_cross_relay {
+
+/// Half-cycles per flip point window (PCNT high limit, watch point of the window boundary)
+static const int WINDOW_LENGTH = 20;
+
+/**
+ * @brief Result of plan_mid_window_update()
+ */
+struct MidWindowPlan {
+  bool apply_now;   ///< false: next edge is the window boundary, queue for the boundary instead
+  int cut_point;    ///< New count at which the current window goes LOW
+  int watch_point;  ///< Flip watch point to install for the rest of the window (-1 = none)
+};
+
+/**
+ * @brief Plan a flip point change inside the running window (pure, no hardware access)
+ *
+ * The window is HIGH for half-cycles [0, cut) and LOW afterwards; a change never turns the output
+ * back on mid-window and only switches at an edge that is still ahead:
+ * - new flip point ahead of the count and output HIGH: move the cut to the new flip point
+ * - new flip point already passed and output HIGH: cut at the next edge
+ * - output already LOW: nothing left to change in this window
+ *
+ * @param count Edges seen in the current window (detector count, 0-19)
+ * @param cut_point Count at which the current window goes LOW (0-20)
+ * @param new_flip_point Requested flip point (0-20)
+ */
+inline MidWindowPlan plan_mid_window_update(int count, int cut_point, int new_flip_point) {
+  MidWindowPlan plan = {false, cut_point, -1};
+  if (count < 0 || count >= WINDOW_LENGTH - 1) {
+    return plan;
+  }
+  plan.apply_now = true;
+  if (count >= cut_point) {
+    return plan;
+  }
+  plan.cut_point = (new_flip_point > count) ? new_flip_point : count + 1;
+  if (plan.cut_point < WINDOW_LENGTH) {
+    plan.watch_point = plan.cut_point;
+  }
+  return plan;
+}
+
+}  // namespace zero_cross_relay
+}  // namespace esphome
@@ -0,0 +1,90 @@
+/**
+ * @file test_mid_window.cpp
+ * @brief Host test of plan_mid_window_update() over every (count, old cut, new flip point) combination
+ *
+ * The window is modelled per half-cycle: half-cycle i plays HIGH while i < cut. With the detector at
+ * count c, half-cycles 0..c have already started and keep the old level; a plan that applies now sets
+ * the level of half-cycles c+1..19 through its cut point, a queued one leaves the window unchanged.
+ */
+
+#include "mid_window_plan.h"
+
+#include <cstdio>
+
+using esphome::zero_cross_relay::MidWindowPlan;
+using esphome::zero_cross_relay::WINDOW_LENGTH;
+using esphome::zero_cross_relay::plan_mid_window_update;
+
+static int failures = 0;
+
+#define EXPECT(cond, count, old_cut, new_flip, what) \
+  do { \
+    if (!(cond)) { \
+      std::printf("FAIL count=%d old=%d new=%d: %s\n", (count), (old_cut), (new_flip), (what)); \
+      failures++; \
+    } \
+  } while (0)
+
+static void check(int count, int old_cut, int new_flip) {
+  MidWindowPlan plan = plan_mid_window_update(count, old_cut, new_flip);
+  bool high = count < old_cut;  // Level of the half-cycle playing now
+
+  // The next edge is the boundary (or the count is out of range): the change waits for it
+  if (count >= WINDOW_LENGTH - 1) {
+    EXPECT(!plan.apply_now, count, old_cut, new_flip, "applied with the boundary as the next edge");
+    return;
+  }
+  EXPECT(plan.apply_now, count, old_cut, new_flip, "queued although edges remain in the window");
+
+  // Played window: old levels up to the current half-cycle, the plan's cut afterwards
+  int cut = plan.apply_now ? plan.cut_point : old_cut;
+  int level[WINDOW_LENGTH];
+  for (int i = 0; i < WINDOW_LENGTH; i++) {
+    level[i] = (i <= count) ? (i < old_cut) : (i < cut);
+  }
+
+  // No extra transition: the window only ever goes HIGH -> LOW, at most once
+  int transitions = 0;
+  for (int i = 1; i < WINDOW_LENGTH; i++) {
+    EXPECT(!(level[i - 1] == 0 && level[i] == 1), count, old_cut, new_flip, "output turned back on mid-window");
+    transitions += (level[i] != level[i - 1]) ? 1 : 0;
+  }
+  EXPECT(transitions <= 1, count, old_cut, new_flip, "more than one transition in the window");
+
+  if (!high) {
+    // Already LOW: nothing left to change
+    EXPECT(plan.cut_point == old_cut, count, old_cut, new_flip, "cut moved in a window that is already LOW");
+    return;
+  }
+
+  // The cut never lands at or before the current count, and the watch point matches it
+  EXPECT(plan.cut_point > count, count, old_cut, new_flip, "cut before the current count");
+  if (plan.cut_point < WINDOW_LENGTH) {
+    EXPECT(plan.watch_point == plan.cut_point, count, old_cut, new_flip, "watch point does not match the cut");
+    EXPECT(plan.watch_point > count, count, old_cut, new_flip, "watch point already passed");
+  } else {
+    EXPECT(plan.watch_point == -1, count, old_cut, new_flip, "watch point installed for a full window");
+  }
+
+  if (new_flip <= count) {
+    // Passed flip point: cut at the next edge
+    EXPECT(plan.cut_point == count + 1, count, old_cut, new_flip, "passed flip point not cut at the next edge");
+  } else {
+    // Flip point still ahead: it becomes this window's cut
+    EXPECT(plan.cut_point == new_flip, count, old_cut, new_flip, "flip point ahead not used as the cut");
+  }
+}
+
+int main() {
+  int cases = 0;
+  for (int count = 0; count <= WINDOW_LENGTH; count++) {
+    for (int old_cut = 0; old_cut <= WINDOW_LENGTH; old_cut++) {
+      for (int new_flip = 0; new_flip <= WINDOW_LENGTH; new_flip++) {
+        check(count, old_cut, new_flip);
+        cases++;
+      }
+    }
+  }
+  std::printf("plan_mid_window_update: %d combinations, %d failures\n", cases, failures);
+  return (failures == 0) ? 0 : 1;
+}
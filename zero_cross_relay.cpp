@@ -1,18 +1,20 @@
 /**
  * @file zero_cross_relay.cpp
  * @brief Zero-Cross Detection Solid State Relay Component Implementation (ESP-IDF PCNT + CPU Interrupt Version)
- * 
+ *
  * Implementation Details:
  * - PCNT Unit: Counts GPIO3 rising edges from 0 to 20 (auto-clear at 20)
  * - Watch Point 1: Configurable count (1-19) to pull GPIO4 LOW (0% disables, 100% keeps HIGH)
  * - Watch Point 2: Count = 20 → Pull GPIO4 HIGH (turn on relay) + Clear count
  * - Interrupt Callback: PCNT on_reach event triggers ISR for GPIO control
- * 
+ * - Pattern Mode: Watch point 1 on every edge, one precomputed pattern bit consumed per edge
+ * - Policies: detector and output stage classes below are combined by ZeroCrossRelay<Detector, Output>
+ *
  * ESP32 Dual-Core Optimization:
  * - Interrupt Priority: 3 (highest on ESP32, range: 1-3)
  * - CPU Core Affinity: Core 1 (APP_CPU, away from WiFi/BLE on Core 0)
  * - Purpose: Minimize WiFi interference and ensure precise zero-cross timing
- * 
+ *
  * @author chinawrj@gmail.com
  * @date 2025-10-11
  * @updated 2025-10-17 (Added Core 1 binding and highest priority)
@@ -20,27 +22,40 @@
 
 #include "zero_cross_relay.h"
 #include "esphome/core/log.h"
+#include "esphome/core/helpers.h"
 
 // ESP-IDF system headers
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 
+#include <cmath>
+
 namespace esphome {
 namespace zero_cross_relay {
 
 static const char *const TAG = "zero_cross_relay";
 
+static float phase_degrees(uint32_t phase_q16) { return static_cast<float>(phase_q16) * 180.0f / 65536.0f; }
+
+// AC RMS in ADC counts with the bias removed, exact in integers: n² · variance = n · Σx² − (Σx)²
+static float ac_rms_counts(uint32_t samples, uint32_t sum, uint64_t sum_sq) {
+  uint64_t n2_variance = static_cast<uint64_t>(samples) * sum_sq - static_cast<uint64_t>(sum) * sum;
+  return sqrtf(static_cast<float>(n2_variance)) / static_cast<float>(samples);
+}
+
 // PCNT Configuration Constants
 // Note: ESP-IDF PCNT requires symmetric limit range or low_limit < 0
 // We use -20 to +20 range, but only count up from 0, watch at 10 and 20
 #define PCNT_LOW_LIMIT      -20   // Must be negative for ESP-IDF PCNT
-#define PCNT_HIGH_LIMIT     20    // Positive limit
+#define PCNT_HIGH_LIMIT     WINDOW_LENGTH  // Positive limit (20)
 #define PCNT_WATCH_POINT_HALF   10
 #define PCNT_GLITCH_FILTER_NS   1000  // 1us glitch filter (adjust based on signal quality)
 
 // GPTimer Configuration Constants
-#define TIMER_DELAY_US      2000  // 2000us (2ms) delay after PCNT interrupt
+// The switch delay after each edge is a phase angle (switch_phase_q16_), converted to us from the tracked period
 #define TIMER_RESOLUTION_HZ 1000000  // 1MHz timer resolution (1us per tick)
+// The timer free-runs from setup; events are absolute counts on its timeline (depth: GPTIMER_QUEUE_DEPTH)
+#define GPTIMER_STUCK_US    50000    // Queued event this far overdue: the alarm was missed, loop() applies it
 
 // Interrupt Configuration Constants (ESP32 Dual-Core Optimization)
 // ESP32 has PRO_CPU (Core 0, WiFi/BLE) and APP_CPU (Core 1, Application)
@@ -48,23 +63,218 @@ static const char *const TAG = "zero_cross_relay";
 #define INTERRUPT_PRIORITY  3       // Highest priority on ESP32 (range: 1-3)
 #define INTERRUPT_CPU_CORE  1       // Core 1 (APP_CPU, away from WiFi on Core 0)
 
+// RMT Output Configuration Constants
+#define RMT_RESOLUTION_HZ       1000000  // 1MHz RMT tick (1us), same time base as the GPTimer delay
+#define RMT_MAX_DURATION        32767    // 15-bit symbol duration field (longer runs are split)
+#define NOMINAL_HALF_CYCLE_US   10000    // 50Hz half-cycle, used until the first window has been measured
+#define NOMINAL_SWITCH_DELAY_US ((NOMINAL_HALF_CYCLE_US * DEFAULT_SWITCH_PHASE_Q16) >> 16)  // 2000us
+
+// MCPWM Output Configuration Constants
+#define MCPWM_RESOLUTION_HZ     1000000  // 1MHz MCPWM tick (1us)
+#define MCPWM_PERIOD_TICKS      25000    // Longer than any supported half-cycle; sync resets the timer first
+#define MCPWM_MIN_FIRE_Q16      655      // Earliest firing point after the zero-cross edge (1% of the half-cycle)
+#define MCPWM_RELEASE_GUARD_Q16 1966     // Release the gate this far before the predicted next zero-cross (3%)
+#define MCPWM_SYNC_TIMEOUT_MS   100      // No edges for this long => hold output LOW (also the idle liveness timeout)
+
+// Hybrid Phase-Cut Configuration Constants
+#define CUT_MIN_FIRE_Q16        655      // Earliest firing point of the phase-cut half-cycle (1%)
+#define CUT_RELEASE_GUARD_Q16   1966     // Release (or zero-fraction fire) this far before the next zero-cross (3%)
+#define CUT_TABLE_ITERATIONS    16       // Bisection steps per table entry (Q16 resolution)
+
+// Mechanical Relay Configuration Constants
+#define MECH_MIN_OPERATE_US        500      // Feedback faster than this is bounce from the previous operation
+#define MECH_MAX_OPERATE_US        50000    // Slower than this: feedback missed, the sample is discarded
+#define MECH_LEARN_SHIFT           2        // Learned time EWMA weight 1/4 (tracks temperature drift)
+#define MECH_COMMAND_MARGIN_US     1000     // Earliest coil command after the watch point edge
+#define MECH_WEAR_SAVE_INTERVAL_MS 600000   // Flash write interval for the operation count (10 minutes)
+
+// Zero-Current Turn-Off Configuration Constants
+#define CURRENT_ZERO_GUARD_Q16     3277     // Release the gate this far after the current zero (5% of the half-cycle)
+#define CURRENT_LAG_MAX_Q16        32768    // Lags beyond 90° are not inductive; rejected
+#define CURRENT_LAG_FILTER_SHIFT   3        // Lag EWMA weight 1/8
+#define CURRENT_LAG_LOCK_SAMPLES   8        // Samples before the measured lag replaces the switch delay
+
+// Current Sense Configuration Constants (continuous ADC DMA)
+#define CURRENT_SAMPLE_RATE_HZ     5000     // Conversions per second per input (100 per 50Hz half-cycle)
+#define CURRENT_FULL_SCALE_MV      3100     // Nominal pin voltage at full scale with 12dB attenuation (uncalibrated)
+#define CURRENT_POOL_FRAMES        4        // Frames the driver queues while the worker task is busy
+#define CURRENT_MIN_FILL_Q8        192      // Half-cycles with under 75% of the expected samples are discarded
+#define CURRENT_ALIGN_TOLERANCE_Q8 32       // A sample up to 1/8 half-cycle before a zero-cross counts as at it
+#define CURRENT_MAX_GAP_HALF_CYCLES 4       // Longer gaps in the stream restart the half-cycle grid
+#define CURRENT_FILTER_SHIFT       3        // On/off RMS EWMA weight 1/8
+#define CURRENT_VOLTS_PER_COUNT    (CURRENT_FULL_SCALE_MV / 1000.0f / 4095.0f)  // 12-bit results
+#define POWER_UPDATE_INTERVAL_MS   1000     // Power averaging and setpoint regulation period
+#define POWER_DEADBAND_PERCENT     1.0f     // Regulation leaves the duty cycle alone for smaller corrections
+#define POWER_INTEGRAL_GAIN        0.25f    // Share of the metered power error added to the trim per regulation step
+#define POWER_INTEGRAL_LIMIT_PERCENT 20.0f  // Integral trim bound around the feed-forward duty cycle
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 2, 0)
+#define CURRENT_ADC_ATTEN          ADC_ATTEN_DB_12
+#else
+#define CURRENT_ADC_ATTEN          ADC_ATTEN_DB_11
+#endif
+#if CONFIG_IDF_TARGET_ESP32 || CONFIG_IDF_TARGET_ESP32S2
+#define CURRENT_ADC_FORMAT         ADC_DIGI_OUTPUT_FORMAT_TYPE1
+#define CURRENT_ADC_CHANNEL(r)     ((r)->type1.channel)
+#define CURRENT_ADC_DATA(r)        ((r)->type1.data)
+#else
+#define CURRENT_ADC_FORMAT         ADC_DIGI_OUTPUT_FORMAT_TYPE2
+#define CURRENT_ADC_CHANNEL(r)     ((r)->type2.channel)
+#define CURRENT_ADC_DATA(r)        ((r)->type2.data)
+#endif
+
+// Ramp and Load Commissioning Constants
+#define RAMP_STEP_MS               500      // Duty cycle ramp step interval (each step queues one setpoint)
+#define LOAD_LAMP_RAMP_RATE        20.0f    // %/s for lamps: filament warms before the next step (cold = 10x current)
+#define LOAD_INDUCTIVE_RAMP_RATE   10.0f    // %/s for motors: acceleration current stays bounded
+#define LOAD_AUTO_DELAY_MS         10000    // Automatic commissioning waits for a settled supply after boot
+#define LOAD_OFF_MS                2000     // Off time before the test switch-on (lamp filament cools)
+#define LOAD_INRUSH_MS             200      // Inrush phase after the switch-on (10 half-cycles at 50Hz)
+#define LOAD_STEADY_MS             2500     // Switch-on to steady measurement (covers one full power average)
+#define LOAD_SWITCH_TIMEOUT_MS     3000     // Extra wait for a setpoint to reach the relay, beyond one window
+#define LOAD_LAMP_INRUSH_RATIO     2.5f     // Peak / steady current (or detector sag) above this: lamp
+#define LOAD_LAG_DEGREES           15.0f    // |phase shift| above this (PF below 0.97): inductive or capacitive
+#define LOAD_MIN_SAG_US            2        // Steady pulse widening below this: supply too stiff for a sag ratio
+#define LOAD_MIN_LAG_SAMPLES       8        // Current-zero samples (incl. rejected leads) needed for a lag verdict
+
+// Output Verification Configuration Constants
+#define FEEDBACK_SAMPLE_INTERVAL_US 25000   // Longer than one 40Hz mains cycle: a conducting load always shows an edge
+#define FEEDBACK_SETTLE_US         2000     // Readback path delay after a transition (optocoupler, SSR driver)
+#define FEEDBACK_PCNT_LIMIT        32767    // Current-presence edge counter range (cleared every sample)
+
+// SSR Thermal Model Constants
+#define THERMAL_STEP_MS            200      // Model step: one 20-half-cycle window at 50Hz
+#define THERMAL_MAX_LAG_MS         2000     // Loop stalled longer than this: resync instead of catching up
+#define THERMAL_LIMIT_STEP_PERCENT 5.0f     // Duty cycle ceiling granularity (each change queues one setpoint)
+#define THERMAL_CHIP_MIN_C         -10      // Chip temperature sensor range used as the SSR ambient
+#define THERMAL_CHIP_MAX_C         80
+
+// Edge Capture Configuration Constants
+#define CAPTURE_MIN_HALF_CYCLE_US 1000   // Reject rising-to-rising intervals shorter than this (500Hz+ / glitches)
+#define CAPTURE_MAX_HALF_CYCLE_US 15000  // Reject intervals longer than this (<33Hz / missing edges)
+#define CAPTURE_FILTER_SHIFT      3      // Period EWMA weight 1/8
+#define CAPTURE_OUTLIER_SHIFT     2      // Intervals off the filtered period by more than 1/4 are outliers...
+#define CAPTURE_RELOCK_RUN        8      // ...unless this many arrive in a row (supply frequency really changed)
+
+// Dual Input Detector Constants
+#define DUAL_PAIR_WINDOW_US      800    // Partner edge on the other input must follow within this (< 3/4 of 400Hz)
+#define DUAL_PHASE_TOLERANCE_US  300    // Pair offset may deviate this far from the learned offset
+#define DUAL_OFFSET_LEARN_PAIRS  16     // Agreeing pairs averaged before phase is cross-checked
+#define DUAL_OFFSET_FILTER_SHIFT 4      // Offset EWMA weight 1/16 once learned
+#define DUAL_VOTE_OUT_FAULTS     3      // Faults in a row that vote an input out
+#define DUAL_READMIT_EDGES       100    // Agreeing edges in a row that vote it back in (one second at 50Hz)
+
+// Interrupt-Storm Governor Constants (a window is 20 edges)
+#define STORM_MIN_WINDOW_US     (WINDOW_LENGTH * CAPTURE_MIN_HALF_CYCLE_US)  // Shorter window: edges above 1kHz
+#define STORM_MAX_WINDOW_US     (WINDOW_LENGTH * CAPTURE_MAX_HALF_CYCLE_US)  // Longer window: not yet sane mains
+#define STORM_TRIP_WINDOWS      3       // Fast windows in a row that trip the governor
+#define STORM_RECOVER_WINDOWS   5       // Sane windows in a row that hand control back
+#define STORM_PROBE_INTERVAL_MS 1000    // Probe rate while tripped (two interrupts per failed probe)
+
+// RMT RX Batch Capture Constants
+#define RMT_RX_RESOLUTION_HZ    1000000   // 1MHz (1us per duration tick)
+#define RMT_RX_GLITCH_NS        1000      // Ignore pulses shorter than 1us (same as the PCNT glitch filter)
+#define RMT_RX_IDLE_NS          30000000  // 30ms without an edge ends a frame (mains lost); must fit 15 bits of ticks
+
+// Worker Task Configuration (deferred, non-ISR work such as RMT refills)
+#define WORKER_TASK_STACK_SIZE  3072
+#define WORKER_TASK_PRIORITY    (configMAX_PRIORITIES - 5)  // Above ESPHome loop, below WiFi/LwIP
+#define WORKER_TASK_CORE        ((portNUM_PROCESSORS > 1) ? INTERRUPT_CPU_CORE : 0)
+
+uint16_t ZeroCrossRelayComponent::cut_phase_q16_[CUT_FRACTION_STEPS];
+int16_t ZeroCrossRelayComponent::sine_q15_[METER_TABLE_SIZE];
+#if SOC_TEMP_SENSOR_SUPPORTED
+temperature_sensor_handle_t ZeroCrossRelayComponent::chip_sensor_ = nullptr;
+#endif
+#if SOC_ADC_DMA_SUPPORTED
+adc_continuous_handle_t ZeroCrossRelayComponent::adc_handle_ = nullptr;
+uint8_t ZeroCrossRelayComponent::adc_frame_[ADC_FRAME_RESULTS * SOC_ADC_DIGI_RESULT_BYTES];
+#endif
+volatile uint32_t ZeroCrossRelayComponent::adc_frames_done_ = 0;
+volatile uint32_t ZeroCrossRelayComponent::adc_frame_time_us_ = 0;
+volatile uint32_t ZeroCrossRelayComponent::adc_overflows_ = 0;
+uint32_t ZeroCrossRelayComponent::adc_frames_read_ = 0;
+uint32_t ZeroCrossRelayComponent::adc_result_interval_q8_ = 0;
+
 void ZeroCrossRelayComponent::set_duty_cycle_flip_point(int flip_point) {
   if (flip_point < 0 || flip_point > PCNT_HIGH_LIMIT) {
     ESP_LOGW(TAG, "Requested duty cycle flip point %d out of range (valid range: 0-%d).",
              flip_point, PCNT_HIGH_LIMIT);
     return;
   }
+  if (this->output_fault_blocks_(flip_point > 0)) {
+    return;
+  }
+  // Same tracked setpoint as set_duty_cycle_percent(): the thermal ceiling reapplies it, a running ramp is dropped
+  this->requested_percent_ = static_cast<float>(flip_point) * 100.0f / static_cast<float>(PCNT_HIGH_LIMIT);
+  this->ramp_target_percent_ = -1.0f;
+  this->ramp_percent_ = fminf(this->requested_percent_, this->duty_limit_percent_);
+  this->apply_flip_point_(flip_point);
+}
+
+uint32_t ZeroCrossRelayComponent::duty_ceiling_(uint32_t steps) const {
+  if (this->duty_limit_percent_ >= 100.0f) {
+    return steps;
+  }
+  // Round down: the ceiling is a limit, a setpoint one step above it would overheat the SSR
+  return static_cast<uint32_t>(this->duty_limit_percent_ / 100.0f * static_cast<float>(steps) + 0.001f);
+}
+
+void ZeroCrossRelayComponent::apply_flip_point_(int flip_point) {
+  if (this->output_fault_blocks_(flip_point > 0)) {
+    return;
+  }
+  int ceiling = static_cast<int>(this->duty_ceiling_(PCNT_HIGH_LIMIT));
+  if (flip_point > ceiling) {
+    ESP_LOGD(TAG, "Flip point %d derated to %d (SSR temperature)", flip_point, ceiling);
+    flip_point = ceiling;
+  }
 
   float percentage = (static_cast<float>(flip_point) / static_cast<float>(PCNT_HIGH_LIMIT)) * 100.0f;
 
-  if (this->pcnt_unit_ == nullptr) {
+  if (this->modulation_mode_ == MODULATION_TIME_PROPORTIONING) {
+    uint32_t length = static_cast<uint32_t>(this->window_half_cycles_());
+    this->queue_window_on_((static_cast<uint32_t>(flip_point) * length + PCNT_HIGH_LIMIT / 2) / PCNT_HIGH_LIMIT);
+    return;
+  }
+
+  if (this->modulation_mode_ == MODULATION_HYBRID) {
+    this->queue_hybrid_(static_cast<uint32_t>(flip_point) * CUT_FRACTION_STEPS);
+    return;
+  }
+
+  if (this->output_mode_ == OUTPUT_MODE_MCPWM && this->initialized_) {
+    // Phase control: comparators reload on the next sync, so apply immediately.
+    this->duty_cycle_flip_point_ = flip_point;
+    this->pending_duty_cycle_flip_point_ = -1;
+    this->apply_setpoint_now_();
+    this->leave_idle_();
+    ESP_LOGI(TAG, "Applied conduction angle %.1f%% (flip point %d). Takes effect at the next zero-cross.",
+             percentage, flip_point);
+    return;
+  }
+
+  if (!this->initialized_) {
     // Component not fully initialized yet; store as initial value for setup().
     this->duty_cycle_flip_point_ = flip_point;
     this->pending_duty_cycle_flip_point_ = -1;
+    this->pattern_update_pending_ = false;  // setup() builds the pattern from the preset flip point
     ESP_LOGI(TAG, "Preset duty cycle to %.1f%% (flip point %d) before initialization completes.", percentage, flip_point);
     return;
   }
 
+  if (this->modulation_mode_ == MODULATION_PATTERN) {
+    uint64_t pattern = this->pattern_for_flip_point_(flip_point);
+    if (pattern == this->active_pattern_ && !this->pattern_update_pending_) {
+      ESP_LOGD(TAG, "Duty cycle pattern already %.1f%% (flip point %d); ignoring duplicate request.", percentage,
+               flip_point);
+      return;
+    }
+    this->queue_pattern_(pattern, flip_point);
+    ESP_LOGI(TAG, "Queued duty cycle pattern for %.1f%% (%d/%d half-cycles on). Will apply at the next window boundary.",
+             percentage, __builtin_popcountll(pattern), this->pattern_length_);
+    return;
+  }
+
   if (flip_point == this->duty_cycle_flip_point_) {
     // Already active, no need to queue another update.
     this->pending_duty_cycle_flip_point_ = -1;
@@ -72,27 +282,325 @@ void ZeroCrossRelayComponent::set_duty_cycle_flip_point(int flip_point) {
     return;
   }
 
+  if (this->immediate_apply_ && this->apply_mid_window_(flip_point)) {
+    this->leave_idle_();
+    ESP_LOGI(TAG, "Applied duty cycle %.1f%% (flip point %d) inside the current window.", percentage, flip_point);
+    return;
+  }
+
   // Cache the new flip point; will be applied synchronously at next cycle boundary.
   this->pending_duty_cycle_flip_point_ = flip_point;
+  this->leave_idle_();
   ESP_LOGI(TAG,
            "Queued duty cycle update to %.1f%% (flip point %d). Will apply at the next zero-cross cycle boundary.",
            percentage, flip_point);
 }
 
-void ZeroCrossRelayComponent::setup() {
-  ESP_LOGI(TAG, "🔧 Setting up Zero-Cross Detection Solid State Relay (ESP-IDF PCNT + CPU Interrupt Mode)...");
+void ZeroCrossRelayComponent::set_duty_cycle_percent(float percent) {
+  if (!(percent >= 0.0f && percent <= 100.0f)) {
+    ESP_LOGW(TAG, "Requested duty cycle %.2f%% out of range (valid range: 0-100%%).", percent);
+    return;
+  }
+  if (this->output_fault_blocks_(percent > 0.0f)) {
+    return;
+  }
+  this->requested_percent_ = percent;
+  if (percent > this->duty_limit_percent_) {
+    ESP_LOGD(TAG, "Duty cycle %.1f%% derated to %.0f%% (SSR temperature)", percent, this->duty_limit_percent_);
+    percent = this->duty_limit_percent_;
+  }
+  if (this->ramp_rate_ > 0.0f && this->initialized_ && percent > this->ramp_percent_) {
+    // Rises are stepped up by loop() at the ramp rate; falls apply at once
+    if (this->ramp_target_percent_ < 0.0f) {
+      this->ramp_step_ms_ = millis();
+    }
+    this->ramp_target_percent_ = percent;
+    return;
+  }
+  this->ramp_target_percent_ = -1.0f;
+  this->apply_duty_percent_(percent);
+}
+
+void ZeroCrossRelayComponent::apply_duty_percent_(float percent) {
+  this->ramp_percent_ = percent;
+  if (this->modulation_mode_ == MODULATION_TIME_PROPORTIONING) {
+    uint32_t length = static_cast<uint32_t>(this->window_half_cycles_());
+    this->queue_window_on_(static_cast<uint32_t>(percent / 100.0f * static_cast<float>(length) + 0.5f));
+    return;
+  }
+  if (this->modulation_mode_ == MODULATION_HYBRID) {
+    this->queue_hybrid_(static_cast<uint32_t>(percent / 100.0f * (PCNT_HIGH_LIMIT * CUT_FRACTION_STEPS) + 0.5f));
+    return;
+  }
+  this->apply_flip_point_(static_cast<int>(percent / 100.0f * PCNT_HIGH_LIMIT + 0.5f));
+}
+
+void ZeroCrossRelayComponent::queue_window_on_(uint32_t on_half_cycles) {
+  uint32_t length = static_cast<uint32_t>(this->window_half_cycles_());
+  uint32_t ceiling = this->duty_ceiling_(length);
+  if (on_half_cycles > ceiling) {
+    on_half_cycles = ceiling;
+  }
+  if (this->mechanical_) {
+    // A coil command is still in flight for lead_half_cycles_ edges: on and off runs must be longer than that
+    uint32_t min_run = this->lead_half_cycles_ + 1U;
+    if (on_half_cycles > 0 && on_half_cycles < min_run) {
+      on_half_cycles = (min_run <= ceiling) ? min_run : 0;  // Never round up past the thermal ceiling
+    }
+    if (on_half_cycles < length && length - on_half_cycles < min_run) {
+      on_half_cycles = length - min_run;
+    }
+  }
+  // Single aligned 32-bit store; the ISR picks it up when the current long window ends
+  this->pending_window_on_ = static_cast<int32_t>(on_half_cycles);
+  ESP_LOGI(TAG, "Queued time proportioning setpoint %.2f%% (%u/%u half-cycles on). Will apply at the next window boundary.",
+           static_cast<float>(on_half_cycles) * 100.0f / static_cast<float>(length), on_half_cycles, length);
+}
+
+void ZeroCrossRelayComponent::queue_hybrid_(uint32_t on_q8) {
+  uint32_t ceiling = this->duty_ceiling_(PCNT_HIGH_LIMIT * CUT_FRACTION_STEPS);
+  if (on_q8 > ceiling) {
+    on_q8 = ceiling;
+  }
+  int flip_point = static_cast<int>(on_q8 / CUT_FRACTION_STEPS);
+  int fraction = static_cast<int>(on_q8 % CUT_FRACTION_STEPS);
+  if (flip_point >= PCNT_HIGH_LIMIT) {
+    flip_point = PCNT_HIGH_LIMIT;
+    fraction = 0;
+  }
+  float percentage = (static_cast<float>(on_q8) / static_cast<float>(PCNT_HIGH_LIMIT * CUT_FRACTION_STEPS)) * 100.0f;
+
+  if (!this->initialized_) {
+    this->duty_cycle_flip_point_ = flip_point;
+    this->cut_fraction_ = fraction;
+    this->pending_duty_cycle_flip_point_ = -1;
+    this->pending_cut_fraction_ = -1;
+    ESP_LOGI(TAG, "Preset hybrid duty cycle to %.2f%% (%d half-cycles + %d/%d cut) before initialization completes.",
+             percentage, flip_point, fraction, CUT_FRACTION_STEPS);
+    return;
+  }
+
+  // Both halves of the setpoint are handed over together; the boundary ISR swaps them under the same lock
+  portENTER_CRITICAL(&this->window_lock_);
+  bool duplicate = (flip_point == this->duty_cycle_flip_point_ && fraction == this->cut_fraction_);
+  this->pending_cut_fraction_ = duplicate ? -1 : fraction;
+  this->pending_duty_cycle_flip_point_ = duplicate ? -1 : flip_point;
+  portEXIT_CRITICAL(&this->window_lock_);
+  if (duplicate) {
+    ESP_LOGD(TAG, "Hybrid duty cycle already %.2f%%; ignoring duplicate request.", percentage);
+    return;
+  }
+  this->leave_idle_();
+  ESP_LOGI(TAG, "Queued hybrid duty cycle %.2f%% (%d half-cycles + %d/%d cut). Will apply at the next window boundary.",
+           percentage, flip_point, fraction, CUT_FRACTION_STEPS);
+}
+
+void ZeroCrossRelayComponent::build_cut_phase_table_() {
+  // Resistive load fired at phase x (0-1 of the half-cycle) delivers E(x) = 1 - x + sin(2πx) / 2π of a full
+  // half-cycle. E falls monotonically, so bisect x for each fraction once here; the ISR only indexes the table.
+  const float two_pi = 2.0f * static_cast<float>(M_PI);
+  for (int fraction = 0; fraction < CUT_FRACTION_STEPS; fraction++) {
+    float target = static_cast<float>(fraction) / static_cast<float>(CUT_FRACTION_STEPS);
+    float low = 0.0f;
+    float high = 1.0f;
+    for (int i = 0; i < CUT_TABLE_ITERATIONS; i++) {
+      float x = 0.5f * (low + high);
+      float energy = 1.0f - x + sinf(two_pi * x) / two_pi;
+      if (energy > target) {
+        low = x;
+      } else {
+        high = x;
+      }
+    }
+    uint32_t phase_q16 = static_cast<uint32_t>(0.5f * (low + high) * 65536.0f);
+    // Fire late enough to leave room for the release, early enough to clear the edge
+    uint32_t latest_q16 = 65536U - 2U * CUT_RELEASE_GUARD_Q16;
+    if (phase_q16 > latest_q16 || fraction == 0) {
+      phase_q16 = latest_q16;
+    }
+    if (phase_q16 < CUT_MIN_FIRE_Q16) {
+      phase_q16 = CUT_MIN_FIRE_Q16;
+    }
+    cut_phase_q16_[fraction] = static_cast<uint16_t>(phase_q16);
+  }
+}
+
+uint32_t IRAM_ATTR ZeroCrossRelayComponent::cut_fire_us_(int fraction, uint32_t *release_us) const {
+  uint32_t half_us = this->isr_half_cycle_us_;
+  // half_us <= 15000, so the Q16 products stay within 32 bits
+  *release_us = half_us - ((half_us * CUT_RELEASE_GUARD_Q16) >> 16);
+  uint32_t fire_us = (half_us * cut_phase_q16_[fraction]) >> 16;
+  return (fire_us > 0) ? fire_us : 1;
+}
+
+uint32_t IRAM_ATTR ZeroCrossRelayComponent::advance_long_window_() {
+  uint32_t segment = this->window_segment_ + 1U;
+  if (segment >= this->window_segments_) {
+    segment = 0;
+    this->record_window_boundary_();
+    int32_t pending = this->pending_window_on_;
+    if (pending >= 0) {
+      uint32_t length = static_cast<uint32_t>(this->window_segments_) * PCNT_HIGH_LIMIT;
+      this->window_on_half_cycles_ = static_cast<uint32_t>(pending);
+      this->duty_cycle_flip_point_ = static_cast<int>((static_cast<uint32_t>(pending) * PCNT_HIGH_LIMIT + length / 2) / length);
+      this->pending_window_on_ = -1;
+      this->last_watch_point_update_err_ = ESP_OK;
+      this->watch_point_update_event_ = true;
+    }
+  } else {
+    // Windows can span minutes: current sensing takes its voltage zero from every segment edge instead
+    this->zero_cross_timestamp_ = esp_timer_get_time();
+  }
+  this->window_segment_ = static_cast<uint16_t>(segment);
+  return segment;
+}
+
+void ZeroCrossRelayComponent::set_custom_pattern(uint64_t pattern) {
+  if (this->modulation_mode_ != MODULATION_PATTERN) {
+    ESP_LOGW(TAG, "Custom patterns require modulation_mode: pattern; ignoring request.");
+    return;
+  }
+
+  int length = this->pattern_length_;
+  uint64_t mask = (length >= MAX_PATTERN_LENGTH) ? ~0ULL : ((1ULL << length) - 1ULL);
+  pattern &= mask;
+  int on_count = __builtin_popcountll(pattern);
+  int flip_point = (on_count * PCNT_HIGH_LIMIT + length / 2) / length;
+
+  this->queue_pattern_(pattern, flip_point);
+  ESP_LOGI(TAG, "Queued custom pattern 0x%016llx (%d/%d half-cycles on). Will apply at the next window boundary.",
+           static_cast<unsigned long long>(pattern), on_count, length);
+}
+
+uint64_t ZeroCrossRelayComponent::build_pattern(int on_count, int length, PatternDistribution distribution) {
+  if (length <= 0 || on_count <= 0) {
+    return 0;
+  }
+  if (length > MAX_PATTERN_LENGTH) {
+    length = MAX_PATTERN_LENGTH;
+  }
+  if (on_count >= length) {
+    return (length >= MAX_PATTERN_LENGTH) ? ~0ULL : ((1ULL << length) - 1ULL);
+  }
+
+  if (distribution == PATTERN_DISTRIBUTION_BURST) {
+    return (1ULL << on_count) - 1ULL;
+  }
+
+  // Even spread (Bresenham): set bit i whenever the accumulator wraps.
+  // Starting at (length - on_count) puts the first on half-cycle at the window start
+  // and yields exactly on_count bits.
+  uint64_t pattern = 0;
+  int accumulator = length - on_count;
+  for (int i = 0; i < length; i++) {
+    accumulator += on_count;
+    if (accumulator >= length) {
+      accumulator -= length;
+      pattern |= (1ULL << i);
+    }
+  }
+  return pattern;
+}
+
+int ZeroCrossRelayComponent::window_half_cycles_() const {
+  if (this->modulation_mode_ == MODULATION_TIME_PROPORTIONING) {
+    return static_cast<int>(this->window_segments_) * PCNT_HIGH_LIMIT;
+  }
+  return (this->modulation_mode_ == MODULATION_PATTERN) ? this->pattern_length_ : PCNT_HIGH_LIMIT;
+}
+
+uint32_t ZeroCrossRelayComponent::measured_half_cycle_us_() const {
+  uint32_t captured_q4 = this->period_tracker_.half_cycle_q4;
+  if (captured_q4 > 0) {
+    return captured_q4 >> 4;
+  }
+  if (this->last_cycle_time_ > 0) {
+    return this->last_cycle_time_ / static_cast<uint32_t>(this->window_half_cycles_());
+  }
+  return NOMINAL_HALF_CYCLE_US;
+}
+
+uint32_t ZeroCrossRelayComponent::switch_delay_us_() const {
+  // Zero is fine: on the free-running timeline an event at the edge time is already due and fires at once
+  return static_cast<uint32_t>((static_cast<uint64_t>(this->measured_half_cycle_us_()) * this->switch_phase_q16_) >>
+                               16);
+}
+
+uint64_t ZeroCrossRelayComponent::pattern_for_flip_point_(int flip_point) const {
+  // Flip points are expressed in 1/20 steps; scale to the pattern length with rounding.
+  int length = this->pattern_length_;
+  int on_count = (flip_point * length + PCNT_HIGH_LIMIT / 2) / PCNT_HIGH_LIMIT;
+  if (this->pattern_distribution_ == PATTERN_DISTRIBUTION_FLICKER && this->pattern_table_ != nullptr) {
+    // One table lookup per setpoint change; the search was done at build time
+    return this->pattern_table_[on_count];
+  }
+  return build_pattern(on_count, length, this->pattern_distribution_);
+}
+
+uint64_t ZeroCrossRelayComponent::window_pattern_() {
+  if (this->storm_active_) {
+    return 0;
+  }
+  if (this->modulation_mode_ != MODULATION_PATTERN) {
+    return build_pattern(this->duty_cycle_flip_point_, PCNT_HIGH_LIMIT, PATTERN_DISTRIBUTION_BURST);
+  }
+  portENTER_CRITICAL(&this->pattern_lock_);
+  uint64_t pattern = this->active_pattern_;
+  portEXIT_CRITICAL(&this->pattern_lock_);
+  return pattern;
+}
+
+void ZeroCrossRelayComponent::queue_pattern_(uint64_t pattern, int flip_point) {
+  // 64-bit handoff is not atomic on 32-bit cores; the ISR takes the same lock at the window boundary.
+  portENTER_CRITICAL(&this->pattern_lock_);
+  this->pending_pattern_ = pattern;
+  this->pending_duty_cycle_flip_point_ = flip_point;
+  this->pattern_update_pending_ = true;
+  portEXIT_CRITICAL(&this->pattern_lock_);
+}
+
+bool ZeroCrossRelayComponent::setup_pins_() {
+  ESP_LOGI(TAG, "🔧 Setting up Zero-Cross Detection Solid State Relay (ESP-IDF %s + CPU Interrupt Mode)...",
+           this->detector_name_);
 
   // Validate pin configuration
   if (this->zero_cross_pin_ == nullptr) {
     ESP_LOGE(TAG, "❌ Zero-cross detection pin not configured!");
-    this->mark_failed();
-    return;
+    return false;
   }
 
   if (this->relay_output_pin_ == nullptr) {
     ESP_LOGE(TAG, "❌ Relay output pin not configured!");
-    this->mark_failed();
-    return;
+    return false;
+  }
+
+  // A known or stored load type may change the modulation mode, so it is applied before the mode checks
+  this->restore_load_profile_();
+
+  if (this->modulation_mode_ == MODULATION_PATTERN && this->output_mode_ == OUTPUT_MODE_MCPWM) {
+    ESP_LOGE(TAG, "❌ Pattern modulation is not available with MCPWM phase control output!");
+    return false;
+  }
+
+  if (this->modulation_mode_ == MODULATION_TIME_PROPORTIONING && this->output_mode_ != OUTPUT_MODE_GPTIMER) {
+    ESP_LOGE(TAG, "❌ Time proportioning needs the GPTimer output stage!");
+    return false;
+  }
+
+  if (this->current_zero_pin_ != nullptr && (this->mechanical_ || this->output_mode_ != OUTPUT_MODE_GPTIMER)) {
+    ESP_LOGE(TAG, "❌ Zero-current turn-off needs the GPTimer output stage and a solid state relay!");
+    return false;
+  }
+
+  if (this->mechanical_ &&
+      (this->modulation_mode_ != MODULATION_TIME_PROPORTIONING || this->output_mode_ != OUTPUT_MODE_GPTIMER)) {
+    ESP_LOGE(TAG, "❌ Mechanical relays need time proportioning with the GPTimer output stage!");
+    return false;
+  }
+
+  if (this->modulation_mode_ == MODULATION_HYBRID && this->output_mode_ != OUTPUT_MODE_GPTIMER) {
+    ESP_LOGE(TAG, "❌ Hybrid modulation needs the GPTimer output stage!");
+    return false;
   }
 
   // Get GPIO numbers (convert to ESP-IDF format)
@@ -103,143 +611,129 @@ void ZeroCrossRelayComponent::setup() {
   // Step 1: Configure GPIO4 as OUTPUT (Relay Control) - Initialize FIRST
   // ========================================
   ESP_LOGI(TAG, "Step 1: Configuring GPIO%d as OUTPUT (relay control)...", this->relay_output_gpio_num_);
-  
+
   gpio_config_t relay_config = {};
   relay_config.pin_bit_mask = (1ULL << this->relay_output_gpio_num_);
-  relay_config.mode = GPIO_MODE_OUTPUT;
+  relay_config.mode = GPIO_MODE_INPUT_OUTPUT;  // Input path kept so the output stage can read the pad back
   relay_config.pull_up_en = GPIO_PULLUP_DISABLE;
   relay_config.pull_down_en = GPIO_PULLDOWN_DISABLE;
   relay_config.intr_type = GPIO_INTR_DISABLE;
-  
+
   esp_err_t err = gpio_config(&relay_config);
   if (err != ESP_OK) {
     ESP_LOGE(TAG, "❌ Failed to configure GPIO%d: %s", this->relay_output_gpio_num_, esp_err_to_name(err));
-    this->mark_failed();
-    return;
+    return false;
   }
-  
+
   // Initialize output according to current duty cycle (0% => LOW, otherwise HIGH)
-  int initial_level = (this->duty_cycle_flip_point_ == 0) ? 0 : 1;
+  int initial_level = this->initial_level_();
   gpio_set_level(this->relay_output_gpio_num_, initial_level);
+  this->switch_log_.level = initial_level;  // Transitions are logged from here (not counted as an operation)
+  this->switch_log_.time_us = static_cast<uint32_t>(esp_timer_get_time());
   ESP_LOGI(TAG, "✓ GPIO%d configured as OUTPUT, initialized to %s (initial state)",
            this->relay_output_gpio_num_, initial_level ? "HIGH" : "LOW");
 
   // ========================================
-  // Step 2: Configure GPIO3 as INPUT (for PCNT edge counting)
+  // Step 2: Configure GPIO3 as INPUT (for edge detection)
   // ========================================
-  ESP_LOGI(TAG, "Step 2: Configuring GPIO%d as INPUT (zero-cross detection for PCNT)...", this->zero_cross_gpio_num_);
-  
+  ESP_LOGI(TAG, "Step 2: Configuring GPIO%d as INPUT (zero-cross detection for %s)...", this->zero_cross_gpio_num_,
+           this->detector_name_);
+
   gpio_config_t input_config = {};
   input_config.pin_bit_mask = (1ULL << this->zero_cross_gpio_num_);
   input_config.mode = GPIO_MODE_INPUT;
   input_config.pull_up_en = GPIO_PULLUP_ENABLE;  // Enable pull-up (adjust based on your circuit)
   input_config.pull_down_en = GPIO_PULLDOWN_DISABLE;
-  input_config.intr_type = GPIO_INTR_DISABLE;    // PCNT handles edge detection, not GPIO interrupt
-  
+  input_config.intr_type = GPIO_INTR_DISABLE;    // Detector enables its own edge source
+
   err = gpio_config(&input_config);
   if (err != ESP_OK) {
     ESP_LOGE(TAG, "❌ Failed to configure GPIO%d: %s", this->zero_cross_gpio_num_, esp_err_to_name(err));
-    this->mark_failed();
-    return;
+    return false;
   }
   ESP_LOGI(TAG, "✓ GPIO%d configured as INPUT with PULLUP", this->zero_cross_gpio_num_);
+  return true;
+}
 
+int ZeroCrossRelayComponent::initial_watch_points_(bool switches_per_edge, int points[2]) {
   // ========================================
-  // Step 3: Create and Configure PCNT Unit
+  // Step 6: Add Watch Points (configurable flip point and 20, or every edge in pattern mode)
   // ========================================
-  ESP_LOGI(TAG, "Step 3: Creating PCNT unit (count range: 0-%d)...", PCNT_HIGH_LIMIT);
-  
-  pcnt_unit_config_t unit_config = {
-      .low_limit = PCNT_LOW_LIMIT,
-      .high_limit = PCNT_HIGH_LIMIT,
-      .flags = {},
-  };
-  
-  err = pcnt_new_unit(&unit_config, &this->pcnt_unit_);
-  if (err != ESP_OK) {
-    ESP_LOGE(TAG, "❌ Failed to create PCNT unit: %s", esp_err_to_name(err));
-    this->mark_failed();
-    return;
+  int flip_point = this->duty_cycle_flip_point_;  // Read current duty cycle setting
+  if (this->modulation_mode_ == MODULATION_TIME_PROPORTIONING) {
+    uint32_t length = static_cast<uint32_t>(this->window_half_cycles_());
+    ESP_LOGI(TAG, "Step 6: Configuring time proportioning segment watch point (window=%u half-cycles, %u segments)...",
+             length, this->window_segments_);
+    if (this->pending_window_on_ < 0) {
+      this->pending_window_on_ =
+          static_cast<int32_t>((static_cast<uint32_t>(flip_point) * length + PCNT_HIGH_LIMIT / 2) / PCNT_HIGH_LIMIT);
+    }
+    // The first segment boundary starts the first long window
+    this->window_segment_ = static_cast<uint16_t>(this->window_segments_ - 1);
+    points[0] = PCNT_HIGH_LIMIT;
+    ESP_LOGI(TAG, "✓ Watch point ready: %d (segment boundary; the cut segment gets its own watch point)",
+             PCNT_HIGH_LIMIT);
+    return 1;
   }
-  ESP_LOGI(TAG, "✓ PCNT unit created (low=%d, high=%d)", PCNT_LOW_LIMIT, PCNT_HIGH_LIMIT);
+  if (this->modulation_mode_ == MODULATION_PATTERN) {
+    ESP_LOGI(TAG, "Step 6: Configuring pattern mode watch point (every edge, window=%d half-cycles)...",
+             this->pattern_length_);
 
-  // ========================================
-  // Step 4: Configure Glitch Filter (optional but recommended)
-  // ========================================
-  ESP_LOGI(TAG, "Step 4: Configuring glitch filter (%d ns)...", PCNT_GLITCH_FILTER_NS);
-  
-  pcnt_glitch_filter_config_t filter_config = {
-      .max_glitch_ns = PCNT_GLITCH_FILTER_NS,
-  };
-  
-  err = pcnt_unit_set_glitch_filter(this->pcnt_unit_, &filter_config);
-  if (err != ESP_OK) {
-    ESP_LOGE(TAG, "❌ Failed to set glitch filter: %s", esp_err_to_name(err));
-    this->mark_failed();
-    return;
-  }
-  ESP_LOGI(TAG, "✓ Glitch filter configured (%d ns)", PCNT_GLITCH_FILTER_NS);
+    if (this->pattern_distribution_ == PATTERN_DISTRIBUTION_FLICKER &&
+        this->pattern_table_size_ != static_cast<size_t>(this->pattern_length_) + 1U) {
+      ESP_LOGW(TAG, "⚠️ Flicker pattern table has %u entries, expected %d; using even spread",
+               static_cast<uint32_t>(this->pattern_table_size_), this->pattern_length_ + 1);
+      this->pattern_table_ = nullptr;
+    }
 
-  // ========================================
-  // Step 5: Create PCNT Channel and Set Edge Action
-  // ========================================
-  ESP_LOGI(TAG, "Step 5: Creating PCNT channel for GPIO%d...", this->zero_cross_gpio_num_);
-  
-  pcnt_chan_config_t channel_config = {
-      .edge_gpio_num = this->zero_cross_gpio_num_,
-      .level_gpio_num = -1,  // No level control GPIO
-      .flags = {},
-  };
-  
-  err = pcnt_new_channel(this->pcnt_unit_, &channel_config, &this->pcnt_channel_);
-  if (err != ESP_OK) {
-    ESP_LOGE(TAG, "❌ Failed to create PCNT channel: %s", esp_err_to_name(err));
-    this->mark_failed();
-    return;
-  }
-  
-  // Set edge action: Rising edge INCREASE, Falling edge HOLD
-  err = pcnt_channel_set_edge_action(this->pcnt_channel_,
-                                     PCNT_CHANNEL_EDGE_ACTION_INCREASE,
-                                     PCNT_CHANNEL_EDGE_ACTION_HOLD);
-  if (err != ESP_OK) {
-    ESP_LOGE(TAG, "❌ Failed to set edge action: %s", esp_err_to_name(err));
-    this->mark_failed();
-    return;
+    // Build the initial pattern unless a custom one was preset; it is swapped in at the first edge.
+    if (!this->pattern_update_pending_) {
+      this->queue_pattern_(this->pattern_for_flip_point_(flip_point), flip_point);
+    }
+    this->commanded_level_ = this->initial_level_();
+    points[0] = 1;
+    if (switches_per_edge) {
+      ESP_LOGI(TAG, "✓ Watch point ready: 1 (one pattern bit per edge, count cleared every edge)");
+    } else {
+      ESP_LOGI(TAG, "✓ Watch point ready: 1, then chunks of up to %d edges (window playback, refill per window)",
+               PCNT_HIGH_LIMIT);
+    }
+    return 1;
   }
-  ESP_LOGI(TAG, "✓ PCNT channel created (GPIO%d: rising↑ +1, falling↓ hold)", this->zero_cross_gpio_num_);
 
-  // ========================================
-  // Step 6: Add Watch Points (configurable flip point and 20)
-  // ========================================
-  int flip_point = this->duty_cycle_flip_point_;  // Read current duty cycle setting
   ESP_LOGI(TAG, "Step 6: Configuring watch points (flip=%d, high=%d)...", flip_point, PCNT_HIGH_LIMIT);
-  
-  bool has_dynamic_watch_point = (flip_point > 0 && flip_point < PCNT_HIGH_LIMIT);
+  if (this->modulation_mode_ == MODULATION_HYBRID) {
+    build_cut_phase_table_();
+    this->isr_half_cycle_us_ = this->measured_half_cycle_us_();
+    ESP_LOGI(TAG, "   • Hybrid phase-cut table built (%d steps, fire %.1f°-%.1f°)", CUT_FRACTION_STEPS,
+             phase_degrees(cut_phase_q16_[CUT_FRACTION_STEPS - 1]), phase_degrees(cut_phase_q16_[1]));
+  }
+
+  // Window-level and phase control outputs drive the relay themselves; only the boundary needs an interrupt
+  int num_points = 0;
+  bool has_dynamic_watch_point = (flip_point > 0 && flip_point < PCNT_HIGH_LIMIT && switches_per_edge);
   if (has_dynamic_watch_point) {
-    err = pcnt_unit_add_watch_point(this->pcnt_unit_, flip_point);
-    if (err != ESP_OK) {
-      ESP_LOGE(TAG, "❌ Failed to add watch point %d: %s", flip_point, esp_err_to_name(err));
-      this->mark_failed();
-      return;
-    }
+    points[num_points++] = flip_point;
+  } else if (!switches_per_edge) {
+    ESP_LOGI(TAG, "   • Dynamic watch point skipped (%s drives the output).",
+             (this->output_mode_ == OUTPUT_MODE_RMT) ? "RMT window playback" : "MCPWM comparator");
   } else {
     ESP_LOGI(TAG, "   • Dynamic watch point skipped (flip point %d => %.1f%% duty).",
              flip_point,
              (static_cast<float>(flip_point) / static_cast<float>(PCNT_HIGH_LIMIT)) * 100.0f);
   }
-  
-  err = pcnt_unit_add_watch_point(this->pcnt_unit_, PCNT_HIGH_LIMIT);
-  if (err != ESP_OK) {
-    ESP_LOGE(TAG, "❌ Failed to add watch point %d: %s", PCNT_HIGH_LIMIT, esp_err_to_name(err));
-    this->mark_failed();
-    return;
-  }
-  
+  points[num_points++] = PCNT_HIGH_LIMIT;
+
   float duty_percentage = (static_cast<float>(flip_point) / static_cast<float>(PCNT_HIGH_LIMIT)) * 100.0f;
   if (has_dynamic_watch_point) {
     ESP_LOGI(TAG, "✓ Watch points ready: %d (GPIO4→LOW, duty=%.1f%%), %d (GPIO4→HIGH+clear)",
              flip_point, duty_percentage, PCNT_HIGH_LIMIT);
+  } else if (this->output_mode_ == OUTPUT_MODE_RMT) {
+    ESP_LOGI(TAG, "✓ Watch point ready: %d (RMT window refill + clear), duty=%.1f%%",
+             PCNT_HIGH_LIMIT, duty_percentage);
+  } else if (this->output_mode_ == OUTPUT_MODE_MCPWM) {
+    ESP_LOGI(TAG, "✓ Watch point ready: %d (frequency statistics + clear), conduction=%.1f%%",
+             PCNT_HIGH_LIMIT, duty_percentage);
   } else if (flip_point == 0) {
     ESP_LOGI(TAG, "✓ Watch point ready: %d (GPIO4→HIGH+clear). Duty cycle 0%% (relay always OFF).",
              PCNT_HIGH_LIMIT);
@@ -247,368 +741,3445 @@ void ZeroCrossRelayComponent::setup() {
     ESP_LOGI(TAG, "✓ Watch point ready: %d (GPIO4→HIGH+clear). Duty cycle 100%% (relay always ON).",
              PCNT_HIGH_LIMIT);
   }
+  return num_points;
+}
+
+void ZeroCrossRelayComponent::report_watch_point_error_(int value, esp_err_t err) {
+  ESP_LOGE(TAG, "❌ Failed to add watch point %d: %s", value, esp_err_to_name(err));
+}
 
+bool ZeroCrossRelayComponent::setup_telemetry_(bool window_output) {
   // ========================================
-  // Step 7: Register Event Callback with Core 1 Affinity and High Priority
+  // Step 10: Optional Edge Telemetry Front End (batched hardware durations)
   // ========================================
-  ESP_LOGI(TAG, "Step 7: Registering PCNT event callback (Core %d, Priority %d)...", 
-           INTERRUPT_CPU_CORE, INTERRUPT_PRIORITY);
-  
-  pcnt_event_callbacks_t callbacks = {
-      .on_reach = pcnt_on_reach_callback,
-  };
-  
-  err = pcnt_unit_register_event_callbacks(this->pcnt_unit_, &callbacks, (void *)this);
-  if (err != ESP_OK) {
-    ESP_LOGE(TAG, "❌ Failed to register event callbacks: %s", esp_err_to_name(err));
-    this->mark_failed();
-    return;
+  if (this->edge_capture_mode_ == EDGE_CAPTURE_RMT) {
+    ESP_LOGI(TAG, "Step 10: Creating RMT RX channel on GPIO%d (batches of %d pulses)...", this->zero_cross_gpio_num_,
+             static_cast<int>(RMT_RX_BATCH_SYMBOLS));
+    if (!this->setup_rmt_capture_()) {
+      return false;
+    }
+    ESP_LOGI(TAG, "✓ RMT RX capture running (one CPU wakeup per batch)");
   }
-  ESP_LOGI(TAG, "✓ Event callback registered (on_reach ISR, Core %d)", INTERRUPT_CPU_CORE);
 
   // ========================================
-  // Step 8: Enable and Start PCNT Unit
+  // Step 11: Worker Task (RMT refills, RX batch and ADC frame decoding, off the ISR)
   // ========================================
-  ESP_LOGI(TAG, "Step 8: Enabling and starting PCNT unit...");
-  
-  err = pcnt_unit_enable(this->pcnt_unit_);
-  if (err != ESP_OK) {
-    ESP_LOGE(TAG, "❌ Failed to enable PCNT unit: %s", esp_err_to_name(err));
-    this->mark_failed();
-    return;
+  if (window_output || this->edge_capture_mode_ == EDGE_CAPTURE_RMT || this->current_sense_pin_ != nullptr) {
+    ESP_LOGI(TAG, "Step 11: Starting worker task (Core %d, priority %d)...", WORKER_TASK_CORE, WORKER_TASK_PRIORITY);
+    BaseType_t created = xTaskCreatePinnedToCore(worker_task_loop_, "zcr_worker", WORKER_TASK_STACK_SIZE, this,
+                                                 WORKER_TASK_PRIORITY, &this->worker_task_handle_, WORKER_TASK_CORE);
+    if (created != pdPASS) {
+      ESP_LOGE(TAG, "❌ Failed to create worker task");
+      return false;
+    }
+    ESP_LOGI(TAG, "✓ Worker task started");
   }
-  
-  err = pcnt_unit_clear_count(this->pcnt_unit_);
-  if (err != ESP_OK) {
-    ESP_LOGE(TAG, "❌ Failed to clear PCNT count: %s", esp_err_to_name(err));
-    this->mark_failed();
-    return;
+  return true;
+}
+
+bool ZeroCrossRelayComponent::setup_fallback_() {
+  // ========================================
+  // Step 12: Timer-Only PWM Fallback (no zero-cross signal)
+  // ========================================
+  if (this->fallback_period_us_ == 0) {
+    return true;
+  }
+  if (this->output_mode_ != OUTPUT_MODE_GPTIMER) {
+    // RMT and MCPWM own the relay pin through the GPIO matrix; the fallback writes it as a plain GPIO
+    ESP_LOGW(TAG, "⚠️ Timer PWM fallback needs the GPTimer output stage; disabled");
+    this->fallback_period_us_ = 0;
+    return true;
   }
-  
-  err = pcnt_unit_start(this->pcnt_unit_);
+  ESP_LOGI(TAG, "Step 12: Creating fallback PWM timer (%u ms period, after %u ms without edges)...",
+           static_cast<uint32_t>(this->fallback_period_us_ / 1000U), this->fallback_timeout_ms_);
+  esp_timer_create_args_t timer_args = {};
+  timer_args.callback = fallback_timer_callback_;
+  timer_args.arg = this;
+  timer_args.dispatch_method = ESP_TIMER_TASK;
+  timer_args.name = "zcr_fallback";
+  esp_err_t err = esp_timer_create(&timer_args, &this->fallback_timer_);
   if (err != ESP_OK) {
-    ESP_LOGE(TAG, "❌ Failed to start PCNT unit: %s", esp_err_to_name(err));
-    this->mark_failed();
-    return;
+    ESP_LOGE(TAG, "❌ Failed to create fallback PWM timer: %s", esp_err_to_name(err));
+    return false;
   }
-  
-  ESP_LOGI(TAG, "✓ PCNT unit enabled and started (counting from 0)");
+  ESP_LOGI(TAG, "✓ Fallback PWM timer ready");
+  return true;
+}
 
+bool ZeroCrossRelayComponent::setup_mechanical_() {
   // ========================================
-  // Step 9: Create and Configure GPTimer for Delayed GPIO Control
+  // Step 13: Mechanical Relay (wear counter, contact feedback)
   // ========================================
-  ESP_LOGI(TAG, "Step 9: Creating GPTimer for %dus delay (Core %d, Priority %d)...", 
-           TIMER_DELAY_US, INTERRUPT_CPU_CORE, INTERRUPT_PRIORITY);
-  
-  gptimer_config_t timer_config = {
-      .clk_src = GPTIMER_CLK_SRC_DEFAULT,
-      .direction = GPTIMER_COUNT_UP,
-      .resolution_hz = TIMER_RESOLUTION_HZ,  // 1MHz = 1us per tick
-      .intr_priority = INTERRUPT_PRIORITY,   // 🔴 Highest priority (1-3 on ESP32)
-      .flags = {
-          .intr_shared = false,
-      },
-  };
-  
-  err = gptimer_new_timer(&timer_config, &this->delay_timer_);
-  if (err != ESP_OK) {
-    ESP_LOGE(TAG, "❌ Failed to create GPTimer: %s", esp_err_to_name(err));
-    this->mark_failed();
-    return;
+  if (!this->mechanical_) {
+    return true;
   }
-  
-  // Configure timer alarm (one-shot mode, will be restarted in PCNT ISR)
-  gptimer_alarm_config_t alarm_config = {
-      .alarm_count = TIMER_DELAY_US,  // Alarm at 2000us
-      .reload_count = 0,              // Reload to 0
-      .flags = {
-          .auto_reload_on_alarm = false,  // One-shot mode (manual restart)
-      },
+  ESP_LOGI(TAG, "Step 13: Mechanical relay (operate %u us, release %u us)...", static_cast<uint32_t>(this->operate_us_),
+           static_cast<uint32_t>(this->release_us_));
+  this->wear_pref_ = global_preferences->make_preference<uint32_t>(
+      fnv1_hash("zero_cross_relay_wear_" + std::to_string(this->relay_output_gpio_num_)));
+  if (!this->wear_pref_.load(&this->wear_base_)) {
+    this->wear_base_ = 0;
+  }
+  this->wear_save_ms_ = millis();
+
+  if (this->contact_feedback_pin_ != nullptr) {
+    this->contact_gpio_num_ = static_cast<gpio_num_t>(this->contact_feedback_pin_->get_pin());
+    this->contact_inverted_ = this->contact_feedback_pin_->is_inverted();
+    gpio_config_t feedback_config = {};
+    feedback_config.pin_bit_mask = (1ULL << this->contact_gpio_num_);
+    feedback_config.mode = GPIO_MODE_INPUT;
+    feedback_config.pull_up_en = GPIO_PULLUP_DISABLE;
+    feedback_config.pull_down_en = GPIO_PULLDOWN_DISABLE;
+    feedback_config.intr_type = GPIO_INTR_ANYEDGE;
+    esp_err_t err = gpio_config(&feedback_config);
+    if (err == ESP_OK) {
+      err = gpio_install_isr_service(ESP_INTR_FLAG_IRAM | (1 << INTERRUPT_PRIORITY));
+      if (err == ESP_ERR_INVALID_STATE) {
+        err = ESP_OK;  // Already installed by a detector or another component
+      }
+    }
+    if (err == ESP_OK) {
+      err = gpio_isr_handler_add(this->contact_gpio_num_, contact_feedback_isr_, this);
+    }
+    if (err != ESP_OK) {
+      ESP_LOGE(TAG, "❌ Failed to set up contact feedback on GPIO%d: %s", this->contact_gpio_num_,
+               esp_err_to_name(err));
+      return false;
+    }
+  }
+  ESP_LOGI(TAG, "✓ Mechanical relay ready (%u operations so far, %s)", this->wear_base_,
+           (this->contact_feedback_pin_ != nullptr) ? "learning from contact feedback" : "fixed timing");
+  return true;
+}
+
+void ZeroCrossRelayComponent::update_mechanical_() {
+  // Lead: enough whole half-cycles that the coil command comes after the edge that scheduled it
+  uint32_t half_us = this->measured_half_cycle_us_();
+  uint32_t slowest_us = (this->operate_us_ > this->release_us_) ? this->operate_us_ : this->release_us_;
+  uint32_t lead = (slowest_us + MECH_COMMAND_MARGIN_US + half_us - 1U) / half_us;
+  this->lead_half_cycles_ = (lead > 0) ? lead : 1U;
+
+  uint32_t count = this->switch_log_.count;
+  uint32_t now = millis();
+  if (count != this->wear_saved_ && now - this->wear_save_ms_ >= MECH_WEAR_SAVE_INTERVAL_MS) {
+    uint32_t total = this->wear_base_ + count;
+    this->wear_pref_.save(&total);
+    this->wear_saved_ = count;
+    this->wear_save_ms_ = now;
+  }
+}
+
+uint32_t ZeroCrossRelayComponent::mechanical_delay_us_(int level) const {
+  // Both levels share one lead so the on-time is preserved; contacts land on the true zero, which lies
+  // half a detector pulse after the rising edge
+  uint32_t land_us = this->measured_half_cycle_us_() * this->lead_half_cycles_ + this->period_tracker_.pulse_width_us / 2U;
+  uint32_t travel_us = level ? this->operate_us_ : this->release_us_;
+  return (land_us > travel_us) ? land_us - travel_us : 1U;
+}
+
+void IRAM_ATTR ZeroCrossRelayComponent::contact_feedback_isr_(void *arg) {
+  ZeroCrossRelayComponent *self = static_cast<ZeroCrossRelayComponent *>(arg);
+  uint32_t now = esp_timer_get_time();
+  uint32_t count = self->switch_log_.count;
+  if (count == self->contact_matched_count_) {
+    return;  // This operation is already timed; the rest is contact bounce
+  }
+  int closed = gpio_get_level(self->contact_gpio_num_) ^ (self->contact_inverted_ ? 1 : 0);
+  if (closed != self->switch_log_.level) {
+    return;
+  }
+  self->contact_matched_count_ = count;
+
+  uint32_t sample_us = now - self->switch_log_.time_us;
+  if (sample_us < MECH_MIN_OPERATE_US || sample_us > MECH_MAX_OPERATE_US) {
+    self->contact_reject_count_++;
+    return;
+  }
+  volatile uint32_t *learned = closed ? &self->operate_us_ : &self->release_us_;
+  int32_t delta = static_cast<int32_t>(sample_us) - static_cast<int32_t>(*learned);
+  *learned = static_cast<uint32_t>(static_cast<int32_t>(*learned) + (delta >> MECH_LEARN_SHIFT));
+  self->contact_learn_count_++;
+}
+
+bool ZeroCrossRelayComponent::setup_current_zero_() {
+  // ========================================
+  // Step 14: Current-Zero Input (zero-current turn-off)
+  // ========================================
+  if (this->current_zero_pin_ == nullptr) {
+    return true;
+  }
+  this->current_zero_gpio_num_ = static_cast<gpio_num_t>(this->current_zero_pin_->get_pin());
+  ESP_LOGI(TAG, "Step 14: Configuring current-zero input on GPIO%d (both edges)...", this->current_zero_gpio_num_);
+  this->isr_half_cycle_us_ = this->measured_half_cycle_us_();
+
+  gpio_config_t current_config = {};
+  current_config.pin_bit_mask = (1ULL << this->current_zero_gpio_num_);
+  current_config.mode = GPIO_MODE_INPUT;
+  current_config.pull_up_en = GPIO_PULLUP_DISABLE;
+  current_config.pull_down_en = GPIO_PULLDOWN_DISABLE;
+  current_config.intr_type = GPIO_INTR_ANYEDGE;
+  esp_err_t err = gpio_config(&current_config);
+  if (err == ESP_OK) {
+    err = gpio_install_isr_service(ESP_INTR_FLAG_IRAM | (1 << INTERRUPT_PRIORITY));
+    if (err == ESP_ERR_INVALID_STATE) {
+      err = ESP_OK;  // Already installed by a detector or another component
+    }
+  }
+  if (err == ESP_OK) {
+    err = gpio_isr_handler_add(this->current_zero_gpio_num_, current_zero_isr_, this);
+  }
+  if (err != ESP_OK) {
+    ESP_LOGE(TAG, "❌ Failed to set up current-zero input on GPIO%d: %s", this->current_zero_gpio_num_,
+             esp_err_to_name(err));
+    return false;
+  }
+  ESP_LOGI(TAG, "✓ Current-zero input ready (turn-off follows the measured lag after %d samples)",
+           CURRENT_LAG_LOCK_SAMPLES);
+  return true;
+}
+
+uint32_t ZeroCrossRelayComponent::turn_off_delay_us_() const {
+  if (this->current_lag_samples_ < CURRENT_LAG_LOCK_SAMPLES) {
+    return 0;
+  }
+  // The gate must stay on through the current zero that starts the last on half-cycle (or the triac stops a
+  // half-cycle early), then come off so the triac commutates at the following current zero
+  uint32_t half_us = this->measured_half_cycle_us_();
+  uint32_t delay_us = this->current_lag_us_ + ((half_us * CURRENT_ZERO_GUARD_Q16) >> 16);
+  return (delay_us > this->switch_delay_us_()) ? delay_us : 0;
+}
+
+void IRAM_ATTR ZeroCrossRelayComponent::current_zero_isr_(void *arg) {
+  ZeroCrossRelayComponent *self = static_cast<ZeroCrossRelayComponent *>(arg);
+  uint32_t now = esp_timer_get_time();
+  uint32_t half_us = self->isr_half_cycle_us_;
+  uint32_t boundary = self->zero_cross_timestamp_;
+  if (half_us == 0 || boundary == 0) {
+    return;
+  }
+  // Timestamping detectors give the voltage edge of this very half-cycle; PCNT leaves the boundary or segment edge
+  const volatile uint32_t *edge_time = self->edge_time_;
+  if (edge_time != nullptr && *edge_time != 0 && static_cast<int32_t>(now - *edge_time) >= 0) {
+    boundary = *edge_time;
+  }
+  // Comparator chatter around the zero: one current zero per quarter half-cycle at most
+  if (now - self->last_current_zero_us_ < (half_us >> 2)) {
+    return;
+  }
+  self->last_current_zero_us_ = now;
+
+  // The reference is a voltage zero-cross; later ones are whole half-cycles after it
+  uint32_t lag_us = (now - boundary) % half_us;
+  if (lag_us > ((half_us * CURRENT_LAG_MAX_Q16) >> 16)) {
+    self->current_lag_rejects_++;
+    return;
+  }
+  if (self->current_lag_samples_ == 0) {
+    self->current_lag_us_ = lag_us;
+  } else {
+    int32_t delta = static_cast<int32_t>(lag_us) - static_cast<int32_t>(self->current_lag_us_);
+    self->current_lag_us_ =
+        static_cast<uint32_t>(static_cast<int32_t>(self->current_lag_us_) + (delta >> CURRENT_LAG_FILTER_SHIFT));
+  }
+  self->current_lag_samples_++;
+}
+
+// Samples one input contributes to a half-cycle of this length
+static uint32_t expected_samples(uint32_t half_us) {
+  return static_cast<uint32_t>((static_cast<uint64_t>(half_us) * CURRENT_SAMPLE_RATE_HZ) / 1000000U);
+}
+
+void ZeroCrossRelayComponent::set_current_sense(InternalGPIOPin *pin, float amps_per_volt) {
+  this->current_sense_pin_ = pin;
+  this->current_amps_per_volt_ = amps_per_volt;
+}
+
+bool ZeroCrossRelayComponent::setup_current_sense_() {
+  // ========================================
+  // Step 15: Current Sense (continuous ADC DMA: this relay's current and voltage inputs)
+  // ========================================
+  if (this->current_sense_pin_ == nullptr) {
+    return true;
+  }
+#if SOC_ADC_DMA_SUPPORTED
+  if (adc_handle_ != nullptr) {
+    ESP_LOGE(TAG, "❌ The continuous ADC driver is already in use (one per chip)");
+    return false;
+  }
+  // One scan entry for the current input, one for the voltage input when metering
+  adc_digi_pattern_config_t patterns[2] = {};
+  size_t channels = 0;
+  bool metering = false;
+  for (int input = 0; input < 2; input++) {
+    InternalGPIOPin *pin = (input == 0) ? this->current_sense_pin_ : this->voltage_sense_pin_;
+    if (pin == nullptr) {
+      continue;
+    }
+    adc_unit_t unit;
+    adc_channel_t adc_channel;
+    esp_err_t err = adc_continuous_io_to_channel(pin->get_pin(), &unit, &adc_channel);
+    if (err != ESP_OK || unit != ADC_UNIT_1) {
+      ESP_LOGE(TAG, "❌ GPIO%d is not an ADC1 input (continuous mode samples ADC1 only)", pin->get_pin());
+      return false;
+    }
+    if (input == 1 && static_cast<int>(adc_channel) == this->current_adc_channel_) {
+      ESP_LOGE(TAG, "❌ voltage_pin GPIO%d is the current sense input", pin->get_pin());
+      return false;
+    }
+    (input == 0 ? this->current_adc_channel_ : this->voltage_adc_channel_) = static_cast<int>(adc_channel);
+    metering |= (input == 1);
+    patterns[channels].atten = CURRENT_ADC_ATTEN;
+    patterns[channels].channel = static_cast<uint8_t>(adc_channel);
+    patterns[channels].unit = static_cast<uint8_t>(unit);
+    patterns[channels].bit_width = SOC_ADC_DIGI_MAX_BITWIDTH;
+    channels++;
+  }
+  if (metering) {
+    build_sine_table_();
+  }
+  uint32_t sample_rate = CURRENT_SAMPLE_RATE_HZ * static_cast<uint32_t>(channels);
+  adc_result_interval_q8_ = static_cast<uint32_t>((1000000ULL << 8) / sample_rate);
+  ESP_LOGI(TAG, "Step 15: Starting continuous ADC DMA (%u inputs x %d Hz, %d results per frame%s)...",
+           static_cast<uint32_t>(channels), CURRENT_SAMPLE_RATE_HZ, static_cast<int>(ADC_FRAME_RESULTS),
+           metering ? ", P/Q metering" : "");
+
+  adc_continuous_handle_cfg_t handle_config = {};
+  handle_config.conv_frame_size = sizeof(adc_frame_);
+  handle_config.max_store_buf_size = sizeof(adc_frame_) * CURRENT_POOL_FRAMES;
+  esp_err_t err = adc_continuous_new_handle(&handle_config, &adc_handle_);
+  if (err == ESP_OK) {
+    adc_continuous_config_t adc_config = {};
+    adc_config.pattern_num = static_cast<uint32_t>(channels);
+    adc_config.adc_pattern = patterns;
+    adc_config.sample_freq_hz = sample_rate;
+    adc_config.conv_mode = ADC_CONV_SINGLE_UNIT_1;
+    adc_config.format = CURRENT_ADC_FORMAT;
+    err = adc_continuous_config(adc_handle_, &adc_config);
+  }
+  if (err == ESP_OK) {
+    adc_continuous_evt_cbs_t callbacks = {};
+    callbacks.on_conv_done = adc_conv_done_callback;
+    callbacks.on_pool_ovf = adc_pool_overflow_callback;
+    err = adc_continuous_register_event_callbacks(adc_handle_, &callbacks, this);
+  }
+  if (err == ESP_OK) {
+    err = adc_continuous_start(adc_handle_);
+  }
+  if (err != ESP_OK) {
+    ESP_LOGE(TAG, "❌ Failed to start continuous ADC: %s", esp_err_to_name(err));
+    return false;
+  }
+  ESP_LOGI(TAG, "✓ ADC DMA running (one worker wakeup per %u us, RMS per half-cycle)",
+           (adc_result_interval_q8_ * static_cast<uint32_t>(ADC_FRAME_RESULTS)) >> 8);
+  return true;
+#else
+  ESP_LOGW(TAG, "⚠️ This chip has no ADC DMA; current sensing disabled");
+  this->current_sense_pin_ = nullptr;
+  return true;
+#endif
+}
+
+#if SOC_ADC_DMA_SUPPORTED
+bool IRAM_ATTR ZeroCrossRelayComponent::adc_conv_done_callback(adc_continuous_handle_t handle,
+                                                               const adc_continuous_evt_data_t *edata,
+                                                               void *user_ctx) {
+  ZeroCrossRelayComponent *self = static_cast<ZeroCrossRelayComponent *>(user_ctx);
+  adc_frame_time_us_ = static_cast<uint32_t>(esp_timer_get_time());
+  adc_frames_done_++;
+  return self->notify_worker_from_isr_(WORKER_EVENT_ADC_FRAME);
+}
+
+bool IRAM_ATTR ZeroCrossRelayComponent::adc_pool_overflow_callback(adc_continuous_handle_t handle,
+                                                                   const adc_continuous_evt_data_t *edata,
+                                                                   void *user_ctx) {
+  // The done callback already counted this frame; the latest queued frame ended one frame earlier
+  adc_frames_done_--;
+  adc_frame_time_us_ -= (adc_result_interval_q8_ * static_cast<uint32_t>(ADC_FRAME_RESULTS)) >> 8;
+  adc_overflows_++;
+  return false;
+}
+#endif
+
+void ZeroCrossRelayComponent::read_adc_frames_() {
+#if SOC_ADC_DMA_SUPPORTED
+  uint32_t frame_us = (adc_result_interval_q8_ * static_cast<uint32_t>(ADC_FRAME_RESULTS)) >> 8;
+  while (true) {
+    // Frame counter and time must belong together (the ADC interrupt may run on the other core)
+    uint32_t done;
+    uint32_t latest_us;
+    do {
+      done = adc_frames_done_;
+      latest_us = adc_frame_time_us_;
+    } while (done != adc_frames_done_);
+    uint32_t pending = done - adc_frames_read_;
+    if (pending == 0) {
+      return;
+    }
+    if (pending > CURRENT_POOL_FRAMES) {
+      pending = CURRENT_POOL_FRAMES;  // The pool holds no more than this; older frames were never queued
+      adc_frames_read_ = done - pending;
+    }
+    uint32_t length = 0;
+    if (adc_continuous_read(adc_handle_, adc_frame_, sizeof(adc_frame_), &length, 0) != ESP_OK) {
+      return;
+    }
+    adc_frames_read_++;
+
+    // The oldest queued frame ended (pending - 1) frames before the latest one; conversions are evenly spaced
+    uint32_t results = length / SOC_ADC_DIGI_RESULT_BYTES;
+    uint32_t end_us = latest_us - (pending - 1U) * frame_us;
+    for (uint32_t i = 0; i < results; i++) {
+      const adc_digi_output_data_t *result =
+          reinterpret_cast<const adc_digi_output_data_t *>(&adc_frame_[i * SOC_ADC_DIGI_RESULT_BYTES]);
+      uint32_t time_us =
+          end_us - static_cast<uint32_t>((static_cast<uint64_t>(results - 1U - i) * adc_result_interval_q8_) >> 8);
+      int channel = CURRENT_ADC_CHANNEL(result);
+      if (channel == this->current_adc_channel_) {
+        this->add_current_sample_(CURRENT_ADC_DATA(result), time_us);
+      } else if (channel == this->voltage_adc_channel_) {
+        this->add_voltage_sample_(CURRENT_ADC_DATA(result), time_us);
+      }
+    }
+  }
+#endif
+}
+
+bool ZeroCrossRelayComponent::align_current_grid_(uint32_t time_us) {
+  uint32_t half_us = this->isr_half_cycle_us_;
+  uint32_t boundary = this->zero_cross_timestamp_;
+  if (half_us == 0 || boundary == 0) {
+    // No zero-cross timebase (startup, sync lost): nothing to segment against
+    this->current_samples_ = 0;
+    this->current_end_us_ = 0;
+    this->meter_cycle_start_us_ = 0;
+    return false;
+  }
+  if (boundary == this->current_zero_cross_seen_ && this->current_end_us_ != 0) {
+    return true;
+  }
+  // Voltage zero-crosses lie at boundary + k * half-cycle: close the open half-cycle at the first one after
+  // its start. Between boundaries (or long-window segment edges) the grid is extrapolated with the tracked period.
+  this->current_zero_cross_seen_ = boundary;
+  uint32_t start_us = (this->current_samples_ > 0) ? this->current_start_us_ : time_us;
+  int32_t since = static_cast<int32_t>(start_us - boundary) +
+                  static_cast<int32_t>((half_us * CURRENT_ALIGN_TOLERANCE_Q8) >> 8);
+  int32_t k = since / static_cast<int32_t>(half_us);
+  if (since < 0 && since % static_cast<int32_t>(half_us) != 0) {
+    k--;  // Floor division: the start may precede the boundary the worker has just seen
+  }
+  this->current_end_us_ = boundary + static_cast<uint32_t>((k + 1) * static_cast<int32_t>(half_us));
+  return true;
+}
+
+bool ZeroCrossRelayComponent::advance_current_grid_(uint32_t time_us) {
+  if (!this->align_current_grid_(time_us)) {
+    return false;
+  }
+  uint32_t half_us = this->isr_half_cycle_us_;
+  int32_t overdue_us = static_cast<int32_t>(time_us - this->current_end_us_);
+  if (overdue_us >= static_cast<int32_t>(half_us * CURRENT_MAX_GAP_HALF_CYCLES)) {
+    // Long gap in the stream (worker starved): the open half-cycle is incomplete, restart the grid here
+    this->current_partial_++;
+    this->current_samples_ = 0;
+    this->current_end_us_ = 0;
+    this->meter_cycle_start_us_ = 0;
+    this->align_current_grid_(time_us);
+  }
+  while (static_cast<int32_t>(time_us - this->current_end_us_) >= 0) {
+    this->finish_current_half_cycle_();
+    this->advance_meter_cycle_();
+    this->current_end_us_ += half_us;
+  }
+  return true;
+}
+
+void ZeroCrossRelayComponent::add_current_sample_(uint32_t raw, uint32_t time_us) {
+  if (!this->advance_current_grid_(time_us)) {
+    return;
+  }
+  if (this->current_samples_ == 0) {
+    this->current_start_us_ = time_us;
+    this->current_sum_ = 0;
+    this->current_sum_sq_ = 0;
+  }
+  this->current_sum_ += raw;
+  this->current_sum_sq_ += raw * raw;
+  this->current_samples_++;
+  if (this->voltage_sense_pin_ != nullptr) {
+    this->add_meter_sample_(&this->meter_current_, raw, time_us);
+  }
+}
+
+void ZeroCrossRelayComponent::add_voltage_sample_(uint32_t raw, uint32_t time_us) {
+  if (this->advance_current_grid_(time_us)) {
+    this->add_meter_sample_(&this->meter_voltage_, raw, time_us);
+  }
+}
+
+int ZeroCrossRelayComponent::conduction_at_(uint32_t time_us) const {
+  if (this->output_mode_ != OUTPUT_MODE_GPTIMER || this->fallback_active_) {
+    return -1;  // Only the GPTimer output logs its transitions; the fallback PWM writes the pin directly
+  }
+  int level = this->switch_log_.level;
+  uint32_t changed_us = this->switch_log_.time_us;
+  if (level < 0) {
+    return -1;
+  }
+  return (static_cast<int32_t>(time_us - changed_us) >= 0) ? level : 1 - level;
+}
+
+void ZeroCrossRelayComponent::finish_current_half_cycle_() {
+  uint32_t samples = this->current_samples_;
+  if (samples == 0) {
+    return;
+  }
+  this->current_samples_ = 0;
+  uint32_t half_us = this->isr_half_cycle_us_;
+  if (samples * 256U < expected_samples(half_us) * CURRENT_MIN_FILL_Q8) {
+    this->current_partial_++;  // Started mid half-cycle or lost frames
+    return;
+  }
+
+  float rms = ac_rms_counts(samples, this->current_sum_, this->current_sum_sq_) * CURRENT_VOLTS_PER_COUNT *
+              this->current_amps_per_volt_;
+  // Conduction at the middle of the half-cycle, from the last transition the output stage logged
+  int conduction = this->conduction_at_(this->current_end_us_ - (half_us >> 1));
+
+  this->current_rms_ = rms;
+  this->current_conduction_ = conduction;
+  if (conduction == 1 && rms > this->current_peak_rms_) {
+    this->current_peak_rms_ = rms;
+  }
+  if (this->thermal_enabled_) {
+    // SSR loss follows the current whatever the commanded level (a shorted SSR heats while "off")
+    this->thermal_sum_ma_ += static_cast<uint32_t>(rms * 1000.0f);
+    this->thermal_half_cycles_++;
+  }
+  if (conduction >= 0) {
+    volatile float *filtered = (conduction == 1) ? &this->current_rms_on_ : &this->current_rms_off_;
+    float previous = *filtered;
+    *filtered = (previous == 0.0f) ? rms : previous + (rms - previous) / (1 << CURRENT_FILTER_SHIFT);
+  }
+  this->current_half_cycles_++;
+}
+
+void ZeroCrossRelayComponent::build_sine_table_() {
+  const float two_pi = 2.0f * static_cast<float>(M_PI);
+  for (int i = 0; i < METER_TABLE_SIZE; i++) {
+    sine_q15_[i] = static_cast<int16_t>(lroundf(32767.0f * sinf(two_pi * i / METER_TABLE_SIZE)));
+  }
+}
+
+void ZeroCrossRelayComponent::add_meter_sample_(CycleSums *sums, uint32_t raw, uint32_t time_us) {
+  int32_t elapsed_us = static_cast<int32_t>(time_us - this->meter_cycle_start_us_);
+  if (this->meter_cycle_start_us_ == 0 || elapsed_us < 0) {
+    return;
+  }
+  // Phase of this sample's own timestamp: channels scanned microseconds apart keep their true angle
+  uint32_t index =
+      static_cast<uint32_t>((static_cast<uint64_t>(elapsed_us) * this->meter_phase_step_q16_) >> 16) &
+      (METER_TABLE_SIZE - 1);
+  int32_t centered = static_cast<int32_t>(raw) - sums->offset;
+  sums->cos_sum += centered * sine_q15_[(index + METER_TABLE_SIZE / 4) & (METER_TABLE_SIZE - 1)];
+  sums->sin_sum += centered * sine_q15_[index];
+  sums->sum += raw;
+  sums->sum_sq += raw * raw;
+  sums->samples++;
+}
+
+void ZeroCrossRelayComponent::advance_meter_cycle_() {
+  if (this->voltage_sense_pin_ == nullptr) {
+    return;
+  }
+  uint32_t zero_us = this->current_end_us_;
+  uint32_t half_us = this->isr_half_cycle_us_;
+  if (this->meter_cycle_start_us_ != 0) {
+    if (this->conduction_at_(zero_us - (half_us >> 1)) == 1) {
+      this->meter_on_halves_++;
+    }
+    if (++this->meter_half_cycles_ < 2) {
+      return;
+    }
+    this->finish_meter_cycle_();
+  }
+  // The next cycle opens at this zero-cross
+  this->meter_cycle_start_us_ = zero_us;
+  this->meter_phase_step_q16_ = static_cast<uint32_t>((static_cast<uint64_t>(METER_TABLE_SIZE) << 16) / (2U * half_us));
+  this->meter_half_cycles_ = 0;
+  this->meter_on_halves_ = 0;
+  this->meter_voltage_.restart();
+  this->meter_current_.restart();
+}
+
+void ZeroCrossRelayComponent::finish_meter_cycle_() {
+  CycleSums &voltage = this->meter_voltage_;
+  CycleSums &current = this->meter_current_;
+  uint32_t expected = 2U * expected_samples(this->isr_half_cycle_us_);
+  bool complete = voltage.samples * 256U >= expected * CURRENT_MIN_FILL_Q8 &&
+                  current.samples * 256U >= expected * CURRENT_MIN_FILL_Q8;
+  // Bias for the next cycle's products
+  if (voltage.samples > 0) {
+    voltage.offset = static_cast<int32_t>(voltage.sum / voltage.samples);
+  }
+  if (current.samples > 0) {
+    current.offset = static_cast<int32_t>(current.sum / current.samples);
+  }
+  if (!complete) {
+    this->meter_partial_++;
+    return;
+  }
+
+  // Fundamental phasors (peak): X = 2/n · Σ x · e^(−jθ). Mains voltage is close to a pure sine, so the
+  // fundamental's P is the true active power even when the current is distorted (phase cut).
+  float v_scale = CURRENT_VOLTS_PER_COUNT * this->voltage_volts_per_volt_;
+  float i_scale = CURRENT_VOLTS_PER_COUNT * this->current_amps_per_volt_;
+  float v_norm = 2.0f * v_scale / (32767.0f * static_cast<float>(voltage.samples));
+  float i_norm = 2.0f * i_scale / (32767.0f * static_cast<float>(current.samples));
+  float v_re = static_cast<float>(voltage.cos_sum) * v_norm;
+  float v_im = -static_cast<float>(voltage.sin_sum) * v_norm;
+  float i_re = static_cast<float>(current.cos_sum) * i_norm;
+  float i_im = -static_cast<float>(current.sin_sum) * i_norm;
+  float power = 0.5f * (v_re * i_re + v_im * i_im);
+  float reactive = 0.5f * (v_im * i_re - v_re * i_im);  // Positive when the current lags (inductive)
+
+  // Power factor against the true RMS values, so current distortion lowers it as well
+  float v_rms = ac_rms_counts(voltage.samples, voltage.sum, voltage.sum_sq) * v_scale;
+  float i_rms = ac_rms_counts(current.samples, current.sum, current.sum_sq) * i_scale;
+  this->meter_voltage_rms_ = v_rms;
+  if (i_rms * v_rms > 0.0f && this->meter_on_halves_ > 0) {
+    this->meter_pf_ = power / (v_rms * i_rms);
+  }
+  if (this->meter_on_halves_ == 2) {
+    // Full-on power of the load as it is now (element temperature, supply voltage)
+    float previous = this->meter_power_on_;
+    this->meter_power_on_ = (previous == 0.0f) ? power : previous + (power - previous) / (1 << CURRENT_FILTER_SHIFT);
+  }
+  portENTER_CRITICAL(&this->meter_lock_);
+  this->meter_power_sum_ += power;
+  this->meter_reactive_sum_ += reactive;
+  this->meter_sum_cycles_++;
+  portEXIT_CRITICAL(&this->meter_lock_);
+  this->meter_cycles_++;
+}
+
+void ZeroCrossRelayComponent::set_target_power(float watts) {
+  this->target_power_ = watts;
+  this->power_duty_percent_ = -1.0f;  // Apply at the next regulation step even if the duty happens to match
+  this->power_integral_percent_ = 0.0f;
+  if (watts >= 0.0f && this->rated_power_ <= 0.0f && this->voltage_sense_pin_ == nullptr) {
+    ESP_LOGW(TAG, "Power setpoint %.0f W ignored until a rated power or voltage metering is configured", watts);
+  }
+}
+
+void ZeroCrossRelayComponent::update_power_() {
+  uint32_t now = millis();
+  if (now - this->power_update_ms_ < POWER_UPDATE_INTERVAL_MS) {
+    return;
+  }
+  this->power_update_ms_ = now;
+
+  portENTER_CRITICAL(&this->meter_lock_);
+  float power_sum = this->meter_power_sum_;
+  float reactive_sum = this->meter_reactive_sum_;
+  uint32_t cycles = this->meter_sum_cycles_;
+  this->meter_power_sum_ = 0.0f;
+  this->meter_reactive_sum_ = 0.0f;
+  this->meter_sum_cycles_ = 0;
+  portEXIT_CRITICAL(&this->meter_lock_);
+  if (cycles > 0) {
+    this->power_avg_ = power_sum / static_cast<float>(cycles);
+    this->reactive_avg_ = reactive_sum / static_cast<float>(cycles);
+  }
+
+  if (this->target_power_ < 0.0f || this->load_detect_state_ != LOAD_DETECT_IDLE ||
+      this->output_fault_ != OUTPUT_FAULT_NONE) {
+    return;
+  }
+  // Measured full-on power once conducting cycles have been metered, the rated (modelled) power before that
+  float full_power = (this->meter_power_on_ > 0.0f) ? this->meter_power_on_ : this->rated_power_;
+  if (full_power <= 0.0f) {
+    return;
+  }
+  // Feed-forward from the full-on power, trimmed by the integral of the metered error. The trim removes what the
+  // linear model misses (phase-cut energy curve, full-on power drifting between conducting cycles).
+  float feed_forward = this->target_power_ / full_power * 100.0f;
+  float ceiling = fminf(100.0f, this->duty_limit_percent_);
+  if (cycles > 0 && this->power_duty_percent_ >= 0.0f) {
+    float error = (this->target_power_ - this->power_avg_) / full_power * 100.0f;
+    bool saturated = (error > 0.0f && this->power_duty_percent_ >= ceiling) ||
+                     (error < 0.0f && this->power_duty_percent_ <= 0.0f);
+    if (!saturated) {
+      // No windup while the duty cycle is pinned at 0%, 100% or the thermal ceiling
+      float integral = this->power_integral_percent_ + POWER_INTEGRAL_GAIN * error;
+      this->power_integral_percent_ =
+          fmaxf(-POWER_INTEGRAL_LIMIT_PERCENT, fminf(POWER_INTEGRAL_LIMIT_PERCENT, integral));
+    }
+  }
+  float percent = feed_forward + this->power_integral_percent_;
+  percent = (percent > ceiling) ? ceiling : ((percent < 0.0f) ? 0.0f : percent);
+  float change = percent - this->power_duty_percent_;
+  if (this->power_duty_percent_ >= 0.0f && change < POWER_DEADBAND_PERCENT && change > -POWER_DEADBAND_PERCENT) {
+    return;
+  }
+  this->power_duty_percent_ = percent;
+  this->set_duty_cycle_percent(percent);
+}
+
+bool ZeroCrossRelayComponent::setup_output_feedback_() {
+  // ========================================
+  // Step 16: Output Verification (feedback input, failsafe output)
+  // ========================================
+  if (this->feedback_pin_ == nullptr) {
+    return true;
+  }
+  if (this->output_mode_ != OUTPUT_MODE_GPTIMER) {
+    // Only the GPTimer alarm logs each transition with its time; RMT and MCPWM switch in hardware
+    ESP_LOGW(TAG, "⚠️ Output verification needs the GPTimer output stage; disabled");
+    this->feedback_pin_ = nullptr;
+    return true;
+  }
+  this->feedback_gpio_num_ = static_cast<gpio_num_t>(this->feedback_pin_->get_pin());
+  this->feedback_inverted_ = this->feedback_pin_->is_inverted();
+  ESP_LOGI(TAG, "Step 16: Output verification on GPIO%d (%s, trips after %u mismatches)...", this->feedback_gpio_num_,
+           (this->feedback_type_ == FEEDBACK_CURRENT) ? "current presence, PCNT edge count" : "level readback",
+           this->feedback_fault_threshold_);
+
+  esp_err_t err;
+  if (this->feedback_type_ == FEEDBACK_CURRENT) {
+    // Edges are counted in hardware: no interrupt per half-cycle, and the verdict does not depend on phase
+    pcnt_unit_config_t unit_config = {
+        .low_limit = PCNT_LOW_LIMIT,
+        .high_limit = FEEDBACK_PCNT_LIMIT,
+        .flags = {},
+    };
+    err = pcnt_new_unit(&unit_config, &this->feedback_unit_);
+    if (err == ESP_OK) {
+      pcnt_glitch_filter_config_t filter_config = {
+          .max_glitch_ns = PCNT_GLITCH_FILTER_NS,
+      };
+      err = pcnt_unit_set_glitch_filter(this->feedback_unit_, &filter_config);
+    }
+    if (err == ESP_OK) {
+      pcnt_chan_config_t channel_config = {
+          .edge_gpio_num = this->feedback_gpio_num_,
+          .level_gpio_num = -1,
+          .flags = {},
+      };
+      err = pcnt_new_channel(this->feedback_unit_, &channel_config, &this->feedback_channel_);
+    }
+    if (err == ESP_OK) {
+      err = pcnt_channel_set_edge_action(this->feedback_channel_, PCNT_CHANNEL_EDGE_ACTION_INCREASE,
+                                         PCNT_CHANNEL_EDGE_ACTION_INCREASE);
+    }
+    if (err == ESP_OK) {
+      err = pcnt_unit_enable(this->feedback_unit_);
+    }
+    if (err == ESP_OK) {
+      err = pcnt_unit_clear_count(this->feedback_unit_);
+    }
+    if (err == ESP_OK) {
+      err = pcnt_unit_start(this->feedback_unit_);
+    }
+  } else {
+    gpio_config_t feedback_config = {};
+    feedback_config.pin_bit_mask = (1ULL << this->feedback_gpio_num_);
+    feedback_config.mode = GPIO_MODE_INPUT;
+    feedback_config.pull_up_en = GPIO_PULLUP_DISABLE;
+    feedback_config.pull_down_en = GPIO_PULLDOWN_DISABLE;
+    feedback_config.intr_type = GPIO_INTR_DISABLE;
+    err = gpio_config(&feedback_config);
+  }
+  if (err != ESP_OK) {
+    ESP_LOGE(TAG, "❌ Failed to set up output feedback on GPIO%d: %s", this->feedback_gpio_num_, esp_err_to_name(err));
+    return false;
+  }
+
+  if (this->failsafe_pin_ != nullptr) {
+    this->failsafe_gpio_num_ = static_cast<gpio_num_t>(this->failsafe_pin_->get_pin());
+    gpio_config_t failsafe_config = {};
+    failsafe_config.pin_bit_mask = (1ULL << this->failsafe_gpio_num_);
+    failsafe_config.mode = GPIO_MODE_OUTPUT;
+    failsafe_config.pull_up_en = GPIO_PULLUP_DISABLE;
+    failsafe_config.pull_down_en = GPIO_PULLDOWN_DISABLE;
+    failsafe_config.intr_type = GPIO_INTR_DISABLE;
+    err = gpio_config(&failsafe_config);
+    if (err == ESP_OK) {
+      err = gpio_set_level(this->failsafe_gpio_num_, 1);
+    }
+    if (err != ESP_OK) {
+      ESP_LOGE(TAG, "❌ Failed to set up failsafe output on GPIO%d: %s", this->failsafe_gpio_num_,
+               esp_err_to_name(err));
+      return false;
+    }
+  }
+
+  esp_timer_create_args_t timer_args = {};
+  timer_args.callback = feedback_timer_callback_;
+  timer_args.arg = this;
+  timer_args.dispatch_method = ESP_TIMER_TASK;
+  timer_args.name = "zcr_feedback";
+  err = esp_timer_create(&timer_args, &this->feedback_timer_);
+  if (err == ESP_OK) {
+    err = esp_timer_start_periodic(this->feedback_timer_, FEEDBACK_SAMPLE_INTERVAL_US);
+  }
+  if (err != ESP_OK) {
+    ESP_LOGE(TAG, "❌ Failed to start output feedback sampling: %s", esp_err_to_name(err));
+    return false;
+  }
+  ESP_LOGI(TAG, "✓ Output verification running (sample every %d ms%s)", FEEDBACK_SAMPLE_INTERVAL_US / 1000,
+           (this->failsafe_pin_ != nullptr) ? ", failsafe output energised" : "");
+  return true;
+}
+
+void ZeroCrossRelayComponent::feedback_timer_callback_(void *arg) {
+  static_cast<ZeroCrossRelayComponent *>(arg)->sample_output_feedback_();
+}
+
+void ZeroCrossRelayComponent::sample_output_feedback_() {
+  uint32_t now = static_cast<uint32_t>(esp_timer_get_time());
+  uint32_t interval_start = this->feedback_last_us_;
+  this->feedback_last_us_ = now;
+
+  int observed;
+  if (this->feedback_type_ == FEEDBACK_CURRENT) {
+    // The interval spans over a mains cycle: any edge means current flowed in it
+    int edges = 0;
+    pcnt_unit_get_count(this->feedback_unit_, &edges);
+    pcnt_unit_clear_count(this->feedback_unit_);
+    observed = (edges > 0) ? 1 : 0;
+  } else {
+    observed = gpio_get_level(this->feedback_gpio_num_) ^ (this->feedback_inverted_ ? 1 : 0);
+  }
+
+  // No zero-cross edges in the interval (mains lost): an idle SSR would look open
+  int detector_edges = this->detector_count_();
+  uint32_t cycles = this->cycle_count_;
+  bool mains = (detector_edges != this->feedback_last_edges_ || cycles != this->feedback_last_cycles_);
+  this->feedback_last_edges_ = detector_edges;
+  this->feedback_last_cycles_ = cycles;
+  if (this->output_fault_ != OUTPUT_FAULT_NONE || interval_start == 0) {
+    return;
+  }
+
+  // Judge only a level that has settled: a zero-cross SSR follows its command at the next voltage zero, so
+  // current starts (or stops) up to a half-cycle later; mechanical contacts add their travel
+  uint32_t count = this->switch_log_.count;
+  int level = this->switch_log_.level;
+  uint32_t changed_us = this->switch_log_.time_us;
+  uint32_t settle_us = FEEDBACK_SETTLE_US + (this->mechanical_ ? MECH_MAX_OPERATE_US : 0U);
+  uint32_t judged_from = now;
+  if (this->feedback_type_ == FEEDBACK_CURRENT) {
+    settle_us += this->isr_half_cycle_us_;
+    judged_from = interval_start;
+  }
+  if (!mains || this->fallback_active_ || level < 0 || count != this->switch_log_.count ||
+      static_cast<int32_t>(judged_from - changed_us) < static_cast<int32_t>(settle_us)) {
+    this->feedback_skipped_++;
+    return;
+  }
+
+  this->feedback_samples_++;
+  if (observed == level) {
+    this->feedback_mismatch_run_ = 0;
+    return;
+  }
+  this->feedback_mismatches_++;
+  if (++this->feedback_mismatch_run_ < this->feedback_fault_threshold_) {
+    return;
+  }
+  // A shorted SSR cannot be switched off: the series contactor drops here, the relay is commanded off by loop()
+  if (this->failsafe_gpio_num_ != GPIO_NUM_NC) {
+    gpio_set_level(this->failsafe_gpio_num_, 0);
+  }
+  this->output_fault_ = level ? OUTPUT_FAULT_OPEN : OUTPUT_FAULT_STUCK_ON;
+  this->output_fault_event_ = true;
+}
+
+void ZeroCrossRelayComponent::trip_output_failsafe_() {
+  bool stuck_on = (this->output_fault_ == OUTPUT_FAULT_STUCK_ON);
+  ESP_LOGE(TAG, "❌ Output fault: %s (%u samples in a row disagreed with the commanded level)",
+           stuck_on ? "relay stuck ON while commanded off" : "no output while commanded on (SSR or load open)",
+           this->feedback_fault_threshold_);
+  ESP_LOGE(TAG, "   Relay commanded off%s; setpoints are ignored until clear_output_fault()",
+           (this->failsafe_gpio_num_ != GPIO_NUM_NC) ? ", failsafe output released" : "");
+  this->load_detect_state_ = LOAD_DETECT_IDLE;
+  this->ramp_target_percent_ = -1.0f;
+  this->apply_duty_percent_(0.0f);
+}
+
+void ZeroCrossRelayComponent::clear_output_fault() {
+  if (this->output_fault_ == OUTPUT_FAULT_NONE) {
+    return;
+  }
+  this->feedback_mismatch_run_ = 0;
+  this->output_fault_ = OUTPUT_FAULT_NONE;
+  if (this->failsafe_gpio_num_ != GPIO_NUM_NC) {
+    gpio_set_level(this->failsafe_gpio_num_, 1);
+  }
+  ESP_LOGI(TAG, "Output fault cleared; setpoints accepted again (relay stays off until the next one)");
+}
+
+bool ZeroCrossRelayComponent::output_fault_blocks_(bool on) const {
+  if (!on) {
+    return false;
+  }
+  if (this->output_fault_ != OUTPUT_FAULT_NONE) {
+    ESP_LOGW(TAG, "Output fault latched; setpoint ignored until clear_output_fault()");
+    return true;
+  }
+  if (this->watchdog_trip_ != WATCHDOG_OK) {
+    ESP_LOGW(TAG, "Duty watchdog tripped; setpoint ignored until clear_watchdog()");
+    return true;
+  }
+  return false;
+}
+
+void ZeroCrossRelayComponent::set_watchdog(uint32_t max_on_ms, uint32_t min_off_ms, float max_average_percent,
+                                           uint32_t average_window_ms, float safe_percent) {
+  // 1.024 ms ticks keep day-long limits in 32 bits and the ISR free of 64-bit division
+  this->watchdog_enabled_ = true;
+  this->watchdog_max_on_ticks_ = static_cast<uint32_t>(static_cast<uint64_t>(max_on_ms) * 1000U >> 10);
+  this->watchdog_min_off_ticks_ = static_cast<uint32_t>(static_cast<uint64_t>(min_off_ms) * 1000U >> 10);
+  this->watchdog_max_average_q16_ = static_cast<int32_t>(max_average_percent / 100.0f * 65536.0f);
+  uint32_t average_ticks = static_cast<uint32_t>(static_cast<uint64_t>(average_window_ms) * 1000U >> 10);
+  this->watchdog_average_ticks_ = (average_ticks > 0) ? average_ticks : 1U;
+  this->watchdog_average_recip_q32_ = static_cast<uint32_t>(4294967296.0 / this->watchdog_average_ticks_);
+  this->watchdog_safe_percent_ = safe_percent;
+}
+
+bool ZeroCrossRelayComponent::setup_watchdog_() {
+  // ========================================
+  // Step 18: Duty Watchdog (limits enforced at the window boundary)
+  // ========================================
+  if (!this->watchdog_enabled_) {
+    return true;
+  }
+  if (this->output_mode_ == OUTPUT_MODE_MCPWM) {
+    // Comparators are reloaded from task context; the boundary ISR cannot force them
+    ESP_LOGW(TAG, "⚠️ Duty watchdog needs the GPTimer or RMT output stage; disabled");
+    this->watchdog_enabled_ = false;
+    return true;
+  }
+  ESP_LOGI(TAG, "Step 18: Duty watchdog (safe duty %.0f%% while tripped)...", this->watchdog_safe_percent_);
+  this->watchdog_safe_flip_point_ = static_cast<int>(this->watchdog_safe_percent_ / 100.0f * PCNT_HIGH_LIMIT + 0.5f);
+  this->watchdog_safe_window_on_ = static_cast<uint32_t>(
+      this->watchdog_safe_percent_ / 100.0f * static_cast<float>(this->window_half_cycles_()) + 0.5f);
+  if (this->modulation_mode_ == MODULATION_PATTERN) {
+    this->watchdog_safe_pattern_ = this->pattern_for_flip_point_(this->watchdog_safe_flip_point_);
+  }
+  // Boot counts as a long rest: the first burst is not held back by the minimum off-time
+  uint32_t now = static_cast<uint32_t>(esp_timer_get_time() >> 10);
+  this->watchdog_off_start_ = now - this->watchdog_min_off_ticks_;
+  this->watchdog_last_ = now;
+  ESP_LOGI(TAG, "✓ Duty watchdog armed (max on %u s, min off %u s, max average %.0f%%)",
+           static_cast<uint32_t>((static_cast<uint64_t>(this->watchdog_max_on_ticks_) << 10) / 1000000U),
+           static_cast<uint32_t>((static_cast<uint64_t>(this->watchdog_min_off_ticks_) << 10) / 1000000U),
+           static_cast<float>(this->watchdog_max_average_q16_) * 100.0f / 65536.0f);
+  return true;
+}
+
+void ZeroCrossRelayComponent::clear_watchdog() {
+  if (this->watchdog_trip_ == WATCHDOG_OK) {
+    return;
+  }
+  this->watchdog_trip_ = WATCHDOG_OK;
+  ESP_LOGI(TAG, "Duty watchdog cleared; setpoints accepted again (safe duty holds until the next one)");
+}
+
+bool IRAM_ATTR ZeroCrossRelayComponent::watchdog_check_(uint32_t on, uint32_t length) {
+  uint32_t now = static_cast<uint32_t>(esp_timer_get_time() >> 10);
+  // Bring the rolling average up to now at the previous block's duty; this also spans idle gaps at 0%
+  uint32_t elapsed = now - this->watchdog_last_;
+  if (elapsed > this->watchdog_average_ticks_) {
+    elapsed = this->watchdog_average_ticks_;
+  }
+  int32_t weight_q16 = static_cast<int32_t>((static_cast<uint64_t>(elapsed) * this->watchdog_average_recip_q32_) >> 16);
+  this->watchdog_average_q16_ += static_cast<int32_t>(
+      (static_cast<int64_t>(this->watchdog_block_duty_q16_ - this->watchdog_average_q16_) * weight_q16) >> 16);
+  this->watchdog_last_ = now;
+
+  if (this->watchdog_trip_ != WATCHDOG_OK) {
+    return true;
+  }
+  if (on == 0) {
+    return false;
+  }
+  uint32_t half_us = this->isr_half_cycle_us_;
+  uint32_t on_ticks = (on * half_us) >> 10;
+  WatchdogTrip trip = WATCHDOG_OK;
+  if (this->watchdog_max_on_ticks_ > 0) {
+    uint32_t run_start = this->watchdog_ends_on_ ? this->watchdog_on_start_ : now;
+    if (now - run_start + on_ticks > this->watchdog_max_on_ticks_) {
+      trip = WATCHDOG_MAX_ON;
+    }
+  }
+  if (this->watchdog_min_off_ticks_ > 0 && !this->watchdog_ends_on_ &&
+      now - this->watchdog_off_start_ < this->watchdog_min_off_ticks_) {
+    trip = WATCHDOG_MIN_OFF;
+  }
+  if (this->watchdog_max_average_q16_ < 65536) {
+    uint32_t block_ticks = (length * half_us) >> 10;
+    if (block_ticks > this->watchdog_average_ticks_) {
+      block_ticks = this->watchdog_average_ticks_;
+    }
+    int32_t block_weight_q16 =
+        static_cast<int32_t>((static_cast<uint64_t>(block_ticks) * this->watchdog_average_recip_q32_) >> 16);
+    int32_t duty_q16 = static_cast<int32_t>((on << 16) / length);
+    int32_t predicted = this->watchdog_average_q16_ + static_cast<int32_t>(
+        (static_cast<int64_t>(duty_q16 - this->watchdog_average_q16_) * block_weight_q16) >> 16);
+    if (predicted > this->watchdog_max_average_q16_) {
+      trip = WATCHDOG_AVERAGE;
+    }
+  }
+  if (trip == WATCHDOG_OK) {
+    return false;
+  }
+  this->watchdog_trip_ = trip;
+  this->watchdog_trips_++;
+  this->watchdog_event_ = true;
+  return true;
+}
+
+void IRAM_ATTR ZeroCrossRelayComponent::watchdog_account_(uint32_t on, uint32_t length) {
+  uint32_t now = this->watchdog_last_;
+  if (on == 0) {
+    if (this->watchdog_ends_on_) {
+      this->watchdog_off_start_ = now;
+    }
+    this->watchdog_ends_on_ = false;
+  } else {
+    if (!this->watchdog_ends_on_) {
+      this->watchdog_on_start_ = now;
+    }
+    this->watchdog_ends_on_ = (on >= length);
+    if (!this->watchdog_ends_on_) {
+      this->watchdog_off_start_ = now + ((on * this->isr_half_cycle_us_) >> 10);
+    }
+  }
+  this->watchdog_block_duty_q16_ = static_cast<int32_t>((on << 16) / length);
+}
+
+void ZeroCrossRelayComponent::set_thermal_model(float on_voltage, float junction_resistance, float heatsink_resistance,
+                                                float junction_tau, float heatsink_tau) {
+  const float step_s = THERMAL_STEP_MS / 1000.0f;
+  this->thermal_enabled_ = true;
+  this->thermal_on_mv_ = static_cast<uint32_t>(on_voltage * 1000.0f + 0.5f);
+  this->thermal_r_jh_q8_ = static_cast<uint32_t>(junction_resistance * 256.0f + 0.5f);
+  this->thermal_r_ratio_q8_ = static_cast<uint32_t>(heatsink_resistance / junction_resistance * 256.0f + 0.5f);
+  // Forward Euler stays stable while the step is no longer than the time constant
+  this->thermal_a_j_q16_ = static_cast<uint32_t>(fminf(step_s / junction_tau, 1.0f) * 65536.0f);
+  this->thermal_a_h_q16_ = static_cast<uint32_t>(fminf(step_s / heatsink_tau, 1.0f) * 65536.0f);
+}
+
+float ZeroCrossRelayComponent::get_junction_temperature() const {
+  return this->thermal_enabled_ ? static_cast<float>(this->thermal_junction_q8_) / 256.0f : NAN;
+}
+
+float ZeroCrossRelayComponent::get_heatsink_temperature() const {
+  return this->thermal_enabled_ ? static_cast<float>(this->thermal_heatsink_q8_) / 256.0f : NAN;
+}
+
+bool ZeroCrossRelayComponent::setup_thermal_() {
+  // ========================================
+  // Step 17: SSR Thermal Model (ambient source)
+  // ========================================
+  if (!this->thermal_enabled_) {
+    return true;
+  }
+  ESP_LOGI(TAG, "Step 17: SSR thermal model (derating %.0f°C to %.0f°C junction)...",
+           static_cast<float>(this->thermal_derate_start_q8_) / 256.0f, static_cast<float>(this->thermal_max_q8_) / 256.0f);
+  if (this->current_sense_pin_ == nullptr && this->thermal_rated_ma_ == 0) {
+    ESP_LOGE(TAG, "❌ Thermal model needs current_sense or a rated current");
+    return false;
+  }
+#if SOC_TEMP_SENSOR_SUPPORTED
+  if (this->thermal_chip_ambient_ && chip_sensor_ == nullptr) {
+    temperature_sensor_config_t sensor_config = TEMPERATURE_SENSOR_CONFIG_DEFAULT(THERMAL_CHIP_MIN_C, THERMAL_CHIP_MAX_C);
+    esp_err_t err = temperature_sensor_install(&sensor_config, &chip_sensor_);
+    if (err == ESP_OK) {
+      err = temperature_sensor_enable(chip_sensor_);
+    }
+    if (err != ESP_OK) {
+      // Usually another component owns the single sensor instance
+      ESP_LOGW(TAG, "⚠️ Chip temperature sensor unavailable (%s); fixed ambient %.0f°C", esp_err_to_name(err),
+               static_cast<float>(this->thermal_ambient_q8_) / 256.0f);
+      chip_sensor_ = nullptr;
+      this->thermal_chip_ambient_ = false;
+    }
+  }
+#else
+  if (this->thermal_chip_ambient_) {
+    ESP_LOGW(TAG, "⚠️ No chip temperature sensor on this target; fixed ambient %.0f°C",
+             static_cast<float>(this->thermal_ambient_q8_) / 256.0f);
+    this->thermal_chip_ambient_ = false;
+  }
+#endif
+  ESP_LOGI(TAG, "✓ Thermal model ready (loss from %s, ambient %s)",
+           (this->current_sense_pin_ != nullptr) ? "measured half-cycle current" : "rated current x commanded duty",
+           this->thermal_chip_ambient_ ? "chip sensor" : "fixed");
+  return true;
+}
+
+void ZeroCrossRelayComponent::update_thermal_() {
+  if (!this->thermal_enabled_) {
+    return;
+  }
+#if SOC_TEMP_SENSOR_SUPPORTED
+  if (this->thermal_chip_ambient_) {
+    float celsius;
+    if (temperature_sensor_get_celsius(chip_sensor_, &celsius) == ESP_OK) {
+      this->thermal_ambient_q8_ = static_cast<int32_t>(celsius * 256.0f);
+    }
+  }
+#endif
+  uint32_t now = millis();
+  if (this->thermal_step_ms_ == 0) {
+    // Cold start: the SSR sits at ambient
+    this->thermal_junction_q8_ = this->thermal_ambient_q8_;
+    this->thermal_heatsink_q8_ = this->thermal_ambient_q8_;
+    this->thermal_sum_ma_seen_ = this->thermal_sum_ma_;
+    this->thermal_half_cycles_seen_ = this->thermal_half_cycles_;
+    this->thermal_step_ms_ = now;
+    return;
+  }
+  if (now - this->thermal_step_ms_ < THERMAL_STEP_MS) {
+    return;
+  }
+  // Fixed steps keep the coefficients exact; a stalled loop catches up one step per call, or resyncs
+  this->thermal_step_ms_ += THERMAL_STEP_MS;
+  if (now - this->thermal_step_ms_ > THERMAL_MAX_LAG_MS) {
+    this->thermal_step_ms_ = now;
+  }
+
+  // Mean load current over the step: measured half-cycles, or the rated current times the commanded on-fraction
+  // (time proportioning windows outlast the junction stage, so its present level counts there)
+  uint32_t mean_ma;
+  if (this->current_sense_pin_ != nullptr) {
+    uint32_t sum_ma = this->thermal_sum_ma_;
+    uint32_t half_cycles = this->thermal_half_cycles_;
+    uint32_t new_half_cycles = half_cycles - this->thermal_half_cycles_seen_;
+    mean_ma = (new_half_cycles > 0) ? (sum_ma - this->thermal_sum_ma_seen_) / new_half_cycles : this->thermal_mean_ma_;
+    this->thermal_sum_ma_seen_ = sum_ma;
+    this->thermal_half_cycles_seen_ = half_cycles;
+  } else if (this->modulation_mode_ == MODULATION_TIME_PROPORTIONING && !this->fallback_active_) {
+    mean_ma = (this->switch_log_.level == 1) ? this->thermal_rated_ma_ : 0U;
+  } else {
+    mean_ma = static_cast<uint32_t>(static_cast<float>(this->thermal_rated_ma_) * this->get_duty_cycle_percentage() /
+                                    100.0f);
+  }
+  this->thermal_mean_ma_ = mean_ma;
+
+  // Conduction loss: on-state drop times the mean rectified current (0.9 x RMS for a sine); mV x mA = uW
+  uint64_t loss_mw = static_cast<uint64_t>(this->thermal_on_mv_) * mean_ma * 9U / 10000U;
+  int32_t rise_q8 = static_cast<int32_t>(loss_mw * this->thermal_r_jh_q8_ / 1000U);
+  int32_t junction = this->thermal_junction_q8_;
+  int32_t heatsink = this->thermal_heatsink_q8_;
+  // Junction settles at heatsink + loss x R_jh; the heatsink at ambient + the flow through R_jh x R_ha
+  junction += static_cast<int32_t>((static_cast<int64_t>(this->thermal_a_j_q16_) * (heatsink + rise_q8 - junction)) >> 16);
+  int32_t flow_q8 = static_cast<int32_t>((static_cast<int64_t>(junction - heatsink) * this->thermal_r_ratio_q8_) >> 8);
+  heatsink += static_cast<int32_t>(
+      (static_cast<int64_t>(this->thermal_a_h_q16_) * (this->thermal_ambient_q8_ + flow_q8 - heatsink)) >> 16);
+  this->thermal_junction_q8_ = junction;
+  this->thermal_heatsink_q8_ = heatsink;
+
+  // Ceiling falls linearly from 100% at the derating start to 0% at the limit, in whole steps. It rises again
+  // only one step above the current ceiling: the junction stage answers within seconds and would hunt otherwise.
+  float raw = 100.0f;
+  if (junction >= this->thermal_max_q8_) {
+    raw = 0.0f;
+  } else if (junction > this->thermal_derate_start_q8_) {
+    raw = 100.0f * static_cast<float>(this->thermal_max_q8_ - junction) /
+          static_cast<float>(this->thermal_max_q8_ - this->thermal_derate_start_q8_);
+  }
+  float limit = this->duty_limit_percent_;
+  if (raw < limit || raw >= limit + 2.0f * THERMAL_LIMIT_STEP_PERCENT || raw >= 100.0f) {
+    limit = fminf(floorf(raw / THERMAL_LIMIT_STEP_PERCENT) * THERMAL_LIMIT_STEP_PERCENT, 100.0f);
+  }
+  if (limit == this->duty_limit_percent_) {
+    return;
+  }
+  if (limit < this->duty_limit_percent_) {
+    ESP_LOGW(TAG, "⚠️ SSR junction %.1f°C (heatsink %.1f°C): duty cycle limited to %.0f%%",
+             static_cast<float>(junction) / 256.0f, static_cast<float>(heatsink) / 256.0f, limit);
+  } else {
+    ESP_LOGI(TAG, "SSR junction %.1f°C: duty cycle limit raised to %.0f%%", static_cast<float>(junction) / 256.0f, limit);
+  }
+  bool was_limited = this->requested_percent_ > this->duty_limit_percent_;
+  this->duty_limit_percent_ = limit;
+  if ((was_limited || this->requested_percent_ > limit) && this->load_detect_state_ == LOAD_DETECT_IDLE &&
+      this->output_fault_ == OUTPUT_FAULT_NONE) {
+    // Reapply the request under the new ceiling (rises follow the ramp)
+    this->set_duty_cycle_percent(this->requested_percent_);
+  }
+}
+
+void ZeroCrossRelayComponent::update_ramp_() {
+  if (this->ramp_target_percent_ < 0.0f || this->load_detect_state_ != LOAD_DETECT_IDLE) {
+    return;
+  }
+  uint32_t now = millis();
+  if (now - this->ramp_step_ms_ < RAMP_STEP_MS) {
+    return;
+  }
+  this->ramp_step_ms_ = now;
+  float next = this->ramp_percent_ + this->ramp_rate_ * (RAMP_STEP_MS / 1000.0f);
+  if (next >= this->ramp_target_percent_) {
+    next = this->ramp_target_percent_;
+    this->ramp_target_percent_ = -1.0f;
+  }
+  this->apply_duty_percent_(next);
+}
+
+const char *ZeroCrossRelayComponent::load_type_name(LoadType type) {
+  switch (type) {
+    case LOAD_TYPE_RESISTIVE:
+      return "resistive";
+    case LOAD_TYPE_INDUCTIVE:
+      return "inductive";
+    case LOAD_TYPE_LAMP:
+      return "lamp";
+    case LOAD_TYPE_CAPACITIVE:
+      return "capacitive";
+    default:
+      return "unknown";
+  }
+}
+
+void ZeroCrossRelayComponent::restore_load_profile_() {
+  this->load_pref_ = global_preferences->make_preference<LoadProfile>(
+      fnv1_hash("zero_cross_relay_load_" + std::to_string(this->relay_output_pin_->get_pin())));
+  if (this->load_detection_auto_) {
+    LoadProfile stored;
+    if (!this->load_pref_.load(&stored) || stored.type == LOAD_TYPE_UNKNOWN) {
+      ESP_LOGI(TAG, "   • No load profile stored; commissioning runs %d s after boot", LOAD_AUTO_DELAY_MS / 1000);
+      return;
+    }
+    this->load_profile_ = stored;
+    this->load_profile_stored_ = true;
+    ESP_LOGI(TAG, "   • Load profile restored: %s (inrush %.1fx, lag %.1f°, sag %.1fx)",
+             load_type_name(this->get_load_type()), stored.inrush_ratio, stored.lag_degrees, stored.sag_ratio);
+  }
+  this->apply_load_defaults_(true);
+}
+
+void ZeroCrossRelayComponent::apply_load_defaults_(bool at_boot) {
+  static const char *const MODE_NAMES[] = {"flip_point", "pattern", "time_proportioning", "hybrid"};
+  LoadType type = this->get_load_type();
+  float ramp = 0.0f;
+  ModulationMode mode = this->modulation_mode_;
+  if (type == LOAD_TYPE_LAMP) {
+    ramp = LOAD_LAMP_RAMP_RATE;
+  } else if (type == LOAD_TYPE_INDUCTIVE) {
+    // Every switch-on risks transformer inrush, and half-cycle patterns leave a DC bias: few, long on-periods
+    ramp = LOAD_INDUCTIVE_RAMP_RATE;
+    if (this->output_mode_ == OUTPUT_MODE_GPTIMER) {
+      mode = MODULATION_TIME_PROPORTIONING;
+    }
+  } else if (type == LOAD_TYPE_CAPACITIVE && mode == MODULATION_HYBRID) {
+    mode = MODULATION_FLIP_POINT;  // A phase cut charges the capacitor from the crest: current spike
+  }
+  if (ramp > this->ramp_rate_) {
+    this->ramp_rate_ = ramp;
+  }
+  if (mode == this->modulation_mode_) {
+    return;
+  }
+  if (this->modulation_mode_configured_ || this->immediate_apply_) {
+    // The YAML validated its options (immediate_apply included) against this mode; never switch underneath them
+    ESP_LOGW(TAG, "%s load: modulation mode %s recommended, configured %s kept", load_type_name(type),
+             MODE_NAMES[mode], MODE_NAMES[this->modulation_mode_]);
+  } else if (at_boot) {
+    ESP_LOGI(TAG, "   • %s load: modulation mode %s instead of %s", load_type_name(type), MODE_NAMES[mode],
+             MODE_NAMES[this->modulation_mode_]);
+    this->modulation_mode_ = mode;
+  } else {
+    ESP_LOGW(TAG, "%s load: modulation mode %s recommended, applied after a restart", load_type_name(type),
+             MODE_NAMES[mode]);
+  }
+}
+
+void ZeroCrossRelayComponent::start_load_detection() {
+  if (!this->initialized_ || this->output_mode_ != OUTPUT_MODE_GPTIMER) {
+    ESP_LOGW(TAG, "Load detection needs a running GPTimer output stage (the test is timed from its transitions)");
+    return;
+  }
+  if (this->load_detect_state_ != LOAD_DETECT_IDLE) {
+    return;
+  }
+  if (this->fallback_active_) {
+    ESP_LOGW(TAG, "Load detection needs zero-cross sync; not started");
+    return;
+  }
+  // The test drives the relay through apply_duty_percent_(); requested_percent_ keeps the setpoint to restore,
+  // including one set by either API while the test runs
+  this->ramp_target_percent_ = -1.0f;
+  ESP_LOGI(TAG, "🔍 Load detection: relay off for %d ms, then full on for %d ms...", LOAD_OFF_MS, LOAD_STEADY_MS);
+  this->apply_duty_percent_(0.0f);
+  this->load_detect_state_ = LOAD_DETECT_OFF;
+  this->load_detect_ms_ = millis();
+}
+
+void ZeroCrossRelayComponent::update_load_detection_() {
+  if (this->load_detect_state_ == LOAD_DETECT_IDLE) {
+    if (this->load_detection_auto_ && !this->load_profile_stored_ && !this->load_auto_tried_ && this->initialized_ &&
+        millis() > LOAD_AUTO_DELAY_MS) {
+      this->load_auto_tried_ = true;
+      this->start_load_detection();
+    }
+    return;
+  }
+
+  // Setpoints reach the relay at the next window boundary: allow one window plus a margin
+  uint32_t elapsed_ms = millis() - this->load_detect_ms_;
+  uint32_t timeout_ms = static_cast<uint32_t>(this->window_half_cycles_()) * this->measured_half_cycle_us_() / 1000U +
+                        LOAD_SWITCH_TIMEOUT_MS;
+  int level = this->switch_log_.level;
+  uint32_t since_change_ms = (static_cast<uint32_t>(esp_timer_get_time()) - this->switch_log_.time_us) / 1000U;
+  uint32_t pulse_us = this->period_tracker_.pulse_width_us;
+
+  if (this->load_detect_state_ == LOAD_DETECT_OFF) {
+    if (level != 0) {
+      if (elapsed_ms > timeout_ms) {
+        this->abort_load_detection_("relay did not switch off");
+      }
+      return;
+    }
+    if (since_change_ms < LOAD_OFF_MS) {
+      return;
+    }
+    // Baseline with the load off, then the test switch-on
+    this->load_base_pulse_us_ = pulse_us;
+    this->load_peak_sag_us_ = 0;
+    this->load_lag_samples_base_ = this->current_lag_samples_;
+    this->load_lag_rejects_base_ = this->current_lag_rejects_;
+    this->current_peak_rms_ = 0.0f;
+    this->apply_duty_percent_(100.0f);
+    this->load_detect_state_ = LOAD_DETECT_INRUSH;
+    this->load_detect_ms_ = millis();
+    return;
+  }
+
+  if (level != 1) {
+    if (this->load_detect_state_ == LOAD_DETECT_STEADY) {
+      this->abort_load_detection_("relay switched off during the test");
+    } else if (elapsed_ms > timeout_ms) {
+      this->abort_load_detection_("relay did not switch on");
+    }
+    return;
+  }
+  if (this->load_detect_state_ == LOAD_DETECT_INRUSH) {
+    if (since_change_ms < LOAD_INRUSH_MS) {
+      // The supply sags most while the inrush lasts; a sagging supply widens the detector pulse
+      if (this->load_base_pulse_us_ > 0 && pulse_us > this->load_base_pulse_us_ + this->load_peak_sag_us_) {
+        this->load_peak_sag_us_ = pulse_us - this->load_base_pulse_us_;
+      }
+      return;
+    }
+    this->load_inrush_rms_ = this->current_peak_rms_;
+    this->load_detect_state_ = LOAD_DETECT_STEADY;
+    return;
+  }
+  if (since_change_ms >= LOAD_STEADY_MS) {
+    this->finish_load_detection_();
+  }
+}
+
+void ZeroCrossRelayComponent::abort_load_detection_(const char *reason) {
+  ESP_LOGW(TAG, "⚠️ Load detection aborted: %s", reason);
+  this->load_detect_state_ = LOAD_DETECT_IDLE;
+  this->set_duty_cycle_percent(this->requested_percent_);
+}
+
+void ZeroCrossRelayComponent::finish_load_detection_() {
+  LoadProfile profile;
+
+  // Inrush from the current transformer; the detector pulse widening is the fallback (the supply sags with current)
+  float steady_rms = this->current_rms_on_;
+  if (this->current_sense_pin_ != nullptr && steady_rms > 0.0f && this->load_inrush_rms_ > 0.0f) {
+    profile.inrush_ratio = this->load_inrush_rms_ / steady_rms;
+  }
+  uint32_t pulse_us = this->period_tracker_.pulse_width_us;
+  uint32_t steady_sag_us = (pulse_us > this->load_base_pulse_us_) ? pulse_us - this->load_base_pulse_us_ : 0;
+  if (this->load_base_pulse_us_ > 0 && steady_sag_us >= LOAD_MIN_SAG_US) {
+    profile.sag_ratio = static_cast<float>(this->load_peak_sag_us_) / static_cast<float>(steady_sag_us);
+  }
+
+  // Phase shift from metered P/Q, else from the current-zero comparator. Its ISR rejects lags beyond 90°,
+  // which is how a leading (capacitive) current shows up; only the sign is known then.
+  bool have_lag = false;
+  if (this->voltage_sense_pin_ != nullptr && this->power_avg_ > 0.0f) {
+    profile.lag_degrees = atan2f(this->reactive_avg_, this->power_avg_) * 180.0f / static_cast<float>(M_PI);
+    have_lag = true;
+  } else if (this->current_zero_pin_ != nullptr) {
+    uint32_t samples = this->current_lag_samples_ - this->load_lag_samples_base_;
+    uint32_t rejects = this->current_lag_rejects_ - this->load_lag_rejects_base_;
+    if (samples + rejects >= LOAD_MIN_LAG_SAMPLES) {
+      profile.lag_degrees = (rejects > samples) ? -90.0f : this->get_current_lag_degrees();
+      have_lag = true;
+    }
+  }
+
+  LoadType type = LOAD_TYPE_UNKNOWN;
+  if (have_lag && profile.lag_degrees <= -LOAD_LAG_DEGREES) {
+    type = LOAD_TYPE_CAPACITIVE;
+  } else if (have_lag && profile.lag_degrees >= LOAD_LAG_DEGREES) {
+    type = LOAD_TYPE_INDUCTIVE;
+  } else if (profile.inrush_ratio >= LOAD_LAMP_INRUSH_RATIO ||
+             (profile.inrush_ratio == 0.0f && profile.sag_ratio >= LOAD_LAMP_INRUSH_RATIO)) {
+    type = LOAD_TYPE_LAMP;
+  } else if (have_lag || profile.inrush_ratio > 0.0f || profile.sag_ratio > 0.0f) {
+    type = LOAD_TYPE_RESISTIVE;
+  }
+  profile.type = type;
+
+  ESP_LOGI(TAG, "🔍 Load detection result: %s", load_type_name(type));
+  ESP_LOGI(TAG, "   ├─ Inrush: %.1fx steady current (peak %.2f A, steady %.2f A)", profile.inrush_ratio,
+           this->load_inrush_rms_, steady_rms);
+  ESP_LOGI(TAG, "   ├─ Phase lag: %s%.1f°", have_lag ? "" : "not measured, ", profile.lag_degrees);
+  ESP_LOGI(TAG, "   └─ Detector sag: pulse +%u us at switch-on, +%u us steady (%.1fx)", this->load_peak_sag_us_,
+           steady_sag_us, profile.sag_ratio);
+
+  this->load_detect_state_ = LOAD_DETECT_IDLE;
+  if (type == LOAD_TYPE_UNKNOWN) {
+    ESP_LOGW(TAG, "⚠️ Nothing measurable (needs current_sense, current_zero_pin or a timestamping detector); not stored");
+  } else {
+    this->load_profile_ = profile;
+    this->load_profile_stored_ = true;
+    this->load_pref_.save(&this->load_profile_);
+    global_preferences->sync();
+    this->apply_load_defaults_(false);
+  }
+  this->set_duty_cycle_percent(this->requested_percent_);
+}
+
+void ZeroCrossRelayComponent::on_shutdown() {
+  if (this->mechanical_ && this->switch_log_.count != this->wear_saved_) {
+    uint32_t total = this->wear_base_ + this->switch_log_.count;
+    this->wear_pref_.save(&total);
+    global_preferences->sync();
+  }
+}
+
+void ZeroCrossRelayComponent::log_setup_summary_() {
+  ESP_LOGI(TAG, "");
+  ESP_LOGI(TAG, "✅ Zero-Cross Relay initialized successfully!");
+  ESP_LOGI(TAG, "   ├─ Input: GPIO%d (rising edge counts, %s)", this->zero_cross_gpio_num_, this->detector_name_);
+  const char *output_desc = "controlled via delayed timer";
+  if (this->output_mode_ == OUTPUT_MODE_RMT) {
+    output_desc = "RMT window playback";
+  } else if (this->output_mode_ == OUTPUT_MODE_MCPWM) {
+    output_desc = "MCPWM phase control, zero-cross sync";
+  }
+  ESP_LOGI(TAG, "   ├─ Output: GPIO%d (%s)", this->relay_output_gpio_num_, output_desc);
+  ESP_LOGI(TAG, "   ├─ Count range: %d-%d (auto-clear at %d)",
+           PCNT_LOW_LIMIT, PCNT_HIGH_LIMIT, PCNT_HIGH_LIMIT);
+  ESP_LOGI(TAG, "   ├─ Interrupt config: Core %d (APP_CPU), Priority %d (highest)",
+           INTERRUPT_CPU_CORE, INTERRUPT_PRIORITY);
+  float current_duty_percentage =
+      (static_cast<float>(this->duty_cycle_flip_point_) / static_cast<float>(PCNT_HIGH_LIMIT)) * 100.0f;
+  ESP_LOGI(TAG, "   ├─ Duty cycle: %.1f%% (flip point=%d, range: 0-%d)",
+           current_duty_percentage, this->duty_cycle_flip_point_, PCNT_HIGH_LIMIT);
+  if (this->output_mode_ == OUTPUT_MODE_RMT) {
+    ESP_LOGI(TAG, "   └─ Window boundary → worker task → RMT timeline (%.0f° lead, one refill per window)",
+             phase_degrees(this->switch_phase_q16_));
+    return;
+  }
+  if (this->output_mode_ == OUTPUT_MODE_MCPWM) {
+    ESP_LOGI(TAG, "   └─ Every edge → MCPWM sync → comparator A HIGH → comparator B LOW (no software in the loop)");
+    return;
+  }
+  if (this->modulation_mode_ == MODULATION_TIME_PROPORTIONING) {
+    ESP_LOGI(TAG, "   └─ Time proportioning: every %d edges → next segment, window=%d half-cycles, %.0f° delay",
+             PCNT_HIGH_LIMIT, this->window_half_cycles_(), phase_degrees(this->switch_phase_q16_));
+    return;
+  }
+  if (this->modulation_mode_ == MODULATION_HYBRID) {
+    ESP_LOGI(TAG, "   ├─ Phase cut: %d/%d of a half-cycle at the window start (random-fire SSR)",
+             static_cast<int>(this->cut_fraction_), CUT_FRACTION_STEPS);
+  }
+  if (this->modulation_mode_ == MODULATION_PATTERN) {
+    ESP_LOGI(TAG, "   └─ Pattern mode: every edge → next bit → (on change) %.0f° → GPIO4, window=%d half-cycles",
+             phase_degrees(this->switch_phase_q16_), this->pattern_length_);
+    return;
+  }
+  if (this->duty_cycle_flip_point_ > 0 && this->duty_cycle_flip_point_ < PCNT_HIGH_LIMIT) {
+    ESP_LOGI(TAG, "   ├─ Watch point 1: Count=%d → Start timer → %.0f° → GPIO4 LOW",
+             this->duty_cycle_flip_point_, phase_degrees(this->switch_phase_q16_));
+  } else if (this->duty_cycle_flip_point_ == 0) {
+    ESP_LOGI(TAG, "   ├─ Watch point 1: disabled (relay held LOW / 0%% duty)");
+  } else {
+    ESP_LOGI(TAG, "   ├─ Watch point 1: disabled (relay held HIGH / 100%% duty)");
+  }
+  ESP_LOGI(TAG, "   └─ Watch point 2: Count=%d → Start timer → %.0f° → GPIO4 HIGH + clear",
+           PCNT_HIGH_LIMIT, phase_degrees(this->switch_phase_q16_));
+}
+
+void ZeroCrossRelayComponent::leave_idle_() {
+  // Claim the wake-up under the lock: once the new setpoint is visible the ISR will not re-enter idle,
+  // and the boundary watch point does not exist until it is restored below.
+  portENTER_CRITICAL(&this->window_lock_);
+  bool was_idle = this->idle_latched_;
+  this->idle_latched_ = false;
+  portEXIT_CRITICAL(&this->window_lock_);
+  if (!was_idle) {
+    return;
+  }
+
+  esp_err_t err = this->restore_boundary_watch_point_();
+  if (err != ESP_OK) {
+    this->last_watch_point_update_err_ = err;
+    this->watch_point_update_event_ = true;
+    return;
+  }
+  this->idle_edges_alive_ = true;
+  ESP_LOGD(TAG, "Left idle fast path; boundary watch point %d restored.", PCNT_HIGH_LIMIT);
+}
+
+bool ZeroCrossRelayComponent::edges_active_(int count) {
+  // Edge activity: detector count or window counter moved since the last check
+  uint32_t now = millis();
+  uint32_t cycles = this->cycle_count_;
+  if (count != this->last_seen_count_ || cycles != this->last_seen_cycles_) {
+    this->last_seen_count_ = count;
+    this->last_seen_cycles_ = cycles;
+    this->last_edge_activity_ms_ = now;
+  }
+  return (this->last_edge_activity_ms_ != 0) && (now - this->last_edge_activity_ms_ < MCPWM_SYNC_TIMEOUT_MS);
+}
+
+void ZeroCrossRelayComponent::check_sync_fallback_() {
+  if (this->fallback_timer_ == nullptr || this->fallback_active_ || this->idle_latched_ || this->storm_active_) {
+    // Idle latches the level the PWM would produce anyway (0% or 100%); a storm holds the relay off
+    return;
+  }
+  this->edges_active_(this->detector_count_());
+  if (millis() - this->last_edge_activity_ms_ < this->fallback_timeout_ms_) {
+    return;
+  }
+
+  // A callback from the previous episode may still be pending; it must not start a second chain
+  esp_timer_stop(this->fallback_timer_);
+  portENTER_CRITICAL(&this->fallback_lock_);
+  this->fallback_active_ = true;
+  portEXIT_CRITICAL(&this->fallback_lock_);
+  this->fallback_in_on_phase_ = false;
+  this->fallback_entries_++;
+  ESP_LOGW(TAG, "⚠️ No zero-cross edges for %u ms; relay driven by timer PWM (%u ms period) until sync returns.",
+           this->fallback_timeout_ms_, static_cast<uint32_t>(this->fallback_period_us_ / 1000U));
+  this->step_fallback_pwm_();
+}
+
+uint64_t ZeroCrossRelayComponent::fallback_on_us_() const {
+  // Queued setpoints never reach a window boundary without edges, so the PWM follows them directly
+  if (this->watchdog_trip_ != WATCHDOG_OK) {
+    return this->fallback_period_us_ * static_cast<uint64_t>(this->watchdog_safe_flip_point_) / PCNT_HIGH_LIMIT;
+  }
+  if (this->modulation_mode_ == MODULATION_TIME_PROPORTIONING) {
+    int32_t pending = this->pending_window_on_;
+    uint64_t on = (pending >= 0) ? static_cast<uint64_t>(pending) : this->window_on_half_cycles_;
+    return this->fallback_period_us_ * on / static_cast<uint64_t>(this->window_half_cycles_());
+  }
+  int flip_point = this->pending_duty_cycle_flip_point_;
+  int fraction = this->pending_cut_fraction_;
+  if (flip_point < 0) {
+    flip_point = this->duty_cycle_flip_point_;
+  }
+  if (fraction < 0) {
+    fraction = this->cut_fraction_;
+  }
+  uint64_t on_q8 = static_cast<uint64_t>(flip_point) * CUT_FRACTION_STEPS + static_cast<uint64_t>(fraction);
+  return this->fallback_period_us_ * on_q8 / (PCNT_HIGH_LIMIT * CUT_FRACTION_STEPS);
+}
+
+void ZeroCrossRelayComponent::step_fallback_pwm_() {
+  int level;
+  uint64_t next_us;
+  if (this->fallback_in_on_phase_ && this->fallback_off_us_ > 0) {
+    level = 0;
+    next_us = this->fallback_off_us_;
+    this->fallback_in_on_phase_ = false;
+  } else {
+    // Period start: pick up the setpoint
+    uint64_t on_us = this->fallback_on_us_();
+    this->fallback_off_us_ = this->fallback_period_us_ - on_us;
+    this->fallback_in_on_phase_ = (on_us > 0);
+    level = this->fallback_in_on_phase_ ? 1 : 0;
+    next_us = this->fallback_in_on_phase_ ? on_us : this->fallback_period_us_;
+  }
+
+  // The handover ISR clears fallback_active_ under the same lock: no PWM write can follow it
+  portENTER_CRITICAL(&this->fallback_lock_);
+  bool active = this->fallback_active_;
+  if (active) {
+    gpio_set_level(this->relay_output_gpio_num_, level);
+  }
+  portEXIT_CRITICAL(&this->fallback_lock_);
+  if (active) {
+    esp_timer_start_once(this->fallback_timer_, next_us);
+  }
+}
+
+void ZeroCrossRelayComponent::fallback_timer_callback_(void *arg) {
+  static_cast<ZeroCrossRelayComponent *>(arg)->step_fallback_pwm_();
+}
+
+void ZeroCrossRelayComponent::update_storm_() {
+  if (this->storm_event_) {
+    this->storm_event_ = false;
+    this->storm_probe_ms_ = millis();
+    ESP_LOGE(TAG, "❌ Zero-cross interrupt storm: %d windows in a row shorter than %u ms (edges above %u Hz)",
+             STORM_TRIP_WINDOWS, static_cast<uint32_t>(STORM_MIN_WINDOW_US / 1000U),
+             static_cast<uint32_t>(1000000U / CAPTURE_MIN_HALF_CYCLE_US));
+    ESP_LOGE(TAG, "   Watch point interrupts off, relay held off; probing every %u ms until edges are sane",
+             static_cast<uint32_t>(STORM_PROBE_INTERVAL_MS));
+  }
+  if (this->storm_exit_event_) {
+    this->storm_exit_event_ = false;
+    ESP_LOGI(TAG, "✓ Zero-cross edges sane again (%d windows in range); control resumed at the window start.",
+             STORM_RECOVER_WINDOWS);
+  }
+  if (!this->storm_active_ || this->storm_probing_ || millis() - this->storm_probe_ms_ < STORM_PROBE_INTERVAL_MS) {
+    return;
+  }
+  // The boundary watch point is off, so the ISR-only probe state is safe to reset here
+  this->storm_probe_ms_ = millis();
+  this->storm_last_us_ = 0;
+  this->storm_run_ = 0;
+  this->storm_probing_ = true;
+  esp_err_t err = this->arm_storm_probe_();
+  if (err != ESP_OK) {
+    this->storm_probing_ = false;
+    ESP_LOGW(TAG, "⚠️ Storm probe could not arm the boundary watch point: %s", esp_err_to_name(err));
+  }
+}
+
+void ZeroCrossRelayComponent::loop() {
+  if (this->fallback_exit_event_) {
+    this->fallback_exit_event_ = false;
+    ESP_LOGI(TAG, "Zero-cross edges resumed; timer PWM fallback handed back at the window start.");
+  }
+  if (this->output_fault_event_) {
+    this->output_fault_event_ = false;
+    this->trip_output_failsafe_();
+  }
+  if (this->watchdog_event_) {
+    this->watchdog_event_ = false;
+    static const char *const LIMITS[] = {"", "maximum on-time", "minimum off-time", "maximum average duty"};
+    ESP_LOGE(TAG, "❌ Duty watchdog: %s reached; duty cycle forced to %.0f%% until clear_watchdog()",
+             LIMITS[this->watchdog_trip_], this->watchdog_safe_percent_);
+    this->ramp_target_percent_ = -1.0f;
+  }
+  this->update_storm_();
+  this->check_sync_fallback_();
+  this->update_power_();
+  this->update_thermal_();
+  this->update_ramp_();
+  this->update_load_detection_();
+  // Phase-cut delays and current lag follow the tracked period; ISRs read this single word
+  this->isr_half_cycle_us_ = this->measured_half_cycle_us_();
+
+  if (this->watch_point_update_event_) {
+    bool success = (this->last_watch_point_update_err_ == ESP_OK);
+    if (success) {
+      float duty_percentage =
+          (static_cast<float>(this->duty_cycle_flip_point_) / static_cast<float>(PCNT_HIGH_LIMIT)) * 100.0f;
+      ESP_LOGI(TAG, "Duty cycle %s updated to %.1f%% (flip point %d).",
+               (this->modulation_mode_ == MODULATION_PATTERN) ? "pattern" : "watch point",
+               duty_percentage, this->duty_cycle_flip_point_);
+    } else {
+      int pending = this->pending_duty_cycle_flip_point_;
+      if (pending < 0) {
+        pending = this->duty_cycle_flip_point_;
+      }
+      ESP_LOGE(TAG, "Failed to update duty cycle watch point to %d: %s", pending,
+               esp_err_to_name(this->last_watch_point_update_err_));
+    }
+    this->watch_point_update_event_ = false;
+  }
+
+  // ========================================
+  // Idle liveness check (no interrupts while latched at 0% / 100%)
+  // ========================================
+  if (this->idle_latched_) {
+    bool alive = this->edges_active_(this->detector_count_());
+    if (alive != this->idle_edges_alive_) {
+      this->idle_edges_alive_ = alive;
+      if (alive) {
+        ESP_LOGI(TAG, "Zero-cross edges resumed (idle, output latched %s).",
+                 (this->duty_cycle_flip_point_ == 0) ? "LOW" : "HIGH");
+      } else {
+        ESP_LOGW(TAG, "⚠️ No zero-cross edges for %d ms (idle, output latched %s).", MCPWM_SYNC_TIMEOUT_MS,
+                 (this->duty_cycle_flip_point_ == 0) ? "LOW" : "HIGH");
+      }
+    }
+  }
+
+  // ========================================
+  // Periodic status logging (every 5 seconds)
+  // ========================================
+
+  static uint32_t last_log_time = 0;
+  uint32_t current_time = millis();
+
+  // Output statistics every 5 seconds
+  if (current_time - last_log_time > 5000) {
+    last_log_time = current_time;
+
+    // Read current detector count
+    int count = this->detector_count_();
+
+    // Get cycle statistics from ISR (atomic read)
+    uint32_t total_triggers = this->trigger_count_;
+    uint32_t total_cycles = this->cycle_count_;
+
+    // Calculate cycle time if we have at least one complete cycle
+    float cycle_time_ms = 0.0f;
+    uint32_t captured_q4 = this->period_tracker_.half_cycle_q4;
+    if (total_cycles > 1 && this->last_cycle_time_ > 0) {
+      // Get cycle time in milliseconds (us → ms)
+      cycle_time_ms = (float)this->last_cycle_time_ / 1000.0f;
+
+      // Calculate estimated AC frequency
+      // Logic:
+      // - 20 zero-cross pulses per cycle (PCNT counts 0→20)
+      // - For 50Hz AC: 100 zero-cross points/second
+      // - So 20 pulses = 20/100 = 0.2 seconds = 200ms
+      // - Frequency = (20 pulses) / (cycle_time_seconds) / 2
+      // - Formula: freq = 20 / (cycle_time_ms / 1000) / 2 = 10000 / cycle_time_ms
+      // - Pattern mode windows span pattern_length_ half-cycles: freq = length * 500 / cycle_time_ms
+      if (cycle_time_ms > 0) {
+        this->estimated_frequency_ = static_cast<float>(this->window_half_cycles_()) * 500.0f / cycle_time_ms;
+      }
+    }
+    if (captured_q4 > 0) {
+      // Hardware-captured half-cycle period is latency-free: freq = 1e6 / (2 * T_half)
+      this->estimated_frequency_ = 8000000.0f / static_cast<float>(captured_q4);
+    }
+
+    ESP_LOGI(TAG, "📊 %s Zero-Cross Statistics:", this->detector_name_);
+    if (this->modulation_mode_ == MODULATION_PATTERN) {
+      ESP_LOGI(TAG, "   ├─ Active pattern: 0x%016llx (%d/%d half-cycles on)",
+               static_cast<unsigned long long>(this->active_pattern_),
+               __builtin_popcountll(this->active_pattern_), this->pattern_length_);
+    } else if (this->modulation_mode_ == MODULATION_TIME_PROPORTIONING) {
+      ESP_LOGI(TAG, "   ├─ Window position: %u / %d half-cycles (on: %u)",
+               static_cast<uint32_t>(this->window_segment_) * PCNT_HIGH_LIMIT + count, this->window_half_cycles_(),
+               static_cast<uint32_t>(this->window_on_half_cycles_));
+    } else {
+      ESP_LOGI(TAG, "   ├─ Current count: %d / %d", count, PCNT_HIGH_LIMIT);
+    }
+    ESP_LOGI(TAG, "   ├─ Duty cycle: %.1f%% (flip point: %d)",
+             (static_cast<float>(this->duty_cycle_flip_point_) / static_cast<float>(PCNT_HIGH_LIMIT)) * 100.0f,
+             this->duty_cycle_flip_point_);
+    if (this->modulation_mode_ == MODULATION_HYBRID) {
+      ESP_LOGI(TAG, "   ├─ Phase cut: %d/%d half-cycle (total %.2f%%)", static_cast<int>(this->cut_fraction_),
+               CUT_FRACTION_STEPS, this->get_duty_cycle_percentage());
+    }
+    ESP_LOGI(TAG, "   ├─ Total watch point triggers: %u", total_triggers);
+    if (this->idle_latched_) {
+      ESP_LOGI(TAG, "   ├─ Idle: output latched %s, boundary interrupt off, edges %s",
+               (this->duty_cycle_flip_point_ == 0) ? "LOW" : "HIGH", this->idle_edges_alive_ ? "present" : "MISSING");
+    }
+    if (this->mechanical_) {
+      ESP_LOGI(TAG, "   ├─ Mechanical relay: operate %u us, release %u us, lead %u half-cycles, %u operations",
+               static_cast<uint32_t>(this->operate_us_), static_cast<uint32_t>(this->release_us_),
+               static_cast<uint32_t>(this->lead_half_cycles_), this->get_switch_operations());
+      if (this->contact_feedback_pin_ != nullptr) {
+        ESP_LOGI(TAG, "   ├─ Contact feedback: %u samples learned, %u rejected",
+                 static_cast<uint32_t>(this->contact_learn_count_), static_cast<uint32_t>(this->contact_reject_count_));
+      }
+    }
+    if (this->current_zero_pin_ != nullptr) {
+      uint32_t off_us = this->turn_off_delay_us_();
+      ESP_LOGI(TAG, "   ├─ Current lag: %.1f° (%u us, %u samples, %u rejected), turn-off at %u us",
+               this->get_current_lag_degrees(), static_cast<uint32_t>(this->current_lag_us_),
+               static_cast<uint32_t>(this->current_lag_samples_), static_cast<uint32_t>(this->current_lag_rejects_),
+               (off_us > 0) ? off_us : this->switch_delay_us_());
+    }
+    if (this->current_sense_pin_ != nullptr) {
+      static const char *const CONDUCTION[] = {"unknown", "off", "on"};
+      ESP_LOGI(TAG, "   ├─ Current: %.2f A RMS (last half-cycle %s), on %.2f A, off %.3f A, %u half-cycles (%u partial)",
+               this->current_rms_, CONDUCTION[this->current_conduction_ + 1], this->current_rms_on_,
+               this->current_rms_off_, static_cast<uint32_t>(this->current_half_cycles_),
+               static_cast<uint32_t>(this->current_partial_));
+      if (this->voltage_sense_pin_ != nullptr) {
+        ESP_LOGI(TAG, "   ├─ Power: %.1f W, %.1f var, PF %.3f, %.1f V (full-on %.1f W, %u cycles, %u partial)",
+                 this->power_avg_, this->reactive_avg_, this->meter_pf_, this->meter_voltage_rms_,
+                 this->meter_power_on_, static_cast<uint32_t>(this->meter_cycles_),
+                 static_cast<uint32_t>(this->meter_partial_));
+      }
+      ESP_LOGI(TAG, "   ├─ ADC stream: %u frames decoded, %u lost to overflow", adc_frames_read_,
+               static_cast<uint32_t>(adc_overflows_));
+    }
+    if (this->get_load_type() != LOAD_TYPE_UNKNOWN || this->load_detect_state_ != LOAD_DETECT_IDLE) {
+      ESP_LOGI(TAG, "   ├─ Load: %s%s (inrush %.1fx, lag %.1f°), ramp %.1f %%/s",
+               load_type_name(this->get_load_type()),
+               (this->load_detect_state_ != LOAD_DETECT_IDLE) ? ", detection running" : "",
+               this->load_profile_.inrush_ratio, this->load_profile_.lag_degrees, this->ramp_rate_);
+    }
+    if (this->feedback_pin_ != nullptr) {
+      static const char *const FAULTS[] = {"OK", "STUCK ON", "OPEN"};
+      ESP_LOGI(TAG, "   ├─ Output verification: %s (%u samples, %u mismatched, %u skipped near transitions)",
+               FAULTS[this->output_fault_], static_cast<uint32_t>(this->feedback_samples_),
+               static_cast<uint32_t>(this->feedback_mismatches_), static_cast<uint32_t>(this->feedback_skipped_));
+    }
+    if (this->thermal_enabled_) {
+      ESP_LOGI(TAG, "   ├─ SSR thermal: junction %.1f°C, heatsink %.1f°C, ambient %.1f°C, %.2f A mean, duty limit %.0f%%",
+               this->get_junction_temperature(), this->get_heatsink_temperature(),
+               static_cast<float>(this->thermal_ambient_q8_) / 256.0f, static_cast<float>(this->thermal_mean_ma_) / 1000.0f,
+               this->duty_limit_percent_);
+    }
+    if (this->storm_trips_ > 0) {
+      ESP_LOGI(TAG, "   ├─ Interrupt storms: %u trips, %s", static_cast<uint32_t>(this->storm_trips_),
+               !this->storm_active_ ? "edges sane" : (this->storm_probing_ ? "tripped, probing" : "tripped"));
+    }
+    if (this->watchdog_enabled_) {
+      static const char *const TRIPS[] = {"OK", "MAX ON-TIME", "MIN OFF-TIME", "AVERAGE DUTY"};
+      ESP_LOGI(TAG, "   ├─ Duty watchdog: %s (%u trips, rolling average %.1f%%)", TRIPS[this->watchdog_trip_],
+               static_cast<uint32_t>(this->watchdog_trips_),
+               static_cast<float>(this->watchdog_average_q16_) * 100.0f / 65536.0f);
+    }
+    if (this->fallback_timer_ != nullptr) {
+      ESP_LOGI(TAG, "   ├─ Sync fallback: %s (entered %u times)",
+               this->fallback_active_ ? "ACTIVE, timer PWM drives the relay" : "standby", this->fallback_entries_);
+    }
+    ESP_LOGI(TAG, "   ├─ Complete cycles (%d-count): %u", this->window_half_cycles_(), total_cycles);
+    if (this->edge_capture_mode_ == EDGE_CAPTURE_RMT) {
+      ESP_LOGI(TAG, "   ├─ RX batches: %u (dropped: %u), last batch %u-%u us",
+               static_cast<uint32_t>(this->rx_batch_count_), static_cast<uint32_t>(this->rx_drop_count_),
+               static_cast<uint32_t>(this->rx_min_interval_us_), static_cast<uint32_t>(this->rx_max_interval_us_));
+    }
+    if (this->period_tracker_.edge_count > 0) {
+      ESP_LOGI(TAG, "   ├─ Captured edges: %u (rejected: %u), half-cycle %.1f us, pulse width %u us",
+               static_cast<uint32_t>(this->period_tracker_.edge_count),
+               static_cast<uint32_t>(this->period_tracker_.reject_count), static_cast<float>(captured_q4) / 16.0f,
+               static_cast<uint32_t>(this->period_tracker_.pulse_width_us));
+    }
+    this->log_stage_statistics_();
+    if (cycle_time_ms > 0) {
+      ESP_LOGI(TAG, "   ├─ Last cycle time: %.2f ms", cycle_time_ms);
+      ESP_LOGI(TAG, "   └─ Estimated AC frequency: %.2f Hz", this->estimated_frequency_);
+    } else {
+      ESP_LOGI(TAG, "   └─ (Waiting for first complete cycle...)");
+    }
+  }
+}
+
+void ZeroCrossRelayComponent::dump_config() {
+  ESP_LOGCONFIG(TAG, "Zero Cross Detection Relay:");
+  ESP_LOGCONFIG(TAG, "  Zero-cross input: GPIO%d (%s edge counting)", this->zero_cross_gpio_num_, this->detector_name_);
+  if (this->edge_capture_mode_ == EDGE_CAPTURE_RMT) {
+    ESP_LOGCONFIG(TAG, "  Edge telemetry: RMT RX, %d pulses per CPU wakeup (1us resolution)",
+                  static_cast<int>(RMT_RX_BATCH_SYMBOLS));
+  }
+  this->dump_stage_config_();
+  if (this->mechanical_) {
+    ESP_LOGCONFIG(TAG, "  Mechanical relay: coil %u us (on) / %u us (off) ahead of the zero-cross, %u operations",
+                  static_cast<uint32_t>(this->operate_us_), static_cast<uint32_t>(this->release_us_),
+                  this->get_switch_operations());
+    if (this->contact_feedback_pin_ != nullptr) {
+      ESP_LOGCONFIG(TAG, "    └─ Contact feedback: GPIO%d (operate/release times learned)", this->contact_gpio_num_);
+    }
+  }
+  if (this->current_zero_pin_ != nullptr) {
+    ESP_LOGCONFIG(TAG, "  Zero-current turn-off: GPIO%d, gate released %.1f° after the measured current zero",
+                  this->current_zero_gpio_num_, phase_degrees(CURRENT_ZERO_GUARD_Q16));
+  }
+  if (this->current_sense_pin_ != nullptr) {
+    ESP_LOGCONFIG(TAG, "  Current sense: GPIO%d (ADC1 channel %d), %.2f A/V, %d Hz, RMS per half-cycle",
+                  this->current_sense_pin_->get_pin(), this->current_adc_channel_, this->current_amps_per_volt_,
+                  CURRENT_SAMPLE_RATE_HZ);
+    if (this->voltage_sense_pin_ != nullptr) {
+      ESP_LOGCONFIG(TAG, "    └─ Metering: voltage GPIO%d (ADC1 channel %d), %.1f V/V, P/Q/PF per mains cycle",
+                    this->voltage_sense_pin_->get_pin(), this->voltage_adc_channel_, this->voltage_volts_per_volt_);
+    }
+  }
+  if (this->target_power_ >= 0.0f || this->rated_power_ > 0.0f) {
+    ESP_LOGCONFIG(TAG, "  Power regulation: rated %.0f W (replaced by the metered full-on power), setpoint %.0f W",
+                  this->rated_power_, this->target_power_);
+  }
+  if (this->load_detection_auto_ || this->get_load_type() != LOAD_TYPE_UNKNOWN || this->ramp_rate_ > 0.0f) {
+    ESP_LOGCONFIG(TAG, "  Load type: %s%s, ramp %.1f %%/s", load_type_name(this->get_load_type()),
+                  this->load_detection_auto_ ? (this->load_profile_stored_ ? " (detected, stored)" : " (auto-detect)")
+                                             : "",
+                  this->ramp_rate_);
+  }
+  if (this->feedback_pin_ != nullptr) {
+    ESP_LOGCONFIG(TAG, "  Output verification: GPIO%d (%s), every %d ms, failsafe after %u mismatches%s",
+                  this->feedback_gpio_num_, (this->feedback_type_ == FEEDBACK_CURRENT) ? "current presence" : "readback",
+                  FEEDBACK_SAMPLE_INTERVAL_US / 1000, this->feedback_fault_threshold_,
+                  (this->failsafe_pin_ != nullptr) ? ", releases the failsafe output" : "");
+  }
+  if (this->thermal_enabled_) {
+    ESP_LOGCONFIG(TAG, "  SSR thermal model: %.2f V drop, %.2f K/W junction, %.2fx that to ambient, derate %.0f-%.0f°C, "
+                  "ambient %s", static_cast<float>(this->thermal_on_mv_) / 1000.0f,
+                  static_cast<float>(this->thermal_r_jh_q8_) / 256.0f, static_cast<float>(this->thermal_r_ratio_q8_) / 256.0f,
+                  static_cast<float>(this->thermal_derate_start_q8_) / 256.0f,
+                  static_cast<float>(this->thermal_max_q8_) / 256.0f, this->thermal_chip_ambient_ ? "chip sensor" : "fixed");
+  }
+  ESP_LOGCONFIG(TAG, "  Interrupt-storm governor: trips after %d windows shorter than %u ms, probes every %u ms",
+                STORM_TRIP_WINDOWS, static_cast<uint32_t>(STORM_MIN_WINDOW_US / 1000U),
+                static_cast<uint32_t>(STORM_PROBE_INTERVAL_MS));
+  if (this->watchdog_enabled_) {
+    ESP_LOGCONFIG(TAG, "  Duty watchdog: max on %u ms, min off %u ms, max average %.0f%% over %u s, safe duty %.0f%%",
+                  static_cast<uint32_t>((static_cast<uint64_t>(this->watchdog_max_on_ticks_) << 10) / 1000U),
+                  static_cast<uint32_t>((static_cast<uint64_t>(this->watchdog_min_off_ticks_) << 10) / 1000U),
+                  static_cast<float>(this->watchdog_max_average_q16_) * 100.0f / 65536.0f,
+                  static_cast<uint32_t>((static_cast<uint64_t>(this->watchdog_average_ticks_) << 10) / 1000000U),
+                  this->watchdog_safe_percent_);
+  }
+  if (this->fallback_timer_ != nullptr) {
+    ESP_LOGCONFIG(TAG, "  No-sync fallback: timer PWM, %u ms period, after %u ms without edges",
+                  static_cast<uint32_t>(this->fallback_period_us_ / 1000U), this->fallback_timeout_ms_);
+  }
+  if (this->output_mode_ == OUTPUT_MODE_MCPWM) {
+    ESP_LOGCONFIG(TAG, "    ├─ Conduction: %.1f%% of each half-cycle (flip point: %d)",
+                  (static_cast<float>(this->duty_cycle_flip_point_) / static_cast<float>(PCNT_HIGH_LIMIT)) * 100.0f,
+                  this->duty_cycle_flip_point_);
+    ESP_LOGCONFIG(TAG, "    ├─ Earliest fire: %.1f°, release guard: %.1f° (scaled to the tracked period)",
+                  phase_degrees(MCPWM_MIN_FIRE_Q16), phase_degrees(MCPWM_RELEASE_GUARD_Q16));
+    ESP_LOGCONFIG(TAG, "    └─ Sync timeout: %d ms (output held LOW)", MCPWM_SYNC_TIMEOUT_MS);
+    return;
+  }
+  ESP_LOGCONFIG(TAG, "  Count range: %d - %d (auto-clear at %d)",
+                PCNT_LOW_LIMIT, PCNT_HIGH_LIMIT, PCNT_HIGH_LIMIT);
+  ESP_LOGCONFIG(TAG, "  Switch delay: %.1f° of the half-cycle (currently %u us)", phase_degrees(this->switch_phase_q16_),
+                this->switch_delay_us_());
+  ESP_LOGCONFIG(TAG, "  Duty cycle control:");
+  float duty_percentage =
+      (static_cast<float>(this->duty_cycle_flip_point_) / static_cast<float>(PCNT_HIGH_LIMIT)) * 100.0f;
+  ESP_LOGCONFIG(TAG, "    ├─ Current duty cycle: %.1f%% (flip point: %d)",
+                duty_percentage, this->duty_cycle_flip_point_);
+  ESP_LOGCONFIG(TAG, "    ├─ Adjustable range: 0%% - 100%% (flip point: 0-%d)", PCNT_HIGH_LIMIT);
+  ESP_LOGCONFIG(TAG, "    └─ Setpoint changes: %s",
+                (this->immediate_apply_ && this->output_mode_ == OUTPUT_MODE_GPTIMER &&
+                 this->modulation_mode_ == MODULATION_FLIP_POINT)
+                    ? "inside the current window (cut at the next edge if already passed)"
+                    : "at the next window boundary");
+  if (this->modulation_mode_ == MODULATION_TIME_PROPORTIONING) {
+    ESP_LOGCONFIG(TAG, "  Time proportioning (with %.0f° delay):", phase_degrees(this->switch_phase_q16_));
+    ESP_LOGCONFIG(TAG, "    ├─ Window: %d half-cycles (%u segments of %d edges)", this->window_half_cycles_(),
+                  this->window_segments_, PCNT_HIGH_LIMIT);
+    ESP_LOGCONFIG(TAG, "    └─ On: %u half-cycles (resolution: 1 half-cycle)",
+                  static_cast<uint32_t>(this->window_on_half_cycles_));
+    return;
+  }
+  if (this->modulation_mode_ == MODULATION_PATTERN) {
+    ESP_LOGCONFIG(TAG, "  Pattern mode (with %.0f° delay):", phase_degrees(this->switch_phase_q16_));
+    ESP_LOGCONFIG(TAG, "    ├─ Window: %d half-cycles (one bit per edge)", this->pattern_length_);
+    const char *distribution = "even";
+    if (this->pattern_distribution_ == PATTERN_DISTRIBUTION_BURST) {
+      distribution = "burst";
+    } else if (this->pattern_distribution_ == PATTERN_DISTRIBUTION_FLICKER) {
+      distribution = (this->pattern_table_ != nullptr) ? "flicker-optimised (build-time table)" : "even (no flicker table)";
+    }
+    ESP_LOGCONFIG(TAG, "    ├─ Distribution: %s", distribution);
+    ESP_LOGCONFIG(TAG, "    └─ Active pattern: 0x%016llx", static_cast<unsigned long long>(this->active_pattern_));
+    return;
+  }
+  if (this->modulation_mode_ == MODULATION_HYBRID) {
+    ESP_LOGCONFIG(TAG, "  Hybrid mode (random-fire SSR):");
+    ESP_LOGCONFIG(TAG, "    ├─ Phase cut: %d/%d of the first half-cycle (currently fired at %u us)",
+                  static_cast<int>(this->cut_fraction_), CUT_FRACTION_STEPS,
+                  (this->isr_half_cycle_us_ * cut_phase_q16_[this->cut_fraction_]) >> 16);
+    ESP_LOGCONFIG(TAG, "    └─ Resolution: %.3f%% (1/%d of a half-cycle per window)",
+                  100.0f / (PCNT_HIGH_LIMIT * CUT_FRACTION_STEPS), CUT_FRACTION_STEPS);
+  }
+  ESP_LOGCONFIG(TAG, "  Watch points (with %.0f° delay):", phase_degrees(this->switch_phase_q16_));
+  if (this->duty_cycle_flip_point_ > 0 && this->duty_cycle_flip_point_ < PCNT_HIGH_LIMIT) {
+    ESP_LOGCONFIG(TAG, "    ├─ Point 1: Count=%d → GPIO%d LOW (relay off)",
+                  this->duty_cycle_flip_point_, this->relay_output_gpio_num_);
+  } else if (this->duty_cycle_flip_point_ == 0) {
+    ESP_LOGCONFIG(TAG, "    ├─ Point 1: disabled (relay held LOW / 0%% duty)");
+  } else {
+    ESP_LOGCONFIG(TAG, "    ├─ Point 1: disabled (relay held HIGH / 100%% duty)");
+  }
+  ESP_LOGCONFIG(TAG, "    └─ Point 2: Count=%d → GPIO%d HIGH (relay on) + clear count%s",
+                PCNT_HIGH_LIMIT, this->relay_output_gpio_num_,
+                this->idle_latched_ ? " (removed: idle fast path, output latched)" : "");
+}
+
+// ========================================
+// Half-Cycle Period Tracker (ISR or Task Context)
+// ========================================
+bool IRAM_ATTR HalfCyclePeriodTracker::is_plausible(uint32_t interval_us) {
+  return interval_us >= CAPTURE_MIN_HALF_CYCLE_US && interval_us <= CAPTURE_MAX_HALF_CYCLE_US;
+}
+
+bool IRAM_ATTR HalfCyclePeriodTracker::add_interval(uint32_t interval_us) {
+  if (!is_plausible(interval_us)) {
+    this->reject_count++;
+    return false;
+  }
+  uint32_t filtered_q4 = this->half_cycle_q4;
+  if (filtered_q4 != 0) {
+    // Plausible but far from the tracked period: a missed or extra edge, unless it keeps happening
+    uint32_t filtered_us = filtered_q4 >> 4;
+    uint32_t deviation = (interval_us > filtered_us) ? interval_us - filtered_us : filtered_us - interval_us;
+    if (deviation > (filtered_us >> CAPTURE_OUTLIER_SHIFT)) {
+      if (++this->outlier_run < CAPTURE_RELOCK_RUN) {
+        this->reject_count++;
+        return false;
+      }
+      filtered_q4 = 0;  // Supply frequency changed: relock on the new period
+    }
+  }
+  this->outlier_run = 0;
+  if (filtered_q4 == 0) {
+    filtered_q4 = interval_us << 4;
+  } else {
+    // EWMA in Q4: f += (x - f) / 8, done in signed arithmetic
+    int32_t delta = static_cast<int32_t>(interval_us << 4) - static_cast<int32_t>(filtered_q4);
+    filtered_q4 = static_cast<uint32_t>(static_cast<int32_t>(filtered_q4) + (delta >> CAPTURE_FILTER_SHIFT));
+  }
+  this->half_cycle_q4 = filtered_q4;
+  this->period_us = interval_us;
+  return true;
+}
+
+// ========================================
+// PCNT Detector
+// ========================================
+bool PcntDetector::setup(gpio_num_t pin, HalfCyclePeriodTracker *tracker) {
+  // ========================================
+  // Step 3: Create and Configure PCNT Unit
+  // ========================================
+  ESP_LOGI(TAG, "Step 3: Creating PCNT unit (count range: 0-%d)...", PCNT_HIGH_LIMIT);
+
+  pcnt_unit_config_t unit_config = {
+      .low_limit = PCNT_LOW_LIMIT,
+      .high_limit = PCNT_HIGH_LIMIT,
+      .flags = {},
+  };
+
+  esp_err_t err = pcnt_new_unit(&unit_config, &this->unit_);
+  if (err != ESP_OK) {
+    ESP_LOGE(TAG, "❌ Failed to create PCNT unit: %s", esp_err_to_name(err));
+    return false;
+  }
+  ESP_LOGI(TAG, "✓ PCNT unit created (low=%d, high=%d)", PCNT_LOW_LIMIT, PCNT_HIGH_LIMIT);
+
+  // ========================================
+  // Step 4: Configure Glitch Filter (optional but recommended)
+  // ========================================
+  ESP_LOGI(TAG, "Step 4: Configuring glitch filter (%d ns)...", PCNT_GLITCH_FILTER_NS);
+
+  pcnt_glitch_filter_config_t filter_config = {
+      .max_glitch_ns = PCNT_GLITCH_FILTER_NS,
+  };
+
+  err = pcnt_unit_set_glitch_filter(this->unit_, &filter_config);
+  if (err != ESP_OK) {
+    ESP_LOGE(TAG, "❌ Failed to set glitch filter: %s", esp_err_to_name(err));
+    this->release_();
+    return false;
+  }
+  ESP_LOGI(TAG, "✓ Glitch filter configured (%d ns)", PCNT_GLITCH_FILTER_NS);
+
+  // ========================================
+  // Step 5: Create PCNT Channel and Set Edge Action
+  // ========================================
+  ESP_LOGI(TAG, "Step 5: Creating PCNT channel for GPIO%d...", pin);
+
+  pcnt_chan_config_t channel_config = {
+      .edge_gpio_num = pin,
+      .level_gpio_num = -1,  // No level control GPIO
+      .flags = {},
+  };
+
+  err = pcnt_new_channel(this->unit_, &channel_config, &this->channel_);
+  if (err != ESP_OK) {
+    ESP_LOGE(TAG, "❌ Failed to create PCNT channel: %s", esp_err_to_name(err));
+    this->release_();
+    return false;
+  }
+
+  // Set edge action: Rising edge INCREASE, Falling edge HOLD
+  err = pcnt_channel_set_edge_action(this->channel_,
+                                     PCNT_CHANNEL_EDGE_ACTION_INCREASE,
+                                     PCNT_CHANNEL_EDGE_ACTION_HOLD);
+  if (err != ESP_OK) {
+    ESP_LOGE(TAG, "❌ Failed to set edge action: %s", esp_err_to_name(err));
+    this->release_();
+    return false;
+  }
+  ESP_LOGI(TAG, "✓ PCNT channel created (GPIO%d: rising↑ +1, falling↓ hold)", pin);
+  return true;
+}
+
+void PcntDetector::release_() {
+  // Hand partially allocated resources back so a fallback detector (or another component) can use them
+  if (this->channel_ != nullptr) {
+    pcnt_del_channel(this->channel_);
+    this->channel_ = nullptr;
+  }
+  if (this->unit_ != nullptr) {
+    pcnt_del_unit(this->unit_);
+    this->unit_ = nullptr;
+  }
+}
+
+esp_err_t PcntDetector::start_(pcnt_watch_cb_t callback, void *ctx) {
+  // ========================================
+  // Step 7: Register Event Callback with Core 1 Affinity and High Priority
+  // ========================================
+  ESP_LOGI(TAG, "Step 7: Registering PCNT event callback (Core %d, Priority %d)...",
+           INTERRUPT_CPU_CORE, INTERRUPT_PRIORITY);
+
+  pcnt_event_callbacks_t callbacks = {
+      .on_reach = callback,
+  };
+
+  esp_err_t err = pcnt_unit_register_event_callbacks(this->unit_, &callbacks, ctx);
+  if (err != ESP_OK) {
+    ESP_LOGE(TAG, "❌ Failed to register event callbacks: %s", esp_err_to_name(err));
+    return err;
+  }
+  ESP_LOGI(TAG, "✓ Event callback registered (on_reach ISR, Core %d)", INTERRUPT_CPU_CORE);
+
+  // ========================================
+  // Step 8: Enable and Start PCNT Unit
+  // ========================================
+  ESP_LOGI(TAG, "Step 8: Enabling and starting PCNT unit...");
+
+  err = pcnt_unit_enable(this->unit_);
+  if (err != ESP_OK) {
+    ESP_LOGE(TAG, "❌ Failed to enable PCNT unit: %s", esp_err_to_name(err));
+    return err;
+  }
+
+  err = pcnt_unit_clear_count(this->unit_);
+  if (err != ESP_OK) {
+    ESP_LOGE(TAG, "❌ Failed to clear PCNT count: %s", esp_err_to_name(err));
+    return err;
+  }
+
+  err = pcnt_unit_start(this->unit_);
+  if (err != ESP_OK) {
+    ESP_LOGE(TAG, "❌ Failed to start PCNT unit: %s", esp_err_to_name(err));
+    return err;
+  }
+
+  ESP_LOGI(TAG, "✓ PCNT unit enabled and started (counting from 0)");
+  return ESP_OK;
+}
+
+int PcntDetector::get_count() const {
+  int count = 0;
+  pcnt_unit_get_count(this->unit_, &count);
+  return count;
+}
+
+void PcntDetector::dump_config() const {
+  ESP_LOGCONFIG(TAG, "  Edge action: Rising edge +1, Falling edge HOLD");
+  ESP_LOGCONFIG(TAG, "  Glitch filter: %d ns", PCNT_GLITCH_FILTER_NS);
+}
+
+// ========================================
+// GPIO ISR Detector
+// ========================================
+bool GpioIsrDetector::setup(gpio_num_t pin, HalfCyclePeriodTracker *tracker) {
+  ESP_LOGI(TAG, "Step 3: Installing GPIO ISR service (IRAM, priority %d)...", INTERRUPT_PRIORITY);
+  this->pin_ = pin;
+  this->tracker_ = tracker;
+
+  esp_err_t err = gpio_install_isr_service(ESP_INTR_FLAG_IRAM | (1 << INTERRUPT_PRIORITY));
+  if (err == ESP_ERR_INVALID_STATE) {
+    // Another component installed the shared service first; its priority applies
+    ESP_LOGI(TAG, "   • GPIO ISR service already installed, sharing it");
+  } else if (err != ESP_OK) {
+    ESP_LOGE(TAG, "❌ Failed to install GPIO ISR service: %s", esp_err_to_name(err));
+    return false;
+  }
+
+  ESP_LOGI(TAG, "Step 4-5: Enabling rising edge interrupt on GPIO%d (software count, quarter half-cycle hold-off)...",
+           pin);
+  err = gpio_set_intr_type(pin, GPIO_INTR_POSEDGE);
+  if (err != ESP_OK) {
+    ESP_LOGE(TAG, "❌ Failed to set GPIO%d interrupt type: %s", pin, esp_err_to_name(err));
+    return false;
+  }
+  ESP_LOGI(TAG, "✓ GPIO%d rising edge interrupt configured", pin);
+  return true;
+}
+
+esp_err_t GpioIsrDetector::start_(gpio_isr_t isr) {
+  ESP_LOGI(TAG, "Step 7-8: Attaching edge handler and starting software count...");
+  this->count_ = 0;
+  esp_err_t err = gpio_isr_handler_add(this->pin_, isr, this);
+  if (err == ESP_OK) {
+    err = gpio_intr_enable(this->pin_);
+  }
+  if (err != ESP_OK) {
+    ESP_LOGE(TAG, "❌ Failed to attach GPIO%d edge handler: %s", this->pin_, esp_err_to_name(err));
+    return err;
+  }
+  ESP_LOGI(TAG, "✓ GPIO ISR counting from 0");
+  return ESP_OK;
+}
+
+void GpioIsrDetector::dump_config() const {
+  ESP_LOGCONFIG(TAG, "  Edge source: GPIO%d rising edge interrupt, software count", this->pin_);
+  ESP_LOGCONFIG(TAG, "  Glitch filter: %u us hold-off (quarter half-cycle, software)", this->tracker_->holdoff_us());
+}
+
+void GpioIsrDetector::log_statistics() const {
+  ESP_LOGI(TAG, "   ├─ Edges rejected by hold-off: %u", static_cast<uint32_t>(this->glitch_count_));
+}
+
+// ========================================
+// Dual GPIO ISR Detector
+// Two inputs on the shared GPIO ISR service; the first voted-in arrival counts, its partner votes.
+// ========================================
+bool DualGpioDetector::setup(gpio_num_t pin, HalfCyclePeriodTracker *tracker) {
+  this->tracker_ = tracker;
+  this->inputs_[0].pin = pin;
+  if (this->secondary_pin_ == nullptr) {
+    ESP_LOGE(TAG, "❌ Dual detector needs a secondary zero-cross pin!");
+    return false;
+  }
+  this->inputs_[1].pin = static_cast<gpio_num_t>(this->secondary_pin_->get_pin());
+  if (this->inputs_[1].pin == pin) {
+    ESP_LOGE(TAG, "❌ Secondary zero-cross pin must differ from the primary one!");
+    return false;
+  }
+
+  ESP_LOGI(TAG, "Step 3: Configuring secondary input GPIO%d and the GPIO ISR service (IRAM, priority %d)...",
+           this->inputs_[1].pin, INTERRUPT_PRIORITY);
+  gpio_config_t secondary_config = {};
+  secondary_config.pin_bit_mask = (1ULL << this->inputs_[1].pin);
+  secondary_config.mode = GPIO_MODE_INPUT;
+  secondary_config.pull_up_en = GPIO_PULLUP_DISABLE;
+  secondary_config.pull_down_en = GPIO_PULLDOWN_DISABLE;
+  secondary_config.intr_type = GPIO_INTR_POSEDGE;
+  esp_err_t err = gpio_config(&secondary_config);
+  if (err != ESP_OK) {
+    ESP_LOGE(TAG, "❌ Failed to configure GPIO%d: %s", this->inputs_[1].pin, esp_err_to_name(err));
+    return false;
+  }
+  err = gpio_install_isr_service(ESP_INTR_FLAG_IRAM | (1 << INTERRUPT_PRIORITY));
+  if (err == ESP_ERR_INVALID_STATE) {
+    ESP_LOGI(TAG, "   • GPIO ISR service already installed, sharing it");
+  } else if (err != ESP_OK) {
+    ESP_LOGE(TAG, "❌ Failed to install GPIO ISR service: %s", esp_err_to_name(err));
+    return false;
+  }
+
+  ESP_LOGI(TAG, "Step 4-5: Enabling rising edge interrupt on primary GPIO%d (voted software count)...", pin);
+  err = gpio_set_intr_type(pin, GPIO_INTR_POSEDGE);
+  if (err != ESP_OK) {
+    ESP_LOGE(TAG, "❌ Failed to set GPIO%d interrupt type: %s", pin, esp_err_to_name(err));
+    return false;
+  }
+  ESP_LOGI(TAG, "✓ Dual zero-cross inputs configured");
+  return true;
+}
+
+esp_err_t DualGpioDetector::start_(gpio_isr_t primary_isr, gpio_isr_t secondary_isr) {
+  ESP_LOGI(TAG, "Step 7-8: Attaching both edge handlers and starting voted count...");
+  this->count_ = 0;
+  gpio_isr_t isrs[2] = {primary_isr, secondary_isr};
+  for (int i = 0; i < 2; i++) {
+    esp_err_t err = gpio_isr_handler_add(this->inputs_[i].pin, isrs[i], this);
+    if (err == ESP_OK) {
+      err = gpio_intr_enable(this->inputs_[i].pin);
+    }
+    if (err != ESP_OK) {
+      ESP_LOGE(TAG, "❌ Failed to attach GPIO%d edge handler: %s", this->inputs_[i].pin, esp_err_to_name(err));
+      return err;
+    }
+  }
+  ESP_LOGI(TAG, "✓ Dual GPIO ISR counting from 0");
+  return ESP_OK;
+}
+
+uint32_t IRAM_ATTR DualGpioDetector::lag_of_(int index) const {
+  if (this->offset_pairs_ < DUAL_OFFSET_LEARN_PAIRS) {
+    return 0;
+  }
+  int32_t offset_us = this->offset_q4_ / 16;  // Secondary minus primary
+  if (offset_us >= 0) {
+    return (index == 1) ? static_cast<uint32_t>(offset_us) : 0U;
+  }
+  return (index == 0) ? static_cast<uint32_t>(-offset_us) : 0U;
+}
+
+void IRAM_ATTR DualGpioDetector::fault_(int index) {
+  Input &input = this->inputs_[index];
+  input.faults++;
+  input.agree_run = 0;
+  if (input.fault_run < 255) {
+    input.fault_run++;
+  }
+  // Two inputs cannot outvote each other's absence: the last voted-in input stays in
+  if (input.voted_in && input.fault_run >= DUAL_VOTE_OUT_FAULTS && this->inputs_[index ^ 1].voted_in) {
+    input.voted_in = false;
+    input.votes_out++;
+  }
+}
+
+void IRAM_ATTR DualGpioDetector::agree_(int index) {
+  Input &input = this->inputs_[index];
+  input.fault_run = 0;
+  if (!input.voted_in && ++input.agree_run >= DUAL_READMIT_EDGES) {
+    input.voted_in = true;
+    input.agree_run = 0;
+  }
+}
+
+void IRAM_ATTR DualGpioDetector::count_at_(int index, uint32_t now_us) {
+  uint32_t lag = this->lag_of_(index);
+  uint32_t reference_us = now_us - lag;
+  this->edge_lag_us_ = lag;
+  if (this->has_counted_) {
+    // Reference timeline: intervals stay exact across a change of counting input
+    this->tracker_->add_interval(reference_us - this->counted_us_);
+  }
+  this->counted_us_ = reference_us;
+  this->has_counted_ = true;
+  this->tracker_->edge_count++;
+}
+
+bool IRAM_ATTR DualGpioDetector::vote_edge_(int index, uint32_t now_us) {
+  Input &input = this->inputs_[index];
+  int other = index ^ 1;
+  input.edges++;
+  uint32_t interval = now_us - input.last_us;
+  uint32_t half_us = this->tracker_->half_cycle_q4 >> 4;
+
+  if (this->pending_input_ == other && now_us - this->pending_us_ <= DUAL_PAIR_WINDOW_US) {
+    // Partner of the edge the other input already reported
+    this->pending_input_ = -1;
+    input.last_us = now_us;
+    int32_t delta = static_cast<int32_t>(now_us - this->pending_us_);
+    int32_t offset_us = (index == 1) ? delta : -delta;  // Secondary minus primary
+    if (this->offset_pairs_ < DUAL_OFFSET_LEARN_PAIRS) {
+      // Learning: running mean of the first pairs, no phase vote yet
+      this->offset_pairs_++;
+      this->offset_q4_ += (offset_us * 16 - this->offset_q4_) / this->offset_pairs_;
+      this->agree_(index);
+      this->agree_(other);
+    } else {
+      int32_t error = offset_us - this->offset_q4_ / 16;
+      if (error > DUAL_PHASE_TOLERANCE_US || error < -DUAL_PHASE_TOLERANCE_US) {
+        this->disagreements_++;
+        if (half_us > 0) {
+          // The edge farther from the tracked mains timeline is the faulty one
+          uint32_t own = (interval > half_us) ? interval - half_us : half_us - interval;
+          uint32_t theirs = (this->pending_interval_ > half_us) ? this->pending_interval_ - half_us
+                                                                 : half_us - this->pending_interval_;
+          this->fault_((own > theirs) ? index : other);
+        }
+      } else {
+        this->offset_q4_ += (offset_us * 16 - this->offset_q4_) >> DUAL_OFFSET_FILTER_SHIFT;
+        this->agree_(index);
+        this->agree_(other);
+      }
+    }
+    if (!this->pending_counted_ && input.voted_in) {
+      // The first arrival came from a voted-out input: count the half-cycle here
+      this->count_at_(index, now_us);
+      return true;
+    }
+    return false;
+  }
+
+  if (this->pending_input_ >= 0) {
+    // The previous edge found no partner: the input that should have reported it missed it
+    this->fault_(this->pending_input_ ^ 1);
+    this->pending_input_ = -1;
+  }
+
+  // Timing gate on the reference timeline: closer than 3/4 half-cycle (hold-off until locked) is noise
+  uint32_t gate_us = (half_us > 0) ? half_us - (half_us >> 2) : EDGE_HOLDOFF_US;
+  if (this->has_counted_ && now_us - this->lag_of_(index) - this->counted_us_ < gate_us) {
+    this->glitch_count_++;
+    this->fault_(index);
+    return false;
+  }
+
+  this->pending_input_ = index;
+  this->pending_us_ = now_us;
+  this->pending_interval_ = interval;
+  this->pending_counted_ = input.voted_in;
+  input.last_us = now_us;
+  if (!input.voted_in) {
+    return false;
+  }
+  this->count_at_(index, now_us);
+  return true;
+}
+
+void DualGpioDetector::dump_config() const {
+  ESP_LOGCONFIG(TAG, "  Edge source: GPIO%d and GPIO%d rising edge interrupts, voted software count",
+                this->inputs_[0].pin, this->inputs_[1].pin);
+  ESP_LOGCONFIG(TAG, "  Voting: pair within %d us, phase tolerance %d us, out after %d faults, back after %d edges",
+                DUAL_PAIR_WINDOW_US, DUAL_PHASE_TOLERANCE_US, DUAL_VOTE_OUT_FAULTS, DUAL_READMIT_EDGES);
+}
+
+void DualGpioDetector::log_statistics() const {
+  for (int i = 0; i < 2; i++) {
+    const Input &input = this->inputs_[i];
+    ESP_LOGI(TAG, "   ├─ %s input GPIO%d: %s, %u edges, %u faults, voted out %u times", (i == 0) ? "Primary" : "Secondary",
+             input.pin, input.voted_in ? "voted in" : "⚠️ VOTED OUT", static_cast<uint32_t>(input.edges),
+             static_cast<uint32_t>(input.faults), static_cast<uint32_t>(input.votes_out));
+  }
+  ESP_LOGI(TAG, "   ├─ Input phase offset: %.1f us (secondary - primary), %u pairs out of tolerance, %u gated edges",
+           static_cast<float>(this->offset_q4_) / 16.0f, static_cast<uint32_t>(this->disagreements_),
+           static_cast<uint32_t>(this->glitch_count_));
+}
+
+#if SOC_ETM_SUPPORTED && SOC_GPTIMER_SUPPORT_ETM
+// ========================================
+// ETM Capture Detector
+// GPIO edge → ETM → GPTimer capture latches the timestamp in hardware; the GPIO ISR counts
+// the edge and reads the latch, so intervals are exact even if the ISR runs late.
+// ========================================
+bool EtmCaptureDetector::setup(gpio_num_t pin, HalfCyclePeriodTracker *tracker) {
+  this->pin_ = pin;
+  this->tracker_ = tracker;
+
+  ESP_LOGI(TAG, "Step 3: Creating free-running GPTimer for ETM timestamps (%d Hz)...", TIMER_RESOLUTION_HZ);
+  gptimer_config_t timer_config = {
+      .clk_src = GPTIMER_CLK_SRC_DEFAULT,
+      .direction = GPTIMER_COUNT_UP,
+      .resolution_hz = TIMER_RESOLUTION_HZ,
+      .intr_priority = 0,
+      .flags = {
+          .intr_shared = false,
+      },
+  };
+  esp_err_t err = gptimer_new_timer(&timer_config, &this->timer_);
+  if (err == ESP_OK) {
+    err = gptimer_enable(this->timer_);
+  }
+  if (err == ESP_OK) {
+    err = gptimer_start(this->timer_);
+  }
+  if (err != ESP_OK) {
+    ESP_LOGE(TAG, "❌ Failed to start timestamp GPTimer: %s", esp_err_to_name(err));
+    return false;
+  }
+
+  ESP_LOGI(TAG, "Step 4: Connecting GPIO%d rising edge → ETM → GPTimer capture...", pin);
+  gpio_etm_event_config_t event_config = {};
+  event_config.edge = GPIO_ETM_EVENT_EDGE_POS;
+  err = gpio_new_etm_event(&event_config, &this->gpio_event_);
+  if (err == ESP_OK) {
+    err = gpio_etm_event_bind_gpio(this->gpio_event_, pin);
+  }
+  gptimer_etm_task_config_t task_config = {};
+  task_config.task_type = GPTIMER_ETM_TASK_CAPTURE;
+  if (err == ESP_OK) {
+    err = gptimer_new_etm_task(this->timer_, &task_config, &this->capture_task_);
+  }
+  esp_etm_channel_config_t channel_config = {};
+  if (err == ESP_OK) {
+    err = esp_etm_new_channel(&channel_config, &this->etm_channel_);
+  }
+  if (err == ESP_OK) {
+    err = esp_etm_channel_connect(this->etm_channel_, this->gpio_event_, this->capture_task_);
+  }
+  if (err == ESP_OK) {
+    err = esp_etm_channel_enable(this->etm_channel_);
+  }
+  if (err != ESP_OK) {
+    ESP_LOGE(TAG, "❌ Failed to set up ETM capture: %s", esp_err_to_name(err));
+    return false;
+  }
+
+  ESP_LOGI(TAG, "Step 5: Installing GPIO ISR service and rising edge interrupt...");
+  err = gpio_install_isr_service(ESP_INTR_FLAG_IRAM | (1 << INTERRUPT_PRIORITY));
+  if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) {
+    ESP_LOGE(TAG, "❌ Failed to install GPIO ISR service: %s", esp_err_to_name(err));
+    return false;
+  }
+  err = gpio_set_intr_type(pin, GPIO_INTR_POSEDGE);
+  if (err != ESP_OK) {
+    ESP_LOGE(TAG, "❌ Failed to set GPIO%d interrupt type: %s", pin, esp_err_to_name(err));
+    return false;
+  }
+  ESP_LOGI(TAG, "✓ ETM capture ready (hardware timestamp, software count)");
+  return true;
+}
+
+esp_err_t EtmCaptureDetector::start_(gpio_isr_t isr) {
+  ESP_LOGI(TAG, "Step 7-8: Attaching edge handler and starting software count...");
+  this->count_ = 0;
+  esp_err_t err = gpio_isr_handler_add(this->pin_, isr, this);
+  if (err == ESP_OK) {
+    err = gpio_intr_enable(this->pin_);
+  }
+  if (err != ESP_OK) {
+    ESP_LOGE(TAG, "❌ Failed to attach GPIO%d edge handler: %s", this->pin_, esp_err_to_name(err));
+    return err;
+  }
+  ESP_LOGI(TAG, "✓ ETM capture counting from 0");
+  return ESP_OK;
+}
+
+void IRAM_ATTR EtmCaptureDetector::track_rising_edge_(uint32_t edge_us) {
+  if (this->has_rise_) {
+    this->tracker_->add_interval(edge_us - this->last_rise_us_);
+  }
+  this->last_rise_us_ = edge_us;
+  this->has_rise_ = true;
+  this->tracker_->edge_count++;
+}
+
+void EtmCaptureDetector::dump_config() const {
+  ESP_LOGCONFIG(TAG, "  Edge source: GPIO%d → ETM → GPTimer capture (1us hardware timestamps), software count",
+                this->pin_);
+  ESP_LOGCONFIG(TAG, "  Glitch filter: %u us hold-off, plausible half-cycle %d-%d us", this->tracker_->holdoff_us(),
+                CAPTURE_MIN_HALF_CYCLE_US, CAPTURE_MAX_HALF_CYCLE_US);
+}
+
+void EtmCaptureDetector::log_statistics() const {
+  ESP_LOGI(TAG, "   ├─ Edges rejected by hold-off: %u", static_cast<uint32_t>(this->glitch_count_));
+}
+#endif
+
+#if SOC_MCPWM_SUPPORTED
+// ========================================
+// MCPWM Capture Detector
+// Edge timestamps are latched by the capture unit, so intervals are exact even if the ISR runs late.
+// Rising → rising: half-cycle period (filtered) + software count, rising → falling: pulse width.
+// ========================================
+bool McpwmCaptureDetector::setup(gpio_num_t pin, HalfCyclePeriodTracker *tracker) {
+  this->tracker_ = tracker;
+  ESP_LOGI(TAG, "Step 3-5: Creating MCPWM capture channel on GPIO%d (both edges)...", pin);
+
+  // Capture timer runs from the default (APB) clock; read back the actual resolution
+  mcpwm_capture_timer_config_t timer_config = {};
+  timer_config.group_id = 0;
+  timer_config.clk_src = MCPWM_CAPTURE_CLK_SRC_DEFAULT;
+  esp_err_t err = mcpwm_new_capture_timer(&timer_config, &this->timer_);
+  if (err != ESP_OK) {
+    ESP_LOGE(TAG, "❌ Failed to create MCPWM capture timer: %s", esp_err_to_name(err));
+    return false;
+  }
+
+  uint32_t resolution_hz = 0;
+  err = mcpwm_capture_timer_get_resolution(this->timer_, &resolution_hz);
+  if (err != ESP_OK || resolution_hz < 1000000) {
+    ESP_LOGE(TAG, "❌ Unusable MCPWM capture resolution (%u Hz)", resolution_hz);
+    return false;
+  }
+  this->ticks_per_us_ = resolution_hz / 1000000;
+
+  mcpwm_capture_channel_config_t channel_config = {};
+  channel_config.gpio_num = pin;
+  channel_config.intr_priority = INTERRUPT_PRIORITY;
+  channel_config.prescale = 1;
+  channel_config.flags.pos_edge = true;
+  channel_config.flags.neg_edge = true;
+  channel_config.flags.keep_io_conf_at_exit = true;
+  err = mcpwm_new_capture_channel(this->timer_, &channel_config, &this->channel_);
+  if (err != ESP_OK) {
+    ESP_LOGE(TAG, "❌ Failed to create MCPWM capture channel: %s", esp_err_to_name(err));
+    return false;
+  }
+  ESP_LOGI(TAG, "✓ MCPWM capture channel ready (%u ticks/us)", this->ticks_per_us_);
+  return true;
+}
+
+esp_err_t McpwmCaptureDetector::start_(mcpwm_capture_event_cb_t callback) {
+  ESP_LOGI(TAG, "Step 7-8: Registering capture callback and starting capture timer...");
+  this->count_ = 0;
+  mcpwm_capture_event_callbacks_t callbacks = {
+      .on_cap = callback,
+  };
+  esp_err_t err = mcpwm_capture_channel_register_event_callbacks(this->channel_, &callbacks, (void *) this);
+  if (err == ESP_OK) {
+    err = mcpwm_capture_channel_enable(this->channel_);
+  }
+  if (err == ESP_OK) {
+    err = mcpwm_capture_timer_enable(this->timer_);
+  }
+  if (err == ESP_OK) {
+    err = mcpwm_capture_timer_start(this->timer_);
+  }
+  if (err != ESP_OK) {
+    ESP_LOGE(TAG, "❌ Failed to start MCPWM capture: %s", esp_err_to_name(err));
+    return err;
+  }
+  ESP_LOGI(TAG, "✓ MCPWM capture counting from 0 (hardware edge timestamps)");
+  return ESP_OK;
+}
+
+void IRAM_ATTR McpwmCaptureDetector::track_rising_edge_(uint32_t ticks) {
+  if (this->has_rise_) {
+    this->tracker_->add_interval((ticks - this->last_rise_ticks_) / this->ticks_per_us_);
+  }
+  this->last_rise_ticks_ = ticks;
+  this->has_rise_ = true;
+  this->tracker_->edge_count++;
+}
+
+void IRAM_ATTR McpwmCaptureDetector::track_falling_edge_(uint32_t ticks) {
+  if (this->has_rise_) {
+    this->tracker_->pulse_width_us = (ticks - this->last_rise_ticks_) / this->ticks_per_us_;
+  }
+}
+
+void McpwmCaptureDetector::dump_config() const {
+  ESP_LOGCONFIG(TAG, "  Edge source: MCPWM capture, both edges (%u ticks/us), software count", this->ticks_per_us_);
+  ESP_LOGCONFIG(TAG, "  Glitch filter: %u us hold-off, plausible half-cycle %d-%d us", this->tracker_->holdoff_us(),
+                CAPTURE_MIN_HALF_CYCLE_US, CAPTURE_MAX_HALF_CYCLE_US);
+}
+
+void McpwmCaptureDetector::log_statistics() const {
+  ESP_LOGI(TAG, "   ├─ Edges rejected by hold-off: %u", static_cast<uint32_t>(this->glitch_count_));
+}
+#endif
+
+// ========================================
+// GPTimer Output
+// ========================================
+bool GptimerOutput::setup(gpio_num_t relay_pin, gpio_num_t zero_cross_pin, int initial_level) {
+  ESP_LOGI(TAG, "Step 9: Creating GPTimer for the switch delay (Core %d, Priority %d)...",
+           INTERRUPT_CPU_CORE, INTERRUPT_PRIORITY);
+  this->pin_ = relay_pin;
+  this->written_level_ = initial_level;
+  this->delay_us_ = NOMINAL_SWITCH_DELAY_US;
+
+  gptimer_config_t timer_config = {
+      .clk_src = GPTIMER_CLK_SRC_DEFAULT,
+      .direction = GPTIMER_COUNT_UP,
+      .resolution_hz = TIMER_RESOLUTION_HZ,  // 1MHz = 1us per tick
+      .intr_priority = INTERRUPT_PRIORITY,   // 🔴 Highest priority (1-3 on ESP32)
+      .flags = {
+          .intr_shared = false,
+      },
   };
-  
-  err = gptimer_set_alarm_action(this->delay_timer_, &alarm_config);
+
+  esp_err_t err = gptimer_new_timer(&timer_config, &this->timer_);
+  if (err != ESP_OK) {
+    ESP_LOGE(TAG, "❌ Failed to create GPTimer: %s", esp_err_to_name(err));
+    return false;
+  }
+
+  // Register timer alarm callback (bind to Core 1); the alarm itself is armed per queued event
+  gptimer_event_callbacks_t timer_callbacks = {
+      .on_alarm = on_alarm_,
+  };
+
+  err = gptimer_register_event_callbacks(this->timer_, &timer_callbacks, (void *)this);
+  if (err != ESP_OK) {
+    ESP_LOGE(TAG, "❌ Failed to register timer callbacks: %s", esp_err_to_name(err));
+    return false;
+  }
+
+  err = gptimer_enable(this->timer_);
+  if (err != ESP_OK) {
+    ESP_LOGE(TAG, "❌ Failed to enable GPTimer: %s", esp_err_to_name(err));
+    return false;
+  }
+
+  // Free-running timeline: never stopped or reset, so overlapping events cannot cancel each other
+  err = gptimer_start(this->timer_);
+  if (err != ESP_OK) {
+    ESP_LOGE(TAG, "❌ Failed to start GPTimer: %s", esp_err_to_name(err));
+    return false;
+  }
+
+  // 🔴 Bind GPTimer interrupt to Core 1 (away from WiFi on Core 0)
+  // Note: ESP-IDF allocates interrupt on the core that calls gptimer_enable()
+  // To ensure Core 1 binding, we can set interrupt affinity explicitly
+  ESP_LOGI(TAG, "✓ GPTimer configured (free-running, %d event queue, %dus nominal delay, Core %d, Priority %d)",
+           GPTIMER_QUEUE_DEPTH, NOMINAL_SWITCH_DELAY_US, INTERRUPT_CPU_CORE, INTERRUPT_PRIORITY);
+  return true;
+}
+
+void IRAM_ATTR GptimerOutput::push_(uint64_t time, int level) {
+  this->events_++;
+  // The newest command wins: anything queued at or after its time was commanded earlier and is stale
+  while (this->queue_count_ > 0 && this->queue_[this->queue_count_ - 1].time >= time) {
+    this->queue_count_--;
+    this->superseded_++;
+  }
+  if (this->queue_count_ == GPTIMER_QUEUE_DEPTH) {
+    // Keep the imminent transitions and the final level, lose the intermediate newest one
+    this->queue_count_--;
+    this->overflows_++;
+  }
+  this->queue_[this->queue_count_].time = time;
+  this->queue_[this->queue_count_].level = level;
+  this->queue_count_++;
+}
+
+void IRAM_ATTR GptimerOutput::arm_head_() {
+  if (this->queue_count_ == 0) {
+    return;
+  }
+  // An alarm count already behind the timer fires at once
+  gptimer_alarm_config_t alarm_config = {};
+  alarm_config.alarm_count = this->queue_[0].time;
+  this->check_(gptimer_set_alarm_action(this->timer_, &alarm_config));
+}
+
+bool IRAM_ATTR GptimerOutput::apply_due_(uint64_t now) {
+  uint8_t due = 0;
+  while (due < this->queue_count_ && this->queue_[due].time <= now) {
+    due++;
+  }
+  if (due == 0) {
+    return false;
+  }
+  if (due > 1) {
+    this->late_ += due - 1;  // Intermediate levels would only be a glitch this late
+  }
+  int level = this->queue_[due - 1].level;
+  for (uint8_t i = due; i < this->queue_count_; i++) {
+    this->queue_[i - due] = this->queue_[i];
+  }
+  this->queue_count_ -= due;
+
+  gpio_set_level(this->pin_, level);
+  this->written_level_ = level;
+  RelaySwitchLog *log = this->switch_log_;
+  if (log != nullptr && level != log->level) {
+    log->time_us = static_cast<uint32_t>(esp_timer_get_time());
+    log->level = level;
+    log->count++;
+  }
+  return true;
+}
+
+// ========================================
+// GPTimer Alarm Interrupt Callback (ISR Context)
+// Triggered at the earliest queued event on the free-running timeline
+// Writes the due level and re-arms the alarm for the next queued event
+// Must use IRAM_ATTR to ensure execution in IRAM
+// ========================================
+bool IRAM_ATTR GptimerOutput::on_alarm_(gptimer_handle_t timer, const gptimer_alarm_event_data_t *edata,
+                                        void *user_ctx) {
+  GptimerOutput *output = static_cast<GptimerOutput *>(user_ctx);
+
+  portENTER_CRITICAL_ISR(&output->lock_);
+  // Read the live count so events that fell due while entering the ISR go out in this pass
+  uint64_t now = edata->count_value;
+  output->check_(gptimer_get_raw_count(timer, &now));
+  output->apply_due_(now);
+  output->arm_head_();
+  portEXIT_CRITICAL_ISR(&output->lock_);
+
+  // Return false: no need to wake higher priority task
+  return false;
+}
+
+void GptimerOutput::update(int flip_point, uint32_t half_cycle_us, uint32_t delay_us, bool synced) {
+  this->delay_us_ = delay_us;
+
+  uint64_t now = 0;
+  esp_err_t err = gptimer_get_raw_count(this->timer_, &now);
+  this->check_(err);
+  if (err != ESP_OK) {
+    return;
+  }
+
+  bool recovered = false;
+  bool repaired = false;
+  portENTER_CRITICAL(&this->lock_);
+  if (this->queue_count_ > 0 && now > this->queue_[0].time + GPTIMER_STUCK_US) {
+    // Alarm never fired (lost interrupt, failed re-arm): apply what is due here and arm again
+    this->apply_due_(now);
+    this->arm_head_();
+    this->stuck_recoveries_++;
+    recovered = true;
+  } else if (synced && this->queue_count_ == 0 && this->written_level_ >= 0 &&
+             gpio_get_level(this->pin_) != this->written_level_) {
+    // Nothing pending, yet the pad disagrees with the last written level
+    gpio_set_level(this->pin_, this->written_level_);
+    this->level_repairs_++;
+    repaired = true;
+  }
+  portEXIT_CRITICAL(&this->lock_);
+
+  if (recovered) {
+    ESP_LOGW(TAG, "⚠️ GPTimer alarm missed by more than %d ms, overdue relay event applied",
+             GPTIMER_STUCK_US / 1000);
+  }
+  if (repaired && !this->level_fault_) {
+    ESP_LOGW(TAG, "⚠️ Relay GPIO%d read back at the wrong level, rewritten", this->pin_);
+  }
+  this->level_fault_ = repaired;
+}
+
+void GptimerOutput::dump_config() const {
+  ESP_LOGCONFIG(TAG, "  Relay output: GPTimer free-running, %d event queue (stuck after %d ms)", GPTIMER_QUEUE_DEPTH,
+                GPTIMER_STUCK_US / 1000);
+}
+
+void GptimerOutput::log_statistics() const {
+  ESP_LOGI(TAG, "   ├─ GPTimer events: %u (superseded: %u, overflow: %u, late: %u)",
+           static_cast<uint32_t>(this->events_), static_cast<uint32_t>(this->superseded_),
+           static_cast<uint32_t>(this->overflows_), static_cast<uint32_t>(this->late_));
+  if (this->errors_ > 0) {
+    ESP_LOGI(TAG, "   ├─ GPTimer driver errors: %u (last: %s)", static_cast<uint32_t>(this->errors_),
+             esp_err_to_name(this->last_error_));
+  }
+  ESP_LOGI(TAG, "   ├─ Stuck alarm recoveries: %u, relay level repairs: %u", this->stuck_recoveries_,
+           this->level_repairs_);
+}
+
+#if SOC_RMT_SUPPORTED
+// ========================================
+// RMT Output
+// ========================================
+bool RmtOutput::setup(gpio_num_t relay_pin, gpio_num_t zero_cross_pin, int initial_level) {
+  ESP_LOGI(TAG, "Step 9: Creating RMT TX channel on GPIO%d (%d Hz resolution)...", relay_pin, RMT_RESOLUTION_HZ);
+
+  rmt_tx_channel_config_t tx_config = {};
+  tx_config.gpio_num = relay_pin;
+  tx_config.clk_src = RMT_CLK_SRC_DEFAULT;
+  tx_config.resolution_hz = RMT_RESOLUTION_HZ;
+  tx_config.mem_block_symbols = SOC_RMT_MEM_WORDS_PER_CHANNEL;
+  tx_config.trans_queue_depth = 2;
+  tx_config.intr_priority = INTERRUPT_PRIORITY;
+
+  esp_err_t err = rmt_new_tx_channel(&tx_config, &this->channel_);
   if (err != ESP_OK) {
-    ESP_LOGE(TAG, "❌ Failed to set timer alarm: %s", esp_err_to_name(err));
-    this->mark_failed();
-    return;
+    ESP_LOGE(TAG, "❌ Failed to create RMT TX channel: %s", esp_err_to_name(err));
+    return false;
   }
-  
-  // Register timer alarm callback (bind to Core 1)
-  gptimer_event_callbacks_t timer_callbacks = {
-      .on_alarm = timer_alarm_callback,
-  };
-  
-  err = gptimer_register_event_callbacks(this->delay_timer_, &timer_callbacks, (void *)this);
+
+  rmt_copy_encoder_config_t encoder_config = {};
+  err = rmt_new_copy_encoder(&encoder_config, &this->encoder_);
   if (err != ESP_OK) {
-    ESP_LOGE(TAG, "❌ Failed to register timer callbacks: %s", esp_err_to_name(err));
-    this->mark_failed();
-    return;
+    ESP_LOGE(TAG, "❌ Failed to create RMT copy encoder: %s", esp_err_to_name(err));
+    return false;
   }
-  
-  // Enable timer (but don't start yet - will be started by PCNT ISR)
-  err = gptimer_enable(this->delay_timer_);
+
+  err = rmt_enable(this->channel_);
   if (err != ESP_OK) {
-    ESP_LOGE(TAG, "❌ Failed to enable GPTimer: %s", esp_err_to_name(err));
-    this->mark_failed();
-    return;
+    ESP_LOGE(TAG, "❌ Failed to enable RMT channel: %s", esp_err_to_name(err));
+    return false;
   }
-  
-  // 🔴 Bind GPTimer interrupt to Core 1 (away from WiFi on Core 0)
-  // Note: ESP-IDF allocates interrupt on the core that calls gptimer_enable()
-  // To ensure Core 1 binding, we can set interrupt affinity explicitly
-  ESP_LOGI(TAG, "✓ GPTimer configured (one-shot, %dus delay, Core %d, Priority %d)", 
-           TIMER_DELAY_US, INTERRUPT_CPU_CORE, INTERRUPT_PRIORITY);
-  
-  ESP_LOGI(TAG, "");
-  ESP_LOGI(TAG, "✅ Zero-Cross Relay initialized successfully!");
-  ESP_LOGI(TAG, "   ├─ Input: GPIO%d (rising edge counts)", this->zero_cross_gpio_num_);
-  ESP_LOGI(TAG, "   ├─ Output: GPIO%d (controlled via delayed timer)", this->relay_output_gpio_num_);
-  ESP_LOGI(TAG, "   ├─ Count range: %d-%d (auto-clear at %d)", 
-           PCNT_LOW_LIMIT, PCNT_HIGH_LIMIT, PCNT_HIGH_LIMIT);
-  ESP_LOGI(TAG, "   ├─ Interrupt config: Core %d (APP_CPU), Priority %d (highest)", 
-           INTERRUPT_CPU_CORE, INTERRUPT_PRIORITY);
-  float current_duty_percentage =
-      (static_cast<float>(this->duty_cycle_flip_point_) / static_cast<float>(PCNT_HIGH_LIMIT)) * 100.0f;
-  ESP_LOGI(TAG, "   ├─ Duty cycle: %.1f%% (flip point=%d, range: 0-%d)", 
-           current_duty_percentage, this->duty_cycle_flip_point_, PCNT_HIGH_LIMIT);
-  if (this->duty_cycle_flip_point_ > 0 && this->duty_cycle_flip_point_ < PCNT_HIGH_LIMIT) {
-    ESP_LOGI(TAG, "   ├─ Watch point 1: Count=%d → Start timer → %dus → GPIO4 LOW", 
-             this->duty_cycle_flip_point_, TIMER_DELAY_US);
-  } else if (this->duty_cycle_flip_point_ == 0) {
-    ESP_LOGI(TAG, "   ├─ Watch point 1: disabled (relay held LOW / 0%% duty)");
-  } else {
-    ESP_LOGI(TAG, "   ├─ Watch point 1: disabled (relay held HIGH / 100%% duty)");
+
+  // Park the pin at the initial level (the channel idles at its EOT level between windows)
+  this->symbols_[0].duration0 = 1;
+  this->symbols_[0].level0 = initial_level;
+  this->symbols_[0].duration1 = 1;
+  this->symbols_[0].level1 = initial_level;
+  rmt_transmit_config_t transmit_config = {};
+  transmit_config.loop_count = 0;
+  transmit_config.flags.eot_level = initial_level;
+  err = rmt_transmit(this->channel_, this->encoder_, this->symbols_, sizeof(rmt_symbol_word_t), &transmit_config);
+  if (err != ESP_OK) {
+    ESP_LOGE(TAG, "❌ Failed to set initial RMT level: %s", esp_err_to_name(err));
+    return false;
   }
-  ESP_LOGI(TAG, "   └─ Watch point 2: Count=%d → Start timer → %dus → GPIO4 HIGH + clear", 
-           PCNT_HIGH_LIMIT, TIMER_DELAY_US);
+  this->level_ = initial_level;
+  ESP_LOGI(TAG, "✓ RMT TX channel ready (one refill per window, phase-relative switch delay)");
+  return true;
 }
 
-void ZeroCrossRelayComponent::loop() {
-  if (this->watch_point_update_event_) {
-    bool success = (this->last_watch_point_update_err_ == ESP_OK);
-    if (success) {
-      float duty_percentage =
-          (static_cast<float>(this->duty_cycle_flip_point_) / static_cast<float>(PCNT_HIGH_LIMIT)) * 100.0f;
-      ESP_LOGI(TAG, "Duty cycle watch point updated to %.1f%% (flip point %d).",
-               duty_percentage, this->duty_cycle_flip_point_);
-    } else {
-      int pending = this->pending_duty_cycle_flip_point_;
-      if (pending < 0) {
-        pending = this->duty_cycle_flip_point_;
-      }
-      ESP_LOGE(TAG, "Failed to update duty cycle watch point to %d: %s", pending,
-               esp_err_to_name(this->last_watch_point_update_err_));
-    }
-    this->watch_point_update_event_ = false;
+// ========================================
+// RMT Window Refill (Worker Task Context)
+// Encodes the window that just started as one timeline:
+//   [previous level: lead] [half-cycle 0 level: T] ... [half-cycle N-1 level: T]
+// lead = switch delay minus the time already spent since the boundary edge,
+// T = measured half-cycle period. Equal runs are merged, runs longer than the 15-bit
+// duration field are split, and the final level is held by the channel's EOT level.
+// ========================================
+void RmtOutput::refill(uint64_t pattern, int length, uint32_t half_cycle_us, uint32_t delay_us,
+                       uint32_t boundary_time) {
+  // Compensate the task dispatch latency so the first transition still lands one switch delay after the edge
+  // (the reference edge, when a redundant detector counted a lagging input)
+  if (this->edge_lag_ != nullptr) {
+    boundary_time -= *this->edge_lag_;
   }
-  
-  // ========================================
-  // Periodic status logging (every 5 seconds)
-  // ========================================
-  
-  static uint32_t last_log_time = 0;
-  uint32_t current_time = millis();
-  
-  // Output statistics every 5 seconds
-  if (current_time - last_log_time > 5000) {
-    last_log_time = current_time;
-    
-    // Read current PCNT count
-    int pcnt_count = 0;
-    esp_err_t err = pcnt_unit_get_count(this->pcnt_unit_, &pcnt_count);
-    
-    if (err == ESP_OK) {
-      // Get cycle statistics from ISR (atomic read)
-      uint32_t total_triggers = this->trigger_count_;
-      uint32_t total_cycles = this->cycle_count_;
-      
-      // Calculate cycle time if we have at least one complete cycle
-      float cycle_time_ms = 0.0f;
-      if (total_cycles > 1 && this->last_cycle_time_ > 0) {
-        // Get cycle time in milliseconds (us → ms)
-        cycle_time_ms = (float)this->last_cycle_time_ / 1000.0f;
-        
-        // Calculate estimated AC frequency
-        // Logic:
-        // - 20 zero-cross pulses per cycle (PCNT counts 0→20)
-        // - For 50Hz AC: 100 zero-cross points/second
-        // - So 20 pulses = 20/100 = 0.2 seconds = 200ms
-        // - Frequency = (20 pulses) / (cycle_time_seconds) / 2
-        // - Formula: freq = 20 / (cycle_time_ms / 1000) / 2 = 10000 / cycle_time_ms
-        if (cycle_time_ms > 0) {
-          this->estimated_frequency_ = 10000.0f / cycle_time_ms;
-        }
-      }
-      
-      ESP_LOGI(TAG, "📊 PCNT Zero-Cross Statistics:");
-      ESP_LOGI(TAG, "   ├─ Current count: %d / %d", pcnt_count, PCNT_HIGH_LIMIT);
-      ESP_LOGI(TAG, "   ├─ Duty cycle: %.1f%% (flip point: %d)", 
-               (static_cast<float>(this->duty_cycle_flip_point_) / static_cast<float>(PCNT_HIGH_LIMIT)) * 100.0f,
-               this->duty_cycle_flip_point_);
-      ESP_LOGI(TAG, "   ├─ Total watch point triggers: %u", total_triggers);
-      ESP_LOGI(TAG, "   ├─ Complete cycles (20-count): %u", total_cycles);
-      if (cycle_time_ms > 0) {
-        ESP_LOGI(TAG, "   ├─ Last cycle time: %.2f ms", cycle_time_ms);
-        ESP_LOGI(TAG, "   └─ Estimated AC frequency: %.2f Hz", this->estimated_frequency_);
+  uint32_t elapsed_us = static_cast<uint32_t>(esp_timer_get_time()) - boundary_time;
+  uint32_t lead_us = 1;
+  if (elapsed_us < delay_us) {
+    lead_us = delay_us - elapsed_us;
+  } else {
+    this->late_count_++;
+  }
+
+  size_t pieces = 0;  // Half-symbols written (two per rmt_symbol_word_t)
+  auto emit = [this, &pieces](int level, uint32_t duration) {
+    while (duration > 0 && pieces < 2 * RMT_MAX_WINDOW_SYMBOLS) {
+      uint32_t chunk = (duration > RMT_MAX_DURATION) ? RMT_MAX_DURATION : duration;
+      rmt_symbol_word_t &symbol = this->symbols_[pieces / 2];
+      if ((pieces & 1) == 0) {
+        symbol.duration0 = chunk;
+        symbol.level0 = level;
       } else {
-        ESP_LOGI(TAG, "   └─ (Waiting for first complete cycle...)");
+        symbol.duration1 = chunk;
+        symbol.level1 = level;
       }
+      pieces++;
+      duration -= chunk;
+    }
+  };
+
+  int level = this->level_;
+  uint32_t run_us = lead_us;
+  for (int i = 0; i < length; i++) {
+    int bit = static_cast<int>((pattern >> i) & 1ULL);
+    if (bit == level) {
+      run_us += half_cycle_us;
+      continue;
     }
+    emit(level, run_us);
+    level = bit;
+    run_us = half_cycle_us;
+  }
+
+  if (pieces == 0) {
+    // No transition this window: the channel already idles at the right level
+    return;
+  }
+
+  // Final transition; the channel holds this level (EOT) until the next window
+  emit(level, 1);
+  if (pieces & 1) {
+    emit(level, 1);  // A zero duration would terminate the frame early, pad instead
+  }
+
+  rmt_transmit_config_t transmit_config = {};
+  transmit_config.loop_count = 0;
+  transmit_config.flags.eot_level = level;
+  esp_err_t err = rmt_transmit(this->channel_, this->encoder_, this->symbols_,
+                               (pieces / 2) * sizeof(rmt_symbol_word_t), &transmit_config);
+  if (err == ESP_OK) {
+    this->level_ = level;
+    this->refill_count_++;
   }
 }
 
-void ZeroCrossRelayComponent::dump_config() {
-  ESP_LOGCONFIG(TAG, "Zero Cross Detection Relay (PCNT + GPTimer Mode):");
-  ESP_LOGCONFIG(TAG, "  Zero-cross input: GPIO%d (PCNT edge counting)", this->zero_cross_gpio_num_);
-  ESP_LOGCONFIG(TAG, "  Relay output: GPIO%d (controlled by GPTimer delayed)", this->relay_output_gpio_num_);
-  ESP_LOGCONFIG(TAG, "  Count range: %d - %d (auto-clear at %d)", 
-                PCNT_LOW_LIMIT, PCNT_HIGH_LIMIT, PCNT_HIGH_LIMIT);
-  ESP_LOGCONFIG(TAG, "  Duty cycle control:");
-  float duty_percentage =
-      (static_cast<float>(this->duty_cycle_flip_point_) / static_cast<float>(PCNT_HIGH_LIMIT)) * 100.0f;
-  ESP_LOGCONFIG(TAG, "    ├─ Current duty cycle: %.1f%% (flip point: %d)", 
-                duty_percentage, this->duty_cycle_flip_point_);
-  ESP_LOGCONFIG(TAG, "    └─ Adjustable range: 0%% - 100%% (flip point: 0-%d)", PCNT_HIGH_LIMIT);
-  ESP_LOGCONFIG(TAG, "  Watch points (with %dus delay):", TIMER_DELAY_US);
-  if (this->duty_cycle_flip_point_ > 0 && this->duty_cycle_flip_point_ < PCNT_HIGH_LIMIT) {
-    ESP_LOGCONFIG(TAG, "    ├─ Point 1: Count=%d → GPIO%d LOW (relay off)", 
-                  this->duty_cycle_flip_point_, this->relay_output_gpio_num_);
-  } else if (this->duty_cycle_flip_point_ == 0) {
-    ESP_LOGCONFIG(TAG, "    ├─ Point 1: disabled (relay held LOW / 0%% duty)");
-  } else {
-    ESP_LOGCONFIG(TAG, "    ├─ Point 1: disabled (relay held HIGH / 100%% duty)");
+void RmtOutput::dump_config() const {
+  ESP_LOGCONFIG(TAG, "  Relay output: RMT window playback, one refill per window (switch delay lead)");
+}
+
+void RmtOutput::log_statistics() const {
+  ESP_LOGI(TAG, "   ├─ RMT refills: %u (late: %u)", static_cast<uint32_t>(this->refill_count_),
+           static_cast<uint32_t>(this->late_count_));
+}
+#endif
+
+#if SOC_MCPWM_SUPPORTED
+// ========================================
+// MCPWM Output
+// ========================================
+bool McpwmOutput::setup(gpio_num_t relay_pin, gpio_num_t zero_cross_pin, int initial_level) {
+  ESP_LOGI(TAG, "Step 9: Creating MCPWM phase control on GPIO%d (sync: GPIO%d rising edge)...", relay_pin,
+           zero_cross_pin);
+
+  mcpwm_timer_config_t timer_config = {};
+  timer_config.group_id = 0;
+  timer_config.clk_src = MCPWM_TIMER_CLK_SRC_DEFAULT;
+  timer_config.resolution_hz = MCPWM_RESOLUTION_HZ;
+  timer_config.count_mode = MCPWM_TIMER_COUNT_MODE_UP;
+  timer_config.period_ticks = MCPWM_PERIOD_TICKS;
+  timer_config.intr_priority = INTERRUPT_PRIORITY;
+  esp_err_t err = mcpwm_new_timer(&timer_config, &this->timer_);
+  if (err != ESP_OK) {
+    ESP_LOGE(TAG, "❌ Failed to create MCPWM timer: %s", esp_err_to_name(err));
+    return false;
   }
-  ESP_LOGCONFIG(TAG, "    └─ Point 2: Count=%d → GPIO%d HIGH (relay on) + clear count", 
-                PCNT_HIGH_LIMIT, this->relay_output_gpio_num_);
-  ESP_LOGCONFIG(TAG, "  Edge action: Rising edge +1, Falling edge HOLD");
-  ESP_LOGCONFIG(TAG, "  Glitch filter: %d ns", PCNT_GLITCH_FILTER_NS);
+
+  mcpwm_operator_config_t operator_config = {};
+  operator_config.group_id = 0;
+  operator_config.intr_priority = INTERRUPT_PRIORITY;
+  err = mcpwm_new_operator(&operator_config, &this->operator_);
+  if (err == ESP_OK) {
+    err = mcpwm_operator_connect_timer(this->operator_, this->timer_);
+  }
+  if (err != ESP_OK) {
+    ESP_LOGE(TAG, "❌ Failed to create MCPWM operator: %s", esp_err_to_name(err));
+    return false;
+  }
+
+  // Comparator values reload on sync, i.e. exactly at the next zero-cross edge
+  mcpwm_comparator_config_t comparator_config = {};
+  comparator_config.intr_priority = INTERRUPT_PRIORITY;
+  comparator_config.flags.update_cmp_on_tez = true;
+  comparator_config.flags.update_cmp_on_sync = true;
+  err = mcpwm_new_comparator(this->operator_, &comparator_config, &this->fire_comparator_);
+  if (err == ESP_OK) {
+    err = mcpwm_new_comparator(this->operator_, &comparator_config, &this->release_comparator_);
+  }
+  if (err != ESP_OK) {
+    ESP_LOGE(TAG, "❌ Failed to create MCPWM comparators: %s", esp_err_to_name(err));
+    return false;
+  }
+
+  mcpwm_generator_config_t generator_config = {};
+  generator_config.gen_gpio_num = relay_pin;
+  err = mcpwm_new_generator(this->operator_, &generator_config, &this->generator_);
+  if (err != ESP_OK) {
+    ESP_LOGE(TAG, "❌ Failed to create MCPWM generator: %s", esp_err_to_name(err));
+    return false;
+  }
+
+  // Hold LOW until the first update() sees zero-cross edges
+  mcpwm_generator_set_force_level(this->generator_, 0, true);
+  this->force_level_ = 0;
+
+  // Zero-cross edge → timer phase 0 → comparator A (HIGH) → comparator B (LOW)
+  err = mcpwm_generator_set_action_on_timer_event(
+      this->generator_,
+      MCPWM_GEN_TIMER_EVENT_ACTION(MCPWM_TIMER_DIRECTION_UP, MCPWM_TIMER_EVENT_EMPTY, MCPWM_GEN_ACTION_LOW));
+  if (err == ESP_OK) {
+    err = mcpwm_generator_set_action_on_timer_event(
+        this->generator_,
+        MCPWM_GEN_TIMER_EVENT_ACTION(MCPWM_TIMER_DIRECTION_UP, MCPWM_TIMER_EVENT_FULL, MCPWM_GEN_ACTION_LOW));
+  }
+  if (err == ESP_OK) {
+    err = mcpwm_generator_set_action_on_compare_event(
+        this->generator_,
+        MCPWM_GEN_COMPARE_EVENT_ACTION(MCPWM_TIMER_DIRECTION_UP, this->fire_comparator_, MCPWM_GEN_ACTION_HIGH));
+  }
+  if (err == ESP_OK) {
+    err = mcpwm_generator_set_action_on_compare_event(
+        this->generator_,
+        MCPWM_GEN_COMPARE_EVENT_ACTION(MCPWM_TIMER_DIRECTION_UP, this->release_comparator_, MCPWM_GEN_ACTION_LOW));
+  }
+  if (err != ESP_OK) {
+    ESP_LOGE(TAG, "❌ Failed to set MCPWM generator actions: %s", esp_err_to_name(err));
+    return false;
+  }
+
+  mcpwm_gpio_sync_src_config_t sync_config = {};
+  sync_config.group_id = 0;
+  sync_config.gpio_num = zero_cross_pin;  // Shared with the detector through the GPIO matrix
+  err = mcpwm_new_gpio_sync_src(&sync_config, &this->sync_source_);
+  if (err != ESP_OK) {
+    ESP_LOGE(TAG, "❌ Failed to create MCPWM GPIO sync source: %s", esp_err_to_name(err));
+    return false;
+  }
+
+  mcpwm_timer_sync_phase_config_t phase_config = {};
+  phase_config.sync_src = this->sync_source_;
+  phase_config.count_value = 0;
+  phase_config.direction = MCPWM_TIMER_DIRECTION_UP;
+  err = mcpwm_timer_set_phase_on_sync(this->timer_, &phase_config);
+  if (err != ESP_OK) {
+    ESP_LOGE(TAG, "❌ Failed to set MCPWM sync phase: %s", esp_err_to_name(err));
+    return false;
+  }
+
+  err = mcpwm_timer_enable(this->timer_);
+  if (err == ESP_OK) {
+    err = mcpwm_timer_start_stop(this->timer_, MCPWM_TIMER_START_NO_STOP);
+  }
+  if (err != ESP_OK) {
+    ESP_LOGE(TAG, "❌ Failed to start MCPWM timer: %s", esp_err_to_name(err));
+    return false;
+  }
+  ESP_LOGI(TAG, "✓ MCPWM running (period %d ticks, held LOW until zero-cross edges arrive)", MCPWM_PERIOD_TICKS);
+  return true;
+}
+
+void McpwmOutput::update(int flip_point, uint32_t half_cycle_us, uint32_t delay_us, bool synced) {
+  if (this->generator_ == nullptr) {
+    return;
+  }
+
+  int force_level = -1;
+  if (!synced || flip_point == 0) {
+    force_level = 0;
+  } else if (flip_point >= PCNT_HIGH_LIMIT) {
+    force_level = 1;
+  }
+
+  // Guards are phase fractions, so 60Hz or 400Hz supplies keep the same firing angles as 50Hz
+  uint32_t min_fire = static_cast<uint32_t>((static_cast<uint64_t>(half_cycle_us) * MCPWM_MIN_FIRE_Q16) >> 16);
+  uint32_t release =
+      half_cycle_us - static_cast<uint32_t>((static_cast<uint64_t>(half_cycle_us) * MCPWM_RELEASE_GUARD_Q16) >> 16);
+  if (release >= MCPWM_PERIOD_TICKS) {
+    release = MCPWM_PERIOD_TICKS - 1;
+  }
+  // Conduction angle proportional to the flip point: fire after (1 - duty) of the half-cycle
+  uint32_t fire = half_cycle_us * static_cast<uint32_t>(PCNT_HIGH_LIMIT - flip_point) / PCNT_HIGH_LIMIT;
+  if (fire < min_fire) {
+    fire = min_fire;
+  }
+  if (fire >= release) {
+    fire = release - 1;
+  }
+
+  if (fire != this->fire_ticks_) {
+    mcpwm_comparator_set_compare_value(this->fire_comparator_, fire);
+    this->fire_ticks_ = fire;
+  }
+  if (release != this->release_ticks_) {
+    mcpwm_comparator_set_compare_value(this->release_comparator_, release);
+    this->release_ticks_ = release;
+  }
+  if (force_level != this->force_level_) {
+    mcpwm_generator_set_force_level(this->generator_, force_level, true);
+    this->force_level_ = force_level;
+  }
+}
+
+void McpwmOutput::dump_config() const {
+  ESP_LOGCONFIG(TAG, "  Relay output: MCPWM phase control, comparators reloaded on every zero-cross sync");
+}
+
+void McpwmOutput::log_statistics() const {
+  ESP_LOGI(TAG, "   ├─ MCPWM compare: fire %u us, release %u us%s", this->fire_ticks_, this->release_ticks_,
+           (this->force_level_ >= 0) ? " (forced)" : "");
+}
+#endif
+
+bool ZeroCrossRelayComponent::setup_rmt_capture_() {
+#if SOC_RMT_SUPPORTED
+  rmt_rx_channel_config_t rx_config = {};
+  rx_config.gpio_num = this->zero_cross_gpio_num_;  // Shared with the detector through the GPIO matrix
+  rx_config.clk_src = RMT_CLK_SRC_DEFAULT;
+  rx_config.resolution_hz = RMT_RX_RESOLUTION_HZ;
+  rx_config.mem_block_symbols = SOC_RMT_MEM_WORDS_PER_CHANNEL;
+  rx_config.intr_priority = INTERRUPT_PRIORITY;
+#if SOC_RMT_SUPPORT_DMA
+  rx_config.mem_block_symbols = RMT_RX_BATCH_SYMBOLS;
+  rx_config.flags.with_dma = true;  // Durations land in RAM without CPU involvement
+#endif
+
+  esp_err_t err = rmt_new_rx_channel(&rx_config, &this->rx_channel_);
+  if (err != ESP_OK) {
+    ESP_LOGE(TAG, "❌ Failed to create RMT RX channel: %s", esp_err_to_name(err));
+    return false;
+  }
+
+  rmt_rx_event_callbacks_t callbacks = {
+      .on_recv_done = rmt_rx_done_callback,
+  };
+  err = rmt_rx_register_event_callbacks(this->rx_channel_, &callbacks, (void *) this);
+  if (err == ESP_OK) {
+    err = rmt_enable(this->rx_channel_);
+  }
+  if (err == ESP_OK) {
+    err = this->arm_rmt_capture_();
+  }
+  if (err != ESP_OK) {
+    ESP_LOGE(TAG, "❌ Failed to start RMT RX capture: %s", esp_err_to_name(err));
+    return false;
+  }
+  return true;
+#else
+  ESP_LOGE(TAG, "❌ RMT edge capture is not supported on this chip");
+  return false;
+#endif
+}
+
+esp_err_t ZeroCrossRelayComponent::arm_rmt_capture_() {
+#if SOC_RMT_SUPPORTED
+  rmt_receive_config_t receive_config = {};
+  receive_config.signal_range_min_ns = RMT_RX_GLITCH_NS;
+  receive_config.signal_range_max_ns = RMT_RX_IDLE_NS;
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 3, 0)
+  // Mains never idles, so one frame never ends: deliver it piece by piece, one batch per buffer fill
+  receive_config.flags.en_partial_rx = true;
+#endif
+  this->rx_has_rise_ = false;  // Time base restarts with every frame
+  return rmt_receive(this->rx_channel_, this->rx_buffer_, sizeof(this->rx_buffer_), &receive_config);
+#else
+  return ESP_ERR_NOT_SUPPORTED;
+#endif
 }
 
 // ========================================
-// PCNT Watch Point Interrupt Callback (ISR Context)
-// Triggered when PCNT count reaches watch points (10 or 20)
-// Does NOT directly control GPIO - instead starts hardware timer for delayed control
-// Must use IRAM_ATTR to ensure execution in IRAM
+// RMT RX Batch Decode (Worker Task Context)
+// Symbols are (duration, level) pairs at 1us. A rising edge is a LOW→HIGH level change; the time
+// between rising edges is one half-cycle, the HIGH run length is the detector pulse width.
+// Results feed the same filtered half-cycle period as the timestamping detectors.
 // ========================================
-bool IRAM_ATTR ZeroCrossRelayComponent::pcnt_on_reach_callback(pcnt_unit_handle_t unit,
-                                                               const pcnt_watch_event_data_t *edata,
-                                                               void *user_ctx) {
-  ZeroCrossRelayComponent *component = static_cast<ZeroCrossRelayComponent *>(user_ctx);
-  
-  int watch_point_value = edata->watch_point_value;
-  
-  // Increment total trigger counter
-  component->trigger_count_++;
-  
-  // Check if this is the duty cycle flip point (dynamic value, not fixed at 10)
-  int active_flip_point = component->duty_cycle_flip_point_;
-  if (active_flip_point > 0 && active_flip_point < PCNT_HIGH_LIMIT &&
-      watch_point_value == active_flip_point) {
-    // ========================================
-    // Watch Point 1: Count = duty_cycle_flip_point (enabled for 1-19)
-    // Set pending GPIO level to LOW, then start timer
-    // ========================================
-    component->pending_gpio_level_ = 0;  // Prepare to set GPIO LOW
-    
-    // Start one-shot timer (will fire after 2000us)
-    gptimer_set_raw_count(component->delay_timer_, 0);  // Reset timer count to 0
-    gptimer_start(component->delay_timer_);             // Start timer
-    
-  } else if (watch_point_value == PCNT_HIGH_LIMIT) {
-    // ========================================
-    // Watch Point 2: Count = 20
-    // Set pending GPIO level based on duty cycle extreme, then start timer
-    // ========================================
-    
-    // Record cycle completion time (for frequency calculation)
-    uint32_t current_time = esp_timer_get_time();
-    static uint32_t last_timestamp = 0;  // Static variable to store last cycle timestamp
-    
-    if (last_timestamp > 0) {
-      // Calculate time elapsed for this 20-count cycle (in microseconds)
-      component->last_cycle_time_ = current_time - last_timestamp;
-    }
-    
-    // Update timestamp for next cycle
-    last_timestamp = current_time;
-    
-    // Increment cycle counter
-    component->cycle_count_++;
-
-    // Apply any pending duty cycle watch point update synchronously at cycle boundary.
-    int pending_flip_point = component->pending_duty_cycle_flip_point_;
-    int current_flip_point = component->duty_cycle_flip_point_;
-    if (pending_flip_point >= 0 && pending_flip_point <= PCNT_HIGH_LIMIT &&
-        pending_flip_point != current_flip_point) {
-      bool current_has_watch_point =
-          (current_flip_point > 0 && current_flip_point < PCNT_HIGH_LIMIT);
-      bool pending_needs_watch_point =
-          (pending_flip_point > 0 && pending_flip_point < PCNT_HIGH_LIMIT);
-      
-      esp_err_t remove_err = ESP_OK;
-      if (current_has_watch_point) {
-        remove_err = pcnt_unit_remove_watch_point(unit, current_flip_point);
-      }
-      
-      if (remove_err == ESP_OK || remove_err == ESP_ERR_NOT_FOUND) {
-        esp_err_t add_err = ESP_OK;
-        if (pending_needs_watch_point) {
-          add_err = pcnt_unit_add_watch_point(unit, pending_flip_point);
-        }
-        if (add_err == ESP_OK) {
-          component->duty_cycle_flip_point_ = pending_flip_point;
-          component->pending_duty_cycle_flip_point_ = -1;
-          component->last_watch_point_update_err_ = ESP_OK;
-        } else {
-          // Restore previous watch point if it was removed successfully.
-          if (current_has_watch_point && remove_err == ESP_OK) {
-            pcnt_unit_add_watch_point(unit, current_flip_point);
+void ZeroCrossRelayComponent::decode_rx_batch_() {
+#if SOC_RMT_SUPPORTED
+  size_t symbols = this->rx_batch_symbols_;
+  uint32_t min_interval = UINT32_MAX;
+  uint32_t max_interval = 0;
+  uint32_t accepted = 0;
+  uint32_t interval_sum = 0;
+
+  for (size_t i = 0; i < 2 * symbols; i++) {
+    const rmt_symbol_word_t &symbol = this->rx_batch_[i / 2];
+    uint32_t duration = (i & 1) ? symbol.duration1 : symbol.duration0;
+    int level = (i & 1) ? symbol.level1 : symbol.level0;
+    if (duration == 0) {
+      break;  // End-of-frame marker
+    }
+
+    if (level == 1 && this->rx_last_level_ == 0) {
+      if (this->rx_has_rise_) {
+        uint32_t interval = this->rx_since_rise_us_;
+        if (HalfCyclePeriodTracker::is_plausible(interval)) {
+          interval_sum += interval;
+          accepted++;
+          if (interval < min_interval) {
+            min_interval = interval;
           }
-          component->last_watch_point_update_err_ = add_err;
+          if (interval > max_interval) {
+            max_interval = interval;
+          }
+        } else {
+          this->period_tracker_.reject_count++;
         }
-      } else {
-        component->last_watch_point_update_err_ = remove_err;
       }
-      component->watch_point_update_event_ = true;
+      this->rx_has_rise_ = true;
+      this->rx_since_rise_us_ = 0;
+      this->period_tracker_.edge_count++;
+    }
+    if (level == 1) {
+      this->period_tracker_.pulse_width_us = duration;
     }
+    this->rx_since_rise_us_ += duration;
+    this->rx_last_level_ = level;
+  }
 
-    int desired_level = (component->duty_cycle_flip_point_ == 0) ? 0 : 1;
-    component->pending_gpio_level_ = desired_level;  // Prepare next GPIO level
+  if (accepted > 0) {
+    this->period_tracker_.add_interval(interval_sum / accepted);
+    this->rx_min_interval_us_ = min_interval;
+    this->rx_max_interval_us_ = max_interval;
+  }
+  this->rx_batch_count_++;
 
-    // Clear PCNT count to restart from 0
-    pcnt_unit_clear_count(unit);
-    
-    // Start one-shot timer (will fire after 2000us)
-    gptimer_set_raw_count(component->delay_timer_, 0);  // Reset timer count to 0
-    gptimer_start(component->delay_timer_);             // Start timer
+  bool frame_done = this->rx_batch_last_;
+  this->rx_batch_busy_ = false;  // Hand the copy buffer back to the ISR
+  if (frame_done) {
+    this->rx_last_level_ = 0;
+    this->arm_rmt_capture_();
   }
-  
-  // Return false: no need to wake higher priority task
-  return false;
+#endif
 }
 
+#if SOC_RMT_SUPPORTED
 // ========================================
-// GPTimer Alarm Interrupt Callback (ISR Context)
-// Triggered 2000us after PCNT interrupt
-// Performs the actual GPIO control based on pending_gpio_level_
-// Must use IRAM_ATTR to ensure execution in IRAM
+// RMT RX Done Interrupt Callback (ISR Context)
+// Fires once per filled buffer: copy the durations out and let the worker task decode them.
 // ========================================
-bool IRAM_ATTR ZeroCrossRelayComponent::timer_alarm_callback(gptimer_handle_t timer,
-                                                             const gptimer_alarm_event_data_t *edata,
-                                                             void *user_ctx) {
+bool IRAM_ATTR ZeroCrossRelayComponent::rmt_rx_done_callback(rmt_channel_handle_t channel,
+                                                             const rmt_rx_done_event_data_t *edata, void *user_ctx) {
   ZeroCrossRelayComponent *component = static_cast<ZeroCrossRelayComponent *>(user_ctx);
-  
-  // Stop timer (one-shot mode)
-  gptimer_stop(timer);
-  
-  // Execute delayed GPIO control
-  if (component->pending_gpio_level_ >= 0) {
-    gpio_set_level(component->relay_output_gpio_num_, component->pending_gpio_level_);
-    component->pending_gpio_level_ = -1;  // Clear pending state
-  }
-  
-  // Return false: no need to wake higher priority task
-  return false;
+
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 3, 0)
+  bool last = edata->flags.is_last;
+#else
+  bool last = true;  // Without partial receive every callback ends the frame
+#endif
+
+  if (component->rx_batch_busy_) {
+    // Worker still decoding the previous batch; keep the frame running, lose this batch
+    component->rx_drop_count_++;
+    if (!last) {
+      return false;
+    }
+    component->rx_batch_last_ = true;
+    return component->notify_worker_from_isr_(WORKER_EVENT_RX_BATCH);
+  }
+
+  size_t symbols = edata->num_symbols;
+  if (symbols > RMT_RX_BATCH_SYMBOLS) {
+    symbols = RMT_RX_BATCH_SYMBOLS;
+  }
+  for (size_t i = 0; i < symbols; i++) {
+    component->rx_batch_[i] = edata->received_symbols[i];
+  }
+  component->rx_batch_symbols_ = symbols;
+  component->rx_batch_last_ = last;
+  component->rx_batch_busy_ = true;
+  return component->notify_worker_from_isr_(WORKER_EVENT_RX_BATCH);
+}
+#endif
+
+void ZeroCrossRelayComponent::process_worker_events_(uint32_t events) {
+  if (events & WORKER_EVENT_RX_BATCH) {
+    this->decode_rx_batch_();
+  }
+  if (events & WORKER_EVENT_ADC_FRAME) {
+    this->read_adc_frames_();
+  }
+}
+
+void ZeroCrossRelayComponent::worker_task_loop_(void *arg) {
+  ZeroCrossRelayComponent *component = static_cast<ZeroCrossRelayComponent *>(arg);
+  while (true) {
+    uint32_t events = 0;
+    xTaskNotifyWait(0, UINT32_MAX, &events, portMAX_DELAY);
+    component->process_worker_events_(events);
+  }
+}
+
+// ========================================
+// Window Boundary Bookkeeping (ISR Context)
+// Shared by flip point mode (count 20) and pattern mode (pattern wrap)
+// ========================================
+void IRAM_ATTR ZeroCrossRelayComponent::record_window_boundary_() {
+  uint32_t current_time = esp_timer_get_time();
+
+  if (this->last_boundary_timestamp_ > 0) {
+    // Calculate time elapsed for this window (in microseconds)
+    this->last_cycle_time_ = current_time - this->last_boundary_timestamp_;
+  }
+
+  // Update timestamp for next cycle
+  this->last_boundary_timestamp_ = current_time;
+  this->zero_cross_timestamp_ = current_time;
+
+  // Increment cycle counter
+  this->cycle_count_++;
+}
+
+// ========================================
+// Fallback Handover (ISR Context)
+// First window start after sync returns: stop the PWM and restart the window at this edge
+// ========================================
+void IRAM_ATTR ZeroCrossRelayComponent::end_fallback_() {
+  portENTER_CRITICAL_ISR(&this->fallback_lock_);
+  this->fallback_active_ = false;
+  portEXIT_CRITICAL_ISR(&this->fallback_lock_);
+
+  // Window state froze when the edges stopped
+  this->restart_window_();
+  this->fallback_exit_event_ = true;
+}
+
+void IRAM_ATTR ZeroCrossRelayComponent::restart_window_() {
+  this->last_boundary_timestamp_ = 0;
+  this->zero_cross_timestamp_ = 0;
+  this->pattern_bits_left_ = 0;
+  this->commanded_level_ = -1;
+  this->window_segment_ = static_cast<uint16_t>(this->window_segments_ - 1U);
+}
+
+// ========================================
+// Interrupt-Storm Governor (ISR Context)
+// Every 20 edges are timed; windows shorter than any plausible mains rate trip it
+// ========================================
+bool IRAM_ATTR ZeroCrossRelayComponent::storm_mark_(uint32_t edges) {
+  this->storm_edges_ += static_cast<uint8_t>(edges);
+  if (this->storm_edges_ < WINDOW_LENGTH) {
+    return false;
+  }
+  this->storm_edges_ = 0;
+  uint32_t now = static_cast<uint32_t>(esp_timer_get_time());
+  uint32_t elapsed = now - this->storm_last_us_;
+  bool first = (this->storm_last_us_ == 0);
+  this->storm_last_us_ = now;
+  if (first || elapsed >= STORM_MIN_WINDOW_US) {
+    this->storm_run_ = 0;
+    return false;
+  }
+  if (++this->storm_run_ < STORM_TRIP_WINDOWS) {
+    return false;
+  }
+  this->storm_run_ = 0;
+  this->last_cycle_time_ = 0;  // The fast windows must not become the tracked mains period
+  this->storm_active_ = true;
+  this->storm_trips_++;
+  this->storm_event_ = true;
+  return true;
+}
+
+int IRAM_ATTR ZeroCrossRelayComponent::storm_probe_mark_() {
+  uint32_t now = static_cast<uint32_t>(esp_timer_get_time());
+  uint32_t elapsed = now - this->storm_last_us_;
+  bool first = (this->storm_last_us_ == 0);
+  this->storm_last_us_ = now;
+  if (first) {
+    return 0;
+  }
+  if (elapsed < STORM_MIN_WINDOW_US) {
+    this->storm_probing_ = false;
+    return -1;
+  }
+  if (elapsed > STORM_MAX_WINDOW_US) {
+    // Edges missing or still settling: not a storm, not yet mains either
+    this->storm_run_ = 0;
+    return 0;
+  }
+  if (++this->storm_run_ < STORM_RECOVER_WINDOWS) {
+    return 0;
+  }
+  this->storm_run_ = 0;
+  this->storm_edges_ = 0;
+  this->storm_probing_ = false;
+  this->storm_active_ = false;
+  this->restart_window_();
+  this->storm_exit_event_ = true;
+  return 1;
+}
+
+// ========================================
+// Pattern Mode Window Boundary (ISR Context)
+// Statistics and synchronous pattern swap, shared by the per-edge and the window playback paths
+// ========================================
+void IRAM_ATTR ZeroCrossRelayComponent::begin_pattern_window_() {
+  this->record_window_boundary_();
+
+  portENTER_CRITICAL_ISR(&this->pattern_lock_);
+  if (this->pattern_update_pending_) {
+    this->active_pattern_ = this->pending_pattern_;
+    this->duty_cycle_flip_point_ = this->pending_duty_cycle_flip_point_;
+    this->pending_duty_cycle_flip_point_ = -1;
+    this->pattern_update_pending_ = false;
+    this->last_watch_point_update_err_ = ESP_OK;
+    this->watch_point_update_event_ = true;
+  }
+  portEXIT_CRITICAL_ISR(&this->pattern_lock_);
+
+  if (this->watchdog_enabled_) {
+    uint32_t length = static_cast<uint32_t>(this->pattern_length_);
+    if (this->watchdog_check_(static_cast<uint32_t>(__builtin_popcountll(this->active_pattern_)), length)) {
+      this->active_pattern_ = this->watchdog_safe_pattern_;
+      this->duty_cycle_flip_point_ = this->watchdog_safe_flip_point_;
+    }
+    this->watchdog_account_(static_cast<uint32_t>(__builtin_popcountll(this->active_pattern_)), length);
+  }
+
+  this->pattern_shift_reg_ = this->active_pattern_;
+  this->pattern_bits_left_ = this->pattern_length_;
+}
+
+// ========================================
+// Pattern Mode Window Chunk (ISR Context)
+// Output stage plays the window back: one interrupt per chunk of up to 20 edges instead of per edge
+// ========================================
+int IRAM_ATTR ZeroCrossRelayComponent::step_pattern_window_(int edges, bool *window_start) {
+  if (this->pattern_bits_left_ <= edges) {
+    // This edge starts the next window (or the first one after a restart)
+    this->begin_pattern_window_();
+    *window_start = true;
+  } else {
+    this->pattern_bits_left_ -= static_cast<uint8_t>(edges);
+  }
+  int left = this->pattern_bits_left_;
+  return (left < WINDOW_LENGTH) ? left : WINDOW_LENGTH;
+}
+
+// ========================================
+// Pattern Mode Edge Step (ISR Context)
+// Called on every edge: consume one bit, report a level only when it changes.
+// Cost is constant per edge regardless of how on half-cycles are distributed.
+// ========================================
+int IRAM_ATTR ZeroCrossRelayComponent::step_pattern_(bool *window_start) {
+  if (this->pattern_bits_left_ == 0) {
+    this->begin_pattern_window_();
+    *window_start = true;
+  }
+
+  int level = static_cast<int>(this->pattern_shift_reg_ & 1ULL);
+  this->pattern_shift_reg_ >>= 1;
+  this->pattern_bits_left_--;
+
+  if (level == this->commanded_level_) {
+    return -1;
+  }
+  this->commanded_level_ = level;
+  return level;
+}
+
+bool IRAM_ATTR ZeroCrossRelayComponent::notify_worker_from_isr_(uint32_t events) {
+  if (this->worker_task_handle_ == nullptr) {
+    return false;
+  }
+  BaseType_t task_woken = pdFALSE;
+  xTaskNotifyFromISR(this->worker_task_handle_, events, eSetBits, &task_woken);
+  return task_woken == pdTRUE;
 }
 
 }  // namespace zero_cross_relay
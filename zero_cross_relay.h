@@ -1,20 +1,35 @@
 /**
  * @file zero_cross_relay.h
  * @brief Zero-Cross Detection Solid State Relay Component Header (ESP-IDF PCNT + CPU Interrupt Version)
- * 
+ *
  * Features:
  * - Uses PCNT hardware counter to monitor AC power zero-crossing points (GPIO3 input)
  * - Count range: 0-20, auto-clear when reaches 20
  * - Watch Point: Pull GPIO4 LOW at count 10, pull GPIO4 HIGH at count 20
  * - Provides interrupt trigger counting and frequency statistics
  * - Uses PCNT Watch Point interrupt for precise phase control
- * 
+ * - Optional pattern mode: up to 64 half-cycle bitmask per window, one bit per edge
+ * - Optional RMT output mode: whole window timeline played back by hardware, one refill per window
+ * - Optional MCPWM output mode: zero-cross pin syncs an MCPWM timer, comparators gate every half-cycle
+ * - Optional RMT RX capture front end: pulse durations recorded by hardware, decoded in batches
+ * - Optional current sensing: continuous ADC DMA, RMS current per mains half-cycle
+ * - Optional metering: voltage channel in the same stream, P/Q/PF per mains cycle, closed-loop power setpoint
+ * - Load-type commissioning: test pattern, classification from inrush, lag and detector sag, profile in flash
+ * - Optional output verification: feedback input checked after every transition, failsafe on a stuck or open SSR
+ * - Optional SSR thermal model: junction and heatsink RC stages in fixed point, duty derated near the limit
+ * - Optional duty watchdog: on-time, off-time and average duty limits enforced at every window boundary ISR
+ * - Interrupt-storm governor: implausibly fast windows turn the watch point interrupts off and hold the relay off
+ * - Overlap-safe GPTimer output: free-running timer with an event queue, missed alarms and wrong pin levels repaired
+ * - Optional redundant detection: two zero-cross inputs cross-checked on every edge, a faulty one voted out
+ * - Detector (PCNT, GPIO-ISR, ETM capture, MCPWM capture, dual GPIO-ISR) and output stage selected at compile time
+ *   as policy classes of ZeroCrossRelay<Detector, Output>; the tracking and control core is shared
+ *
  * Hardware Connections:
  * - GPIO3: Zero-cross detection input (rising edge count, internal pull-up)
  * - GPIO4: Solid state relay output (initial HIGH, LOW at count 10, HIGH at count 20)
- * 
+ *
  * @note This implementation is only compatible with ESP-IDF framework (ESP32-C6)
- * 
+ *
  * @author chinawrj@gmail.com
  * @date 2025-10-11
  */
@@ -24,6 +39,9 @@
 #include "esphome/core/component.h"
 #include "esphome/core/hal.h"
 #include "esphome/core/log.h"
+#include "esphome/core/preferences.h"
+
+#include "mid_window_plan.h"  // Window length and mid-window planning (no hardware access, host tested)
 
 // ESP-IDF PCNT (Pulse Counter) API
 #include "driver/gpio.h"
@@ -31,13 +49,898 @@
 #include "driver/gptimer.h"      // GPTimer for precise delay
 #include "esp_err.h"
 #include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "soc/soc_caps.h"
+
+#if SOC_RMT_SUPPORTED
+#include "driver/rmt_tx.h"        // RMT TX for whole-window waveform offload
+#include "driver/rmt_rx.h"        // RMT RX for batched edge capture
+#include "driver/rmt_encoder.h"
+#endif
+#include "esp_idf_version.h"
+
+#if SOC_MCPWM_SUPPORTED
+#include "driver/mcpwm_prelude.h" // MCPWM sync + comparators for hardware phase-locked output
+#endif
+
+#if SOC_ADC_DMA_SUPPORTED
+#include "esp_adc/adc_continuous.h" // Continuous ADC DMA for per-half-cycle RMS current
+#endif
+
+#if SOC_TEMP_SENSOR_SUPPORTED
+#include "driver/temperature_sensor.h" // Chip temperature as the SSR ambient
+#endif
+
+#if SOC_ETM_SUPPORTED && SOC_GPTIMER_SUPPORT_ETM
+#include "driver/gpio_etm.h"      // GPIO edge → ETM event
+#include "driver/gptimer_etm.h"   // ETM task → GPTimer capture (hardware timestamp)
+#include "esp_etm.h"
+#endif
 
 namespace esphome {
 namespace zero_cross_relay {
 
+/// Maximum number of half-cycles a conduction pattern can describe (one bit per edge)
+static const uint8_t MAX_PATTERN_LENGTH = 64;
+
+/// deferred_watch_point_ value when no ISR deferred a watch point move
+static const int NO_DEFERRED_WATCH_POINT = -2;
+
+/// Relay transitions the GPTimer output can hold pending at once (fire + release + next edge, with slack)
+static const uint8_t GPTIMER_QUEUE_DEPTH = 4;
+
+/// Software-counting detectors ignore rising edges closer than this to the previous one until the
+/// half-cycle period is known (short enough for 400Hz supplies); afterwards a quarter half-cycle is used
+static const uint32_t EDGE_HOLDOFF_US = 500;
+
+/// Default relay switch delay after the zero-cross edge, Q16 fraction of a half-cycle (36°, 2000us at 50Hz)
+static const uint32_t DEFAULT_SWITCH_PHASE_Q16 = 13107;
+
+/// Worker task event: window boundary seen, encode and play back the next window
+static const uint32_t WORKER_EVENT_RMT_REFILL = 1UL << 0;
+
+/// Worker task event: RMT RX batch copied out, decode durations into edge statistics
+static const uint32_t WORKER_EVENT_RX_BATCH = 1UL << 1;
+
+/// Worker task event: ADC DMA frame completed, accumulate current samples per half-cycle
+static const uint32_t WORKER_EVENT_ADC_FRAME = 1UL << 2;
+
+/// Conversion results per ADC DMA frame (one worker wakeup)
+static const size_t ADC_FRAME_RESULTS = 256;
+
+/// Sine table entries per mains cycle for the metering kernel (1.4° phase resolution, power of two)
+static const int METER_TABLE_SIZE = 256;
+
+/**
+ * @brief How the on/off decision is made for each half-cycle of a window
+ */
+enum ModulationMode : uint8_t {
+  MODULATION_FLIP_POINT = 0,  ///< On for the first N counts of the window, then off (two watch points)
+  MODULATION_PATTERN = 1,     ///< Precomputed bitmask, one bit shifted out per zero-cross edge
+  MODULATION_TIME_PROPORTIONING = 2,  ///< Long window of many 20-edge segments, on for the first N half-cycles
+  MODULATION_HYBRID = 3,      ///< Whole half-cycles plus one phase-cut half-cycle per window for the fraction
+};
+
+/// Fractional setpoint resolution of the hybrid phase-cut half-cycle (1/256 of a half-cycle)
+static const int CUT_FRACTION_STEPS = 256;
+
+/// Upper bound of RMT symbols needed to encode one window (runs split at 15-bit durations)
+static const size_t RMT_MAX_WINDOW_SYMBOLS = 96;
+
+/// Zero-cross pulses per RMT RX batch (one symbol = one HIGH pulse + the following LOW gap)
+static const size_t RMT_RX_BATCH_SYMBOLS = 64;
+
+/**
+ * @brief Which peripheral generates the relay waveform (reported by the output policy)
+ */
+enum OutputMode : uint8_t {
+  OUTPUT_MODE_GPTIMER = 0,  ///< Watch point ISR queues events on a free-running GPTimer, alarm ISR writes the GPIO
+  OUTPUT_MODE_RMT = 1,      ///< RMT TX plays back the whole window timeline, refilled once per window
+  OUTPUT_MODE_MCPWM = 2,    ///< MCPWM timer synced to the zero-cross pin, comparators fire every half-cycle
+};
+
+/**
+ * @brief Optional batched edge telemetry front end (feeds period tracking, independent of the detector)
+ */
+enum EdgeCaptureMode : uint8_t {
+  EDGE_CAPTURE_NONE = 0,  ///< Period from the detector (hardware timestamps) or the window average
+  EDGE_CAPTURE_RMT = 1,   ///< RMT RX records pulse durations, CPU decodes one batch per wakeup
+};
+
+/**
+ * @brief How the pattern builder distributes on half-cycles inside a window
+ */
+enum PatternDistribution : uint8_t {
+  PATTERN_DISTRIBUTION_EVEN = 0,   ///< Spread on half-cycles as evenly as possible (Bresenham)
+  PATTERN_DISTRIBUTION_BURST = 1,  ///< All on half-cycles back-to-back at the start of the window
+  PATTERN_DISTRIBUTION_FLICKER = 2,  ///< Lowest flicker cost layout, looked up in a table generated at build time
+};
+
+/**
+ * @brief Load class found by commissioning (or configured); selects safe modulation defaults
+ */
+enum LoadType : uint8_t {
+  LOAD_TYPE_UNKNOWN = 0,     ///< Not detected yet, or nothing could be measured
+  LOAD_TYPE_RESISTIVE = 1,   ///< Heater: no inrush, no phase shift
+  LOAD_TYPE_INDUCTIVE = 2,   ///< Motor or transformer: current lags the voltage
+  LOAD_TYPE_LAMP = 3,        ///< Incandescent/halogen: cold filament inrush decaying within a few half-cycles
+  LOAD_TYPE_CAPACITIVE = 4,  ///< Capacitive PSU or filter: current leads the voltage
+};
+
+/**
+ * @brief Phase of the load-type commissioning test pattern (loop)
+ */
+enum LoadDetectionState : uint8_t {
+  LOAD_DETECT_IDLE = 0,     ///< Not running
+  LOAD_DETECT_OFF = 1,      ///< Relay held off: filament cools, baseline pulse width
+  LOAD_DETECT_INRUSH = 2,   ///< First half-cycles after switch-on: peak current and detector sag
+  LOAD_DETECT_STEADY = 3,   ///< Warmed up: steady current, phase lag, steady sag
+};
+
+/**
+ * @brief What the output feedback input reports
+ */
+enum FeedbackType : uint8_t {
+  FEEDBACK_LEVEL = 0,    ///< Output readback: HIGH while the relay is on
+  FEEDBACK_CURRENT = 1,  ///< Current-presence comparator: pulses every half-cycle while load current flows
+};
+
+/**
+ * @brief Latched result of output verification
+ */
+enum OutputFault : uint8_t {
+  OUTPUT_FAULT_NONE = 0,      ///< Feedback agrees with the commanded level
+  OUTPUT_FAULT_STUCK_ON = 1,  ///< Commanded off but still on (SSR failed shorted)
+  OUTPUT_FAULT_OPEN = 2,      ///< Commanded on but no output (SSR failed open, open load or blown fuse)
+};
+
+/**
+ * @brief Limit that tripped the duty watchdog
+ */
+enum WatchdogTrip : uint8_t {
+  WATCHDOG_OK = 0,         ///< No limit hit
+  WATCHDOG_MAX_ON = 1,     ///< Continuous conduction would exceed the maximum on-time
+  WATCHDOG_MIN_OFF = 2,    ///< A burst would start before the minimum off-time has passed
+  WATCHDOG_AVERAGE = 3,    ///< Rolling-average duty would exceed its maximum
+};
+
+/**
+ * @brief Commissioning result kept in flash
+ */
+struct LoadProfile {
+  uint8_t type{LOAD_TYPE_UNKNOWN};  ///< LoadType
+  float inrush_ratio{0.0f};         ///< Peak / steady current of the first conducting half-cycles (0 = not measured)
+  float lag_degrees{0.0f};          ///< Current phase lag, negative = leading (capacitive)
+  float sag_ratio{0.0f};            ///< Detector pulse widening, transient / steady (0 = not measured)
+};
+
+/**
+ * @brief Watch point handler installed by ZeroCrossRelay into its detector (ISR context)
+ * @param ctx Component pointer
+ * @param watch_point_value Count that was reached
+ * @return bool Whether a higher priority task was woken
+ */
+using WatchPointHandler = bool (*)(void *ctx, int watch_point_value);
+
+/**
+ * @brief Filtered half-cycle period from hardware edge timestamps
+ *
+ * Fed per rising edge by timestamping detectors (ETM / MCPWM capture) and per batch by the
+ * RMT RX front end. Intervals outside the plausible mains range are rejected.
+ */
+struct HalfCyclePeriodTracker {
+  volatile uint32_t half_cycle_q4{0};   ///< Filtered half-cycle period (us, Q4 fixed point), 0 = unknown
+  volatile uint32_t period_us{0};       ///< Latest accepted rising-to-rising interval (us)
+  volatile uint32_t pulse_width_us{0};  ///< Latest rising-to-falling interval (us)
+  volatile uint32_t edge_count{0};      ///< Rising edges seen
+  volatile uint32_t reject_count{0};    ///< Intervals rejected as implausible (glitches / missing edges)
+
+  /**
+   * @brief Feed one rising-to-rising interval into the filter (ISR or task context)
+   * @param interval_us Interval in us
+   * @return bool false if the interval was rejected as implausible
+   */
+  bool IRAM_ATTR add_interval(uint32_t interval_us);
+
+  /**
+   * @brief Whether an interval lies inside the plausible half-cycle range
+   */
+  static bool IRAM_ATTR is_plausible(uint32_t interval_us);
+
+  /**
+   * @brief Software edge hold-off: a quarter of the tracked half-cycle, EDGE_HOLDOFF_US until locked
+   */
+  uint32_t IRAM_ATTR holdoff_us() const {
+    uint32_t quarter_us = this->half_cycle_q4 >> 6;
+    return (quarter_us > EDGE_HOLDOFF_US) ? quarter_us : EDGE_HOLDOFF_US;
+  }
+
+  volatile uint8_t outlier_run{0};         ///< Consecutive plausible intervals far from the filtered value
+};
+
+/**
+ * @brief One ADC channel's sums over a mains cycle for the metering kernel (worker task)
+ *
+ * The products use the table phase of each sample's own timestamp, so channels scanned at different instants
+ * still share one phase reference.
+ */
+struct CycleSums {
+  uint32_t samples{0};   ///< Samples in the cycle
+  uint32_t sum{0};       ///< Σ raw (bias, AC RMS)
+  uint64_t sum_sq{0};    ///< Σ raw²
+  int64_t cos_sum{0};    ///< Σ (raw - offset) · cos θ, Q15 table
+  int64_t sin_sum{0};    ///< Σ (raw - offset) · sin θ, Q15 table
+  int32_t offset{2048};  ///< Bias removed before the products (previous cycle's mean, starts at 12-bit mid-scale)
+
+  /// Start a new cycle, keeping the bias estimate
+  void restart() {
+    samples = 0;
+    sum = 0;
+    sum_sq = 0;
+    cos_sum = 0;
+    sin_sum = 0;
+  }
+};
+
+/**
+ * @brief Relay transitions written by the output stage (alarm ISR)
+ *
+ * Read by the contact feedback ISR to time coil operations and by loop() for wear tracking.
+ */
+struct RelaySwitchLog {
+  volatile uint32_t count{0};     ///< Level changes written to the relay pin (coil operations)
+  volatile uint32_t time_us{0};   ///< esp_timer time of the latest change
+  volatile int level{-1};         ///< Level of the latest change (-1 = none yet)
+};
+
+// ========================================
+// Detector Policies
+// Interface: setup(pin, tracker), start<Handler>(ctx), add/remove_watch_point(), clear_count(),
+// get_count(), edge_lag(), edge_time(), name(), dump_config(), log_statistics(). Watch point semantics match PCNT: the handler runs
+// when the count reaches a watch point, the count wraps at WINDOW_LENGTH.
+// ========================================
+
+/**
+ * @class PcntDetector
+ * @brief PCNT unit counts rising edges in hardware, watch points interrupt the CPU
+ */
+class PcntDetector {
+ public:
+  static constexpr const char *NAME = "PCNT";
+  const char *name() const { return NAME; }
+
+  /**
+   * @brief Create the PCNT unit, glitch filter and rising-edge channel
+   * @param pin Zero-cross input
+   * @param tracker Period tracker (unused, PCNT has no timestamps)
+   * @return bool true on success
+   */
+  bool setup(gpio_num_t pin, HalfCyclePeriodTracker *tracker);
+
+  /**
+   * @brief Register the watch point handler and start counting from 0
+   * @param ctx Passed to Handler
+   */
+  template<WatchPointHandler Handler> esp_err_t start(void *ctx) { return this->start_(&on_reach_<Handler>, ctx); }
+
+  esp_err_t IRAM_ATTR add_watch_point(int value) { return pcnt_unit_add_watch_point(this->unit_, value); }
+  esp_err_t IRAM_ATTR remove_watch_point(int value) { return pcnt_unit_remove_watch_point(this->unit_, value); }
+  void IRAM_ATTR clear_count() { pcnt_unit_clear_count(this->unit_); }
+  int get_count() const;
+  const volatile uint32_t *edge_lag() const { return nullptr; }
+  const volatile uint32_t *edge_time() const { return nullptr; }
+  void dump_config() const;
+  void log_statistics() const {}
+
+ protected:
+  template<WatchPointHandler Handler>
+  static bool IRAM_ATTR on_reach_(pcnt_unit_handle_t unit, const pcnt_watch_event_data_t *edata, void *user_ctx) {
+    return Handler(user_ctx, edata->watch_point_value);
+  }
+  esp_err_t start_(pcnt_watch_cb_t callback, void *ctx);
+  void release_();
+
+  pcnt_unit_handle_t unit_{nullptr};        ///< PCNT unit handle (count 0-20, auto-loop)
+  pcnt_channel_handle_t channel_{nullptr};  ///< PCNT channel handle (rising edge count)
+};
+
+/**
+ * @class SoftwareEdgeCounter
+ * @brief Shared window counter for detectors that interrupt on every edge
+ *
+ * Emulates PCNT watch points with a bitmask, so the control core cannot tell the difference.
+ */
+class SoftwareEdgeCounter {
+ public:
+  esp_err_t IRAM_ATTR add_watch_point(int value) {
+    if (value <= 0 || value > WINDOW_LENGTH) {
+      return ESP_ERR_INVALID_ARG;
+    }
+    uint32_t bit = 1UL << value;
+    if (this->watch_mask_ & bit) {
+      return ESP_ERR_INVALID_STATE;
+    }
+    this->watch_mask_ |= bit;
+    return ESP_OK;
+  }
+  esp_err_t IRAM_ATTR remove_watch_point(int value) {
+    uint32_t bit = (value > 0 && value <= WINDOW_LENGTH) ? (1UL << value) : 0;
+    if ((this->watch_mask_ & bit) == 0) {
+      return ESP_ERR_NOT_FOUND;
+    }
+    this->watch_mask_ &= ~bit;
+    return ESP_OK;
+  }
+  void IRAM_ATTR clear_count() { this->count_ = 0; }
+  int get_count() const { return this->count_; }
+  /// Lag of the counted edge behind the reference edge, for the output stage (nullptr = always 0)
+  const volatile uint32_t *edge_lag() const { return nullptr; }
+  /// esp_timer time of the latest counted edge on the reference timeline (nullptr = not timestamped, 0 = none yet)
+  const volatile uint32_t *edge_time() const { return &this->edge_time_us_; }
+
+ protected:
+  /// Rising-edge glitch filter; true if the edge is far enough from the previous one
+  bool IRAM_ATTR accept_edge_(uint32_t now_us) {
+    if (this->has_edge_ && now_us - this->last_edge_us_ < this->tracker_->holdoff_us()) {
+      this->glitch_count_++;
+      return false;
+    }
+    this->last_interval_us_ = this->has_edge_ ? now_us - this->last_edge_us_ : 0;
+    this->last_edge_us_ = now_us;
+    this->has_edge_ = true;
+    return true;
+  }
+
+  /**
+   * @brief Count one accepted edge and run the handler if it reached a watch point
+   * @param edge_us esp_timer time of the edge on the reference timeline
+   */
+  template<WatchPointHandler Handler> bool IRAM_ATTR count_edge_(uint32_t edge_us) {
+    this->edge_time_us_ = edge_us;
+    int count = this->count_ + 1;
+    this->count_ = count;
+    bool woken = false;
+    if (this->watch_mask_ & (1UL << count)) {
+      woken = Handler(this->ctx_, count);
+    }
+    if (this->count_ >= WINDOW_LENGTH) {
+      this->count_ = 0;  // PCNT wraps at its high limit as well
+    }
+    return woken;
+  }
+
+  void *ctx_{nullptr};                      ///< Handler context (component)
+  HalfCyclePeriodTracker *tracker_{nullptr}; ///< Period tracker fed by timestamping subclasses
+  volatile int count_{0};                   ///< Edges since the last clear (0-20)
+  volatile uint32_t watch_mask_{0};         ///< Bit n set = watch point at count n
+  uint32_t last_edge_us_{0};                ///< Timestamp of the last accepted edge (ISR only)
+  bool has_edge_{false};                    ///< last_edge_us_ is valid (ISR only)
+  uint32_t last_interval_us_{0};            ///< Interval to the previous accepted edge, 0 = first edge (ISR only)
+  volatile uint32_t glitch_count_{0};       ///< Edges rejected by the hold-off filter
+  volatile uint32_t edge_time_us_{0};       ///< esp_timer time of the latest counted edge (0 = none yet)
+};
+
+/**
+ * @class GpioIsrDetector
+ * @brief IRAM GPIO rising-edge interrupt with software counting
+ *
+ * Needs no counter peripheral; costs one interrupt per half-cycle.
+ */
+class GpioIsrDetector : public SoftwareEdgeCounter {
+ public:
+  static constexpr const char *NAME = "GPIO ISR";
+  const char *name() const { return NAME; }
+
+  bool setup(gpio_num_t pin, HalfCyclePeriodTracker *tracker);
+  template<WatchPointHandler Handler> esp_err_t start(void *ctx) {
+    this->ctx_ = ctx;
+    return this->start_(&on_edge_<Handler>);
+  }
+  void dump_config() const;
+  void log_statistics() const;
+
+ protected:
+  template<WatchPointHandler Handler> static void IRAM_ATTR on_edge_(void *arg) {
+    GpioIsrDetector *detector = static_cast<GpioIsrDetector *>(arg);
+    if (!detector->accept_edge_(static_cast<uint32_t>(esp_timer_get_time()))) {
+      return;
+    }
+    // ISR entry timestamps carry interrupt latency jitter; the tracker filter averages it out
+    if (detector->last_interval_us_ != 0) {
+      detector->tracker_->add_interval(detector->last_interval_us_);
+    }
+    detector->tracker_->edge_count++;
+    if (detector->template count_edge_<Handler>(detector->last_edge_us_)) {
+      portYIELD_FROM_ISR();
+    }
+  }
+  esp_err_t start_(gpio_isr_t isr);
+
+  gpio_num_t pin_{GPIO_NUM_NC};  ///< Zero-cross input
+};
+
+/**
+ * @class DualGpioDetector
+ * @brief Two zero-cross inputs on GPIO interrupts, cross-checked on every edge and voted per input
+ *
+ * An edge is counted at whichever voted-in input sees it first, so a dead input costs nothing and the
+ * other takes over within the same half-cycle. The partner edge on the other input confirms the phase.
+ * An input that misses edges, adds edges off the tracked mains timeline or drifts in phase is voted out,
+ * and re-admitted after a run of agreeing edges; the last voted-in input is never voted out. The learned
+ * phase offset between the inputs is handed to the output stage as the lag of the counted edge, so the
+ * switching timing does not depend on which input counted it.
+ */
+class DualGpioDetector : public SoftwareEdgeCounter {
+ public:
+  static constexpr const char *NAME = "Dual GPIO ISR";
+  const char *name() const { return NAME; }
+
+  /// Second zero-cross input (set before setup)
+  void set_secondary_pin(InternalGPIOPin *pin) { this->secondary_pin_ = pin; }
+  bool setup(gpio_num_t pin, HalfCyclePeriodTracker *tracker);
+  template<WatchPointHandler Handler> esp_err_t start(void *ctx) {
+    this->ctx_ = ctx;
+    return this->start_(&on_edge_<Handler, 0>, &on_edge_<Handler, 1>);
+  }
+  const volatile uint32_t *edge_lag() const { return &this->edge_lag_us_; }
+  void dump_config() const;
+  void log_statistics() const;
+
+ protected:
+  /// Per-input vote state (ISR only unless noted)
+  struct Input {
+    gpio_num_t pin{GPIO_NUM_NC};      ///< Zero-cross input
+    volatile bool voted_in{true};     ///< Edges from this input may be counted (read by log_statistics)
+    uint8_t fault_run{0};             ///< Consecutive faults
+    uint16_t agree_run{0};            ///< Consecutive agreeing edges while voted out
+    uint32_t last_us{0};              ///< Previous edge that passed the timing gate
+    volatile uint32_t edges{0};       ///< Rising edges seen
+    volatile uint32_t faults{0};      ///< Missed, extra or out-of-phase edges
+    volatile uint32_t votes_out{0};   ///< Times this input was voted out
+  };
+
+  template<WatchPointHandler Handler, int Index> static void IRAM_ATTR on_edge_(void *arg) {
+    DualGpioDetector *detector = static_cast<DualGpioDetector *>(arg);
+    // Both inputs share the GPIO ISR service, so their handlers never run concurrently
+    if (detector->vote_edge_(Index, static_cast<uint32_t>(esp_timer_get_time())) &&
+        detector->template count_edge_<Handler>(detector->counted_us_)) {
+      portYIELD_FROM_ISR();
+    }
+  }
+
+  /**
+   * @brief Pair, gate and vote one edge (ISR context)
+   * @param index Input the edge arrived on (0 = primary, 1 = secondary)
+   * @param now_us Edge timestamp
+   * @return bool true if this edge is the one counted for its half-cycle
+   */
+  bool IRAM_ATTR vote_edge_(int index, uint32_t now_us);
+  /// Count the half-cycle at this input's edge and publish its lag (ISR context)
+  void IRAM_ATTR count_at_(int index, uint32_t now_us);
+  /// Lag of an input's edges behind the earlier input, from the learned offset
+  uint32_t IRAM_ATTR lag_of_(int index) const;
+  void IRAM_ATTR fault_(int index);
+  void IRAM_ATTR agree_(int index);
+  esp_err_t start_(gpio_isr_t primary_isr, gpio_isr_t secondary_isr);
+
+  InternalGPIOPin *secondary_pin_{nullptr};  ///< Second zero-cross input
+  Input inputs_[2];                          ///< Primary and secondary input
+  int pending_input_{-1};                    ///< Input whose edge waits for its partner (-1 = none)
+  uint32_t pending_us_{0};                   ///< Time of that edge
+  uint32_t pending_interval_{0};             ///< Its interval to the previous edge on the same input
+  bool pending_counted_{false};              ///< That edge was counted (its input was voted in)
+  uint32_t counted_us_{0};                   ///< Last counted edge, lag removed (reference timeline)
+  bool has_counted_{false};                  ///< counted_us_ is valid
+  int32_t offset_q4_{0};                     ///< Filtered secondary minus primary edge time (us, Q4)
+  uint8_t offset_pairs_{0};                  ///< Pairs averaged while learning the offset
+  volatile uint32_t edge_lag_us_{0};         ///< Lag of the edge counted last (read by the output stage)
+  volatile uint32_t disagreements_{0};       ///< Pairs outside the phase tolerance
+};
+
+#if SOC_ETM_SUPPORTED && SOC_GPTIMER_SUPPORT_ETM
+/**
+ * @class EtmCaptureDetector
+ * @brief GPIO edge latches a free-running GPTimer through ETM; the GPIO ISR counts and reads the latch
+ *
+ * Counting still needs the interrupt, but the timestamp is taken by hardware at the edge.
+ */
+class EtmCaptureDetector : public SoftwareEdgeCounter {
+ public:
+  static constexpr const char *NAME = "ETM capture";
+  const char *name() const { return NAME; }
+
+  bool setup(gpio_num_t pin, HalfCyclePeriodTracker *tracker);
+  template<WatchPointHandler Handler> esp_err_t start(void *ctx) {
+    this->ctx_ = ctx;
+    return this->start_(&on_edge_<Handler>);
+  }
+  void dump_config() const;
+  void log_statistics() const;
+
+ protected:
+  template<WatchPointHandler Handler> static void IRAM_ATTR on_edge_(void *arg) {
+    EtmCaptureDetector *detector = static_cast<EtmCaptureDetector *>(arg);
+    uint64_t captured = 0;
+    gptimer_get_captured_count(detector->timer_, &captured);  // 1us ticks, latched at the edge
+    uint32_t edge_us = static_cast<uint32_t>(captured);
+    if (!detector->accept_edge_(edge_us)) {
+      return;
+    }
+    detector->track_rising_edge_(edge_us);
+    // Captured count is on the timestamp timer; move the edge onto the esp_timer timeline by its age
+    uint64_t now_count = edge_us;
+    gptimer_get_raw_count(detector->timer_, &now_count);
+    uint32_t age_us = static_cast<uint32_t>(now_count) - edge_us;
+    if (detector->template count_edge_<Handler>(static_cast<uint32_t>(esp_timer_get_time()) - age_us)) {
+      portYIELD_FROM_ISR();
+    }
+  }
+  void IRAM_ATTR track_rising_edge_(uint32_t edge_us);
+  esp_err_t start_(gpio_isr_t isr);
+
+  gpio_num_t pin_{GPIO_NUM_NC};                   ///< Zero-cross input
+  gptimer_handle_t timer_{nullptr};               ///< Free-running 1MHz timestamp timer
+  esp_etm_event_handle_t gpio_event_{nullptr};    ///< GPIO rising edge event
+  esp_etm_task_handle_t capture_task_{nullptr};   ///< GPTimer capture task
+  esp_etm_channel_handle_t etm_channel_{nullptr}; ///< Event → task connection
+  uint32_t last_rise_us_{0};                      ///< Previous captured rising edge (ISR only)
+  bool has_rise_{false};                          ///< last_rise_us_ is valid (ISR only)
+};
+#endif
+
+#if SOC_MCPWM_SUPPORTED
+/**
+ * @class McpwmCaptureDetector
+ * @brief MCPWM capture channel latches both edges at APB clock, its ISR counts rising edges
+ *
+ * Works on every chip with MCPWM (no ETM needed) and also yields the detector pulse width.
+ */
+class McpwmCaptureDetector : public SoftwareEdgeCounter {
+ public:
+  static constexpr const char *NAME = "MCPWM capture";
+  const char *name() const { return NAME; }
+
+  bool setup(gpio_num_t pin, HalfCyclePeriodTracker *tracker);
+  template<WatchPointHandler Handler> esp_err_t start(void *ctx) {
+    this->ctx_ = ctx;
+    return this->start_(&on_capture_<Handler>);
+  }
+  void dump_config() const;
+  void log_statistics() const;
+
+ protected:
+  template<WatchPointHandler Handler>
+  static bool IRAM_ATTR on_capture_(mcpwm_cap_channel_handle_t channel, const mcpwm_capture_event_data_t *edata,
+                                    void *user_ctx) {
+    McpwmCaptureDetector *detector = static_cast<McpwmCaptureDetector *>(user_ctx);
+    if (edata->cap_edge != MCPWM_CAP_EDGE_POS) {
+      detector->track_falling_edge_(edata->cap_value);
+      return false;
+    }
+    uint32_t edge_us = edata->cap_value / detector->ticks_per_us_;
+    if (!detector->accept_edge_(edge_us)) {
+      return false;
+    }
+    detector->track_rising_edge_(edata->cap_value);
+    // The capture timer cannot be read back here; ISR entry time is the edge plus interrupt latency
+    return detector->template count_edge_<Handler>(static_cast<uint32_t>(esp_timer_get_time()));
+  }
+  void IRAM_ATTR track_rising_edge_(uint32_t ticks);
+  void IRAM_ATTR track_falling_edge_(uint32_t ticks);
+  esp_err_t start_(mcpwm_capture_event_cb_t callback);
+
+  mcpwm_cap_timer_handle_t timer_{nullptr};     ///< MCPWM capture timer (free-running, APB clock)
+  mcpwm_cap_channel_handle_t channel_{nullptr}; ///< Capture channel on the zero-cross pin
+  uint32_t ticks_per_us_{1};                    ///< Capture timer ticks per microsecond
+  uint32_t last_rise_ticks_{0};                 ///< Capture value of the previous rising edge (ISR only)
+  bool has_rise_{false};                        ///< last_rise_ticks_ is valid (ISR only)
+};
+#endif
+
+/**
+ * @class FallbackDetector
+ * @brief Uses Primary, or Secondary when Primary cannot be set up
+ *
+ * Covers PCNT units being taken by other components: PCNT allocation fails at setup and the
+ * GPIO interrupt detector takes over with the same watch point semantics.
+ */
+template<typename Primary, typename Secondary> class FallbackDetector {
+ public:
+  static constexpr const char *NAME = Primary::NAME;
+  const char *name() const { return this->use_secondary_ ? Secondary::NAME : Primary::NAME; }
+
+  bool setup(gpio_num_t pin, HalfCyclePeriodTracker *tracker) {
+    if (this->primary_.setup(pin, tracker)) {
+      return true;
+    }
+    ESP_LOGW("zero_cross_relay", "⚠️ %s detector unavailable, falling back to %s", Primary::NAME, Secondary::NAME);
+    this->use_secondary_ = true;
+    return this->secondary_.setup(pin, tracker);
+  }
+  template<WatchPointHandler Handler> esp_err_t start(void *ctx) {
+    return this->use_secondary_ ? this->secondary_.template start<Handler>(ctx)
+                                : this->primary_.template start<Handler>(ctx);
+  }
+  esp_err_t IRAM_ATTR add_watch_point(int value) {
+    return this->use_secondary_ ? this->secondary_.add_watch_point(value) : this->primary_.add_watch_point(value);
+  }
+  esp_err_t IRAM_ATTR remove_watch_point(int value) {
+    return this->use_secondary_ ? this->secondary_.remove_watch_point(value)
+                                : this->primary_.remove_watch_point(value);
+  }
+  void IRAM_ATTR clear_count() {
+    if (this->use_secondary_) {
+      this->secondary_.clear_count();
+    } else {
+      this->primary_.clear_count();
+    }
+  }
+  int get_count() const { return this->use_secondary_ ? this->secondary_.get_count() : this->primary_.get_count(); }
+  const volatile uint32_t *edge_lag() const {
+    return this->use_secondary_ ? this->secondary_.edge_lag() : this->primary_.edge_lag();
+  }
+  const volatile uint32_t *edge_time() const {
+    return this->use_secondary_ ? this->secondary_.edge_time() : this->primary_.edge_time();
+  }
+  void dump_config() const {
+    if (this->use_secondary_) {
+      ESP_LOGCONFIG("zero_cross_relay", "  Detector fallback: %s unavailable at setup, using %s", Primary::NAME,
+                    Secondary::NAME);
+      this->secondary_.dump_config();
+    } else {
+      this->primary_.dump_config();
+    }
+  }
+  void log_statistics() const {
+    if (this->use_secondary_) {
+      this->secondary_.log_statistics();
+    } else {
+      this->primary_.log_statistics();
+    }
+  }
+
+ protected:
+  Primary primary_;
+  Secondary secondary_;
+  bool use_secondary_{false};  ///< Primary failed at setup (fixed afterwards, read in ISR)
+};
+
+// ========================================
+// Output Policies
+// Interface: setup(relay_pin, zero_cross_pin, initial_level), schedule(level), schedule_cut(fire, release) (ISR),
+// refill(...) (worker task), update(...), set_switch_delays(on, off) (loop), set_switch_log(log),
+// set_edge_lag(lag), dump_config(), log_statistics().
+// Timing arrives as microseconds derived from the tracked half-cycle, so phase stays constant at any mains frequency.
+// SWITCHES_PER_EDGE: needs the flip watch point and a timer per transition.
+// PLAYS_WINDOW: refilled once per window by the worker task.
+// ========================================
+
+/**
+ * @class GptimerOutput
+ * @brief Free-running GPTimer with a queue of timed relay events, alarm ISR writes the relay GPIO
+ *
+ * Events never restart the timer, so a transition scheduled while another is still pending (short
+ * windows, flip points 19/20, coil leads longer than a half-cycle, phase-cut releases) keeps its own time.
+ * An event commanded later supersedes queued ones due at or after its time, so the newest command always
+ * sets the final level. Driver errors and full queues are counted; loop() recovers a missed alarm and
+ * rewrites a pin found at the wrong level.
+ */
+class GptimerOutput {
+ public:
+  static constexpr OutputMode MODE = OUTPUT_MODE_GPTIMER;
+  static constexpr bool SWITCHES_PER_EDGE = true;
+  static constexpr bool PLAYS_WINDOW = false;
+
+  bool setup(gpio_num_t relay_pin, gpio_num_t zero_cross_pin, int initial_level);
+
+  /// Switch the relay to level after the switch delay (ISR context)
+  void IRAM_ATTR schedule(int level) {
+    uint32_t delay_us = this->level_delay_us_[level & 1];
+    if (delay_us == 0) {
+      delay_us = this->delay_us_;
+    }
+    uint64_t edge = this->edge_time_();
+    portENTER_CRITICAL_ISR(&this->lock_);
+    this->push_(edge + delay_us, level);
+    this->arm_head_();
+    portEXIT_CRITICAL_ISR(&this->lock_);
+  }
+
+  /**
+   * @brief Fire the relay at a phase angle of this half-cycle (ISR context)
+   * @param fire_us Delay after the edge to switch HIGH
+   * @param release_us Delay after the edge to switch LOW again (0 = stay HIGH)
+   */
+  void IRAM_ATTR schedule_cut(uint32_t fire_us, uint32_t release_us) {
+    uint64_t edge = this->edge_time_();
+    portENTER_CRITICAL_ISR(&this->lock_);
+    this->push_(edge + fire_us, 1);
+    if (release_us > fire_us) {
+      this->push_(edge + release_us, 0);
+    }
+    this->arm_head_();
+    portEXIT_CRITICAL_ISR(&this->lock_);
+  }
+  void refill(uint64_t pattern, int length, uint32_t half_cycle_us, uint32_t delay_us, uint32_t boundary_time) {}
+
+  /**
+   * @brief Take over the switch delay and check the relay timeline (task context)
+   * @param synced false while another writer (the no-sync fallback PWM) owns the pin
+   */
+  void update(int flip_point, uint32_t half_cycle_us, uint32_t delay_us, bool synced);
+
+  /// Per-level delays overriding the switch delay, e.g. coil lead times (task context, 0 = switch delay)
+  void set_switch_delays(uint32_t on_us, uint32_t off_us) {
+    this->level_delay_us_[1] = on_us;
+    this->level_delay_us_[0] = off_us;
+  }
+  void set_switch_log(RelaySwitchLog *log) { this->switch_log_ = log; }
+  /// Lag of the counted edge behind the reference edge, taken off every delay (nullptr = none)
+  void set_edge_lag(const volatile uint32_t *lag) { this->edge_lag_ = lag; }
+  void dump_config() const;
+  void log_statistics() const;
+
+ protected:
+  /// One queued relay transition
+  struct Event {
+    uint64_t time;  ///< Timer count to switch at (1us ticks)
+    int level;      ///< Level to write
+  };
+
+  uint32_t IRAM_ATTR edge_lag_us_() const { return (this->edge_lag_ != nullptr) ? *this->edge_lag_ : 0; }
+
+  /// Timer count of the reference edge being handled (ISR context)
+  uint64_t IRAM_ATTR edge_time_() {
+    uint64_t now = 0;
+    this->check_(gptimer_get_raw_count(this->timer_, &now));
+    return now - this->edge_lag_us_();
+  }
+
+  /// Count a driver error (ISR or task context)
+  void IRAM_ATTR check_(esp_err_t err) {
+    if (err != ESP_OK) {
+      this->errors_++;
+      this->last_error_ = err;
+    }
+  }
+
+  /// Queue an event; later commands supersede queued events due at or after it (lock_ held)
+  void IRAM_ATTR push_(uint64_t time, int level);
+  /// Program the alarm for the earliest queued event (lock_ held)
+  void IRAM_ATTR arm_head_();
+  /**
+   * @brief Write the newest event due at now and drop it and older ones (lock_ held)
+   * @return bool true if at least one event was due
+   */
+  bool IRAM_ATTR apply_due_(uint64_t now);
+
+  /**
+   * @brief GPTimer alarm interrupt callback function (ISR context)
+   *
+   * Fires at the earliest queued event, writes the relay pin and re-arms for the next one.
+   */
+  static bool IRAM_ATTR on_alarm_(gptimer_handle_t timer, const gptimer_alarm_event_data_t *edata, void *user_ctx);
+
+  gptimer_handle_t timer_{nullptr};    ///< GPTimer handle (free-running 1MHz timeline)
+  gpio_num_t pin_{GPIO_NUM_NC};        ///< Relay output
+  volatile uint32_t delay_us_{0};      ///< Switch delay for the tracked period (written by loop)
+  volatile uint32_t level_delay_us_[2]{0, 0}; ///< Delay per target level (0 = delay_us_), written by loop
+  RelaySwitchLog *switch_log_{nullptr};  ///< Transition record for feedback timing and wear (optional)
+  const volatile uint32_t *edge_lag_{nullptr}; ///< Counted edge lag published by the detector (optional)
+  portMUX_TYPE lock_ = portMUX_INITIALIZER_UNLOCKED; ///< Guards the queue (watch point ISR ↔ alarm ISR ↔ loop)
+  Event queue_[GPTIMER_QUEUE_DEPTH];   ///< Pending transitions, ordered by time
+  uint8_t queue_count_{0};             ///< Events in queue_
+  int written_level_{-1};              ///< Level last written to the pin (-1 = none)
+  bool level_fault_{false};            ///< Pin read back at the wrong level last check (loop only)
+  volatile uint32_t events_{0};        ///< Events queued
+  volatile uint32_t superseded_{0};    ///< Queued events dropped by a later command due earlier
+  volatile uint32_t overflows_{0};     ///< Events that replaced the newest one in a full queue
+  volatile uint32_t late_{0};          ///< Due events collapsed into one write (alarm serviced late)
+  volatile uint32_t errors_{0};        ///< GPTimer driver calls that failed
+  volatile esp_err_t last_error_{ESP_OK}; ///< Latest failed driver call
+  uint32_t stuck_recoveries_{0};       ///< Overdue events applied by loop() (alarm missed)
+  uint32_t level_repairs_{0};          ///< Pin found at the wrong level and rewritten by loop()
+};
+
+#if SOC_RMT_SUPPORTED
+/**
+ * @class RmtOutput
+ * @brief RMT TX plays back the whole window timeline, refilled once per window
+ */
+class RmtOutput {
+ public:
+  static constexpr OutputMode MODE = OUTPUT_MODE_RMT;
+  static constexpr bool SWITCHES_PER_EDGE = false;
+  static constexpr bool PLAYS_WINDOW = true;
+
+  bool setup(gpio_num_t relay_pin, gpio_num_t zero_cross_pin, int initial_level);
+  void IRAM_ATTR schedule(int level) {}
+  void IRAM_ATTR schedule_cut(uint32_t fire_us, uint32_t release_us) {}
+  void set_switch_delays(uint32_t on_us, uint32_t off_us) {}
+  void set_switch_log(RelaySwitchLog *log) {}
+  void set_edge_lag(const volatile uint32_t *lag) { this->edge_lag_ = lag; }
+
+  /**
+   * @brief Encode the current window as RMT symbols and start playback (worker task context)
+   *
+   * The timeline starts one switch delay after the boundary edge (minus dispatch latency) and
+   * places one level per half-cycle using the measured mains period. Runs are merged; a window
+   * without transitions is skipped because the channel idles at the previous level.
+   *
+   * @param pattern Bit i = level of half-cycle i
+   * @param length Half-cycles in the window
+   * @param half_cycle_us Tracked half-cycle period
+   * @param delay_us Switch delay after the zero-cross edge
+   * @param boundary_time esp_timer timestamp of the boundary edge
+   */
+  void refill(uint64_t pattern, int length, uint32_t half_cycle_us, uint32_t delay_us, uint32_t boundary_time);
+  void update(int flip_point, uint32_t half_cycle_us, uint32_t delay_us, bool synced) {}
+  void dump_config() const;
+  void log_statistics() const;
+
+ protected:
+  rmt_channel_handle_t channel_{nullptr};  ///< RMT TX channel driving the relay pin
+  rmt_encoder_handle_t encoder_{nullptr};  ///< Copy encoder (symbols are prebuilt by the worker task)
+  rmt_symbol_word_t symbols_[RMT_MAX_WINDOW_SYMBOLS]; ///< Window timeline being played back (worker task only)
+  int level_{0};                           ///< Level the RMT channel idles at after the last window (worker task only)
+  volatile uint32_t refill_count_{0};      ///< Windows handed to the RMT channel
+  volatile uint32_t late_count_{0};        ///< Refills that started after the switch delay had elapsed
+  const volatile uint32_t *edge_lag_{nullptr}; ///< Counted edge lag published by the detector (optional)
+};
+#endif
+
+#if SOC_MCPWM_SUPPORTED
+/**
+ * @class McpwmOutput
+ * @brief MCPWM timer synced to the zero-cross pin, comparators gate every half-cycle (phase control)
+ */
+class McpwmOutput {
+ public:
+  static constexpr OutputMode MODE = OUTPUT_MODE_MCPWM;
+  static constexpr bool SWITCHES_PER_EDGE = false;
+  static constexpr bool PLAYS_WINDOW = false;
+
+  /**
+   * @brief Create the MCPWM timer/operator/comparators/generator with zero-cross sync
+   */
+  bool setup(gpio_num_t relay_pin, gpio_num_t zero_cross_pin, int initial_level);
+  void IRAM_ATTR schedule(int level) {}
+  void IRAM_ATTR schedule_cut(uint32_t fire_us, uint32_t release_us) {}
+  void refill(uint64_t pattern, int length, uint32_t half_cycle_us, uint32_t delay_us, uint32_t boundary_time) {}
+  void set_switch_delays(uint32_t on_us, uint32_t off_us) {}
+  void set_switch_log(RelaySwitchLog *log) {}
+  void set_edge_lag(const volatile uint32_t *lag) {}
+
+  /**
+   * @brief Load comparator values from the flip point and measured half-cycle (task context)
+   *
+   * Holds the output LOW while no zero-cross edges are seen, and uses force levels for 0% / 100%.
+   * Comparator updates take effect at the next sync, so changes are glitch-free.
+   */
+  void update(int flip_point, uint32_t half_cycle_us, uint32_t delay_us, bool synced);
+  void dump_config() const;
+  void log_statistics() const;
+
+ protected:
+  mcpwm_timer_handle_t timer_{nullptr};          ///< MCPWM timer, phase reset to 0 by every zero-cross edge
+  mcpwm_oper_handle_t operator_{nullptr};        ///< MCPWM operator owning comparators and generator
+  mcpwm_cmpr_handle_t fire_comparator_{nullptr};    ///< Comparator A: output HIGH (firing delay)
+  mcpwm_cmpr_handle_t release_comparator_{nullptr}; ///< Comparator B: output LOW before the next zero-cross
+  mcpwm_gen_handle_t generator_{nullptr};        ///< Generator driving the relay pin
+  mcpwm_sync_handle_t sync_source_{nullptr};     ///< GPIO sync source on the zero-cross pin
+  uint32_t fire_ticks_{0};                       ///< Comparator A value currently loaded (us after zero-cross)
+  uint32_t release_ticks_{0};                    ///< Comparator B value currently loaded (us after zero-cross)
+  int force_level_{-2};                          ///< Generator force level (-1=released, 0/1=held, -2=unset)
+};
+#endif
+
 /**
  * @class ZeroCrossRelayComponent
  * @brief Zero-Cross Detection Solid State Relay Component Class
+ *
+ * Shared tracking and control core. The detector and output stage are supplied by
+ * ZeroCrossRelay<Detector, Output>, which __init__.py instantiates from the YAML selection.
  */
 class ZeroCrossRelayComponent : public Component {
  public:
@@ -61,13 +964,28 @@ class ZeroCrossRelayComponent : public Component {
    *                   - 10 = 50% duty cycle (default, half power)
    *                   - 19 = 95% duty cycle (maximum power)
    *                   - 20 = 100% duty cycle (always on)
-   * 
+   *
    * @note Lower flip point = shorter on-time = lower power
    *       Higher flip point = longer on-time = higher power
    *       Duty cycle = flip_point / 20.0
    */
   void set_duty_cycle_flip_point(int flip_point);
 
+  /**
+   * @brief Set duty cycle as a percentage
+   * @param percent 0-100; time proportioning mode resolves it to single half-cycles of the long window,
+   *                the other modes round it to the nearest flip point (5% steps)
+   */
+  void set_duty_cycle_percent(float percent);
+
+  /**
+   * @brief Set the time proportioning window length (must be called before setup())
+   * @param half_cycles Multiple of 20 (e.g. 1000 = 10s at 50Hz)
+   */
+  void set_window_length(uint32_t half_cycles) {
+    window_segments_ = static_cast<uint16_t>((half_cycles + WINDOW_LENGTH - 1) / WINDOW_LENGTH);
+  }
+
   /**
    * @brief Get current duty cycle flip point
    * @return int Current flip point (0-20)
@@ -78,90 +996,1701 @@ class ZeroCrossRelayComponent : public Component {
    * @brief Get current duty cycle percentage
    * @return float Duty cycle percentage (0.0% - 100.0%)
    */
-  float get_duty_cycle_percentage() const { return (this->duty_cycle_flip_point_ / 20.0f) * 100.0f; }
+  float get_duty_cycle_percentage() const {
+    return ((this->duty_cycle_flip_point_ + this->cut_fraction_ / static_cast<float>(CUT_FRACTION_STEPS)) / 20.0f) *
+           100.0f;
+  }
 
   /**
-   * @brief Component initialization (setup phase)
-   * 
-   * Configures GPIO pins and registers interrupt service routines
+   * @brief Select the window modulation mode (must be called before setup())
+   * @param mode MODULATION_FLIP_POINT (default), MODULATION_PATTERN, MODULATION_TIME_PROPORTIONING or MODULATION_HYBRID
    */
-  void setup() override;
+  void set_modulation_mode(ModulationMode mode) {
+    modulation_mode_ = mode;
+    modulation_mode_configured_ = true;
+  }
 
   /**
-   * @brief Component main loop (loop phase)
-   * 
-   * Used for periodic tasks (such as frequency calculation)
+   * @brief Select the batched edge telemetry front end (must be called before setup())
+   * @param mode EDGE_CAPTURE_NONE (default) or EDGE_CAPTURE_RMT
    */
-  void loop() override;
+  void set_edge_capture_mode(EdgeCaptureMode mode) { edge_capture_mode_ = mode; }
 
   /**
-   * @brief Get component priority
-   * @return float Priority (higher value initializes first)
+   * @brief Apply flip point changes inside the current window instead of at the next boundary
+   * @param immediate true to cut or move the running window's flip point (GPTimer output, flip point mode)
    */
-  float get_setup_priority() const override { return setup_priority::IO; }
+  void set_immediate_apply(bool immediate) { immediate_apply_ = immediate; }
 
   /**
-   * @brief Output component configuration information to log
+   * @brief Set the relay switch delay after each zero-cross edge as a phase angle
+   * @param degrees 0-90° of the half-cycle (180° = one half-cycle); scaled to the tracked period
    */
-  void dump_config() override;
+  void set_switch_phase(float degrees) { switch_phase_q16_ = static_cast<uint32_t>(degrees / 180.0f * 65536.0f); }
 
- protected:
-  InternalGPIOPin *zero_cross_pin_{nullptr};   ///< Zero-cross detection input pin
-  InternalGPIOPin *relay_output_pin_{nullptr}; ///< Relay output pin
+  /**
+   * @brief Enable the timer-only PWM used while no zero-cross edges arrive (must be called before setup())
+   * @param period_ms PWM period in ms (0 = disabled, relay held at its last level)
+   */
+  void set_fallback_pwm_period(uint32_t period_ms) { fallback_period_us_ = static_cast<uint64_t>(period_ms) * 1000U; }
 
-  // PCNT (Pulse Counter) related
-  pcnt_unit_handle_t pcnt_unit_{nullptr};      ///< PCNT unit handle (count 0-20, auto-loop)
-  pcnt_channel_handle_t pcnt_channel_{nullptr}; ///< PCNT channel handle (GPIO3 rising edge count)
-  
-  // GPTimer (Hardware Timer) related - for delay control
-  gptimer_handle_t delay_timer_{nullptr};      ///< GPTimer handle (for 2000us delay)
-  
-  volatile uint32_t trigger_count_{0};         ///< PCNT watch point trigger counter (total count of flip point and 20)
-  volatile uint32_t cycle_count_{0};           ///< Complete cycle counter (20 counts per cycle)
-  volatile uint32_t last_cycle_time_{0};       ///< Last cycle completion timestamp (us)
-  float estimated_frequency_{0.0f};            ///< Estimated AC frequency (Hz) - based on 20-count cycle
-  
-  // GPIO control state (used in timer interrupt to determine HIGH or LOW level)
-  volatile int pending_gpio_level_{-1};        ///< Pending GPIO level to set (0=LOW, 1=HIGH, -1=none)
-  
-  // Duty cycle control (configurable flip point, range: 0-20)
-  volatile int duty_cycle_flip_point_{10};     ///< GPIO flip point (when to pull LOW), range 0-20, default 10 (50% duty)
-  volatile int pending_duty_cycle_flip_point_{-1};  ///< Pending flip point request (0-20, -1=none)
-  volatile esp_err_t last_watch_point_update_err_{ESP_OK}; ///< Last watch point update result
-  volatile bool watch_point_update_event_{false}; ///< Flag indicating watch point update result pending for log output
-  
-  gpio_num_t zero_cross_gpio_num_;             ///< Zero-cross detection GPIO number (ESP-IDF format)
-  gpio_num_t relay_output_gpio_num_;           ///< Relay output GPIO number (ESP-IDF format)
+  /**
+   * @brief Set how long the zero-cross input must be silent before the fallback PWM takes over
+   * @param timeout_ms Timeout in ms (default 500)
+   */
+  void set_fallback_timeout(uint32_t timeout_ms) { fallback_timeout_ms_ = timeout_ms; }
 
   /**
-   * @brief PCNT Watch Point interrupt callback function (ISR context)
-   * 
-   * Triggered by hardware when PCNT count reaches Watch Point (10 or 20)
-   * Does not directly control GPIO, instead starts hardware timer for 2000us delay
-   * 
-   * @param unit PCNT unit handle
-   * @param edata Watch Point event data (contains trigger value)
-   * @param user_ctx User context pointer (this pointer)
-   * @return bool Whether to wake higher priority task
+   * @brief Drive a mechanical relay: coil switched ahead of the zero-cross by the learned operate/release time
+   * @param mechanical true for a mechanical or hybrid relay (time proportioning, GPTimer output)
    */
-  static bool IRAM_ATTR pcnt_on_reach_callback(pcnt_unit_handle_t unit,
-                                                const pcnt_watch_event_data_t *edata,
-                                                void *user_ctx);
+  void set_mechanical(bool mechanical) { mechanical_ = mechanical; }
 
   /**
-   * @brief GPTimer alarm interrupt callback function (ISR context)
-   * 
-   * Executes 2000us after PCNT interrupt is triggered
-   * Controls GPIO4 level according to pending_gpio_level_ value
-   * 
-   * @param timer GPTimer handle
-   * @param edata Alarm event data
-   * @param user_ctx User context pointer (this pointer)
-   * @return bool Whether to wake higher priority task
+   * @brief Set the initial coil operate and release times (refined from contact feedback)
+   * @param operate_us Coil energised → contacts closed
+   * @param release_us Coil released → contacts open
+   */
+  void set_relay_timing(uint32_t operate_us, uint32_t release_us) {
+    operate_us_ = operate_us;
+    release_us_ = release_us;
+  }
+
+  /**
+   * @brief Set the contact feedback input (auxiliary contact or current-presence comparator, HIGH = closed)
    */
-  static bool IRAM_ATTR timer_alarm_callback(gptimer_handle_t timer,
-                                              const gptimer_alarm_event_data_t *edata,
-                                              void *user_ctx);
+  void set_contact_feedback_pin(InternalGPIOPin *pin) { contact_feedback_pin_ = pin; }
+
+  /**
+   * @brief Set the current-zero input (load current sign comparator, both edges are current zeros)
+   *
+   * Turn-off commands are then scheduled just after the measured current zero instead of the voltage zero.
+   */
+  void set_current_zero_pin(InternalGPIOPin *pin) { current_zero_pin_ = pin; }
+
+  /**
+   * @brief Measured load current lag behind the voltage zero-cross
+   * @return float Degrees of the half-cycle (0 until locked)
+   */
+  float get_current_lag_degrees() const {
+    uint32_t half_us = this->isr_half_cycle_us_;
+    return (half_us > 0) ? static_cast<float>(this->current_lag_us_) * 180.0f / static_cast<float>(half_us) : 0.0f;
+  }
+
+  /**
+   * @brief Sample the load current on an ADC pin with continuous ADC DMA (must be called before setup())
+   * @param pin ADC1 input of the current transformer (biased to mid-scale or AC-coupled)
+   * @param amps_per_volt Current per volt at the pin (CT ratio / burden resistor)
+   */
+  void set_current_sense(InternalGPIOPin *pin, float amps_per_volt);
+
+  /**
+   * @brief RMS load current of the last complete half-cycle
+   * @return float Amps (0 until the first half-cycle has been measured)
+   */
+  float get_current_rms() const { return this->current_rms_; }
+
+  /**
+   * @brief Relay state during the last measured half-cycle
+   * @return int 1 = conducting, 0 = off, -1 = unknown (output stage does not report transitions)
+   */
+  int get_current_conduction() const { return this->current_conduction_; }
+
+  /**
+   * @brief Filtered RMS current of conducting half-cycles (load current)
+   */
+  float get_current_rms_on() const { return this->current_rms_on_; }
+
+  /**
+   * @brief Filtered RMS current of off half-cycles (SSR leakage, snubber current)
+   */
+  float get_current_rms_off() const { return this->current_rms_off_; }
+
+  /**
+   * @brief Sample the mains voltage in the same ADC stream for P/Q/PF metering (needs set_current_sense())
+   * @param pin ADC1 input of the voltage divider or transformer (biased to mid-scale)
+   * @param volts_per_volt Mains volts per volt at the pin
+   */
+  void set_voltage_sense(InternalGPIOPin *pin, float volts_per_volt) {
+    voltage_sense_pin_ = pin;
+    voltage_volts_per_volt_ = volts_per_volt;
+  }
+
+  /**
+   * @brief Load power at 100% duty, used by set_target_power() until metering has measured it
+   * @param watts Rated (modelled) full power
+   */
+  void set_rated_power(float watts) { rated_power_ = watts; }
+
+  /**
+   * @brief Regulate the duty cycle to deliver a power setpoint
+   * @param watts Target average power (negative = off, manual duty cycle control)
+   *
+   * The full-on power comes from metering (conducting cycles) when available, else from set_rated_power().
+   * With voltage metering, an integral term on the measured power error trims the feed-forward duty cycle.
+   */
+  void set_target_power(float watts);
+
+  /**
+   * @brief Active power, averaged over the last second of metered cycles
+   * @return float Watts
+   */
+  float get_active_power() const { return this->power_avg_; }
+
+  /**
+   * @brief Reactive power (fundamental, positive = inductive), averaged over the last second
+   * @return float var
+   */
+  float get_reactive_power() const { return this->reactive_avg_; }
+
+  /**
+   * @brief Power factor of the last metered cycle with current (active power / apparent power)
+   */
+  float get_power_factor() const { return this->meter_pf_; }
+
+  /**
+   * @brief RMS mains voltage of the last metered cycle
+   */
+  float get_voltage_rms() const { return this->meter_voltage_rms_; }
+
+  /**
+   * @brief Enable the SSR thermal model (junction and heatsink RC stages, stepped once per 20 half-cycles)
+   * @param on_voltage On-state voltage drop in V; loss = drop x mean rectified current
+   * @param junction_resistance Junction to heatsink in K/W
+   * @param heatsink_resistance Heatsink to ambient in K/W
+   * @param junction_tau Junction stage time constant in s
+   * @param heatsink_tau Heatsink stage time constant in s
+   */
+  void set_thermal_model(float on_voltage, float junction_resistance, float heatsink_resistance, float junction_tau,
+                         float heatsink_tau);
+
+  /**
+   * @brief Junction temperatures where derating starts and where the allowed duty cycle reaches 0
+   */
+  void set_thermal_limits(float derate_start, float max_temperature) {
+    thermal_derate_start_q8_ = static_cast<int32_t>(derate_start * 256.0f);
+    thermal_max_q8_ = static_cast<int32_t>(max_temperature * 256.0f);
+  }
+
+  /**
+   * @brief Fixed ambient temperature, or the chip temperature sensor (reads high, so errs on the safe side)
+   */
+  void set_ambient_temperature(float celsius, bool from_chip_sensor) {
+    thermal_ambient_q8_ = static_cast<int32_t>(celsius * 256.0f);
+    thermal_chip_ambient_ = from_chip_sensor;
+  }
+
+  /**
+   * @brief Load current at 100% duty for the thermal model when no current transformer is fitted
+   */
+  void set_rated_current(float amps) { thermal_rated_ma_ = static_cast<uint32_t>(amps * 1000.0f); }
+
+  /**
+   * @brief Estimated SSR junction temperature in °C (NAN without the thermal model)
+   */
+  float get_junction_temperature() const;
+
+  /**
+   * @brief Estimated heatsink temperature in °C (NAN without the thermal model)
+   */
+  float get_heatsink_temperature() const;
+
+  /**
+   * @brief Highest duty cycle the thermal model currently allows (100 = no derating)
+   */
+  float get_duty_limit_percent() const { return this->duty_limit_percent_; }
+
+  /**
+   * @brief Hard limits checked in the window-boundary ISR, independent of the setpoint API (GPTimer or RMT output)
+   * @param max_on_ms Longest continuous conduction (0 = no limit)
+   * @param min_off_ms Shortest off-time before the next burst (0 = no limit)
+   * @param max_average_percent Highest rolling-average duty (100 = no limit)
+   * @param average_window_ms Time constant of the rolling average
+   * @param safe_percent Duty cycle forced while tripped
+   */
+  void set_watchdog(uint32_t max_on_ms, uint32_t min_off_ms, float max_average_percent, uint32_t average_window_ms,
+                    float safe_percent);
+
+  /**
+   * @brief Limit that tripped the watchdog (WATCHDOG_OK while none)
+   */
+  WatchdogTrip get_watchdog_trip() const { return this->watchdog_trip_; }
+
+  /**
+   * @brief Release a tripped watchdog; the safe duty cycle holds until the next setpoint
+   */
+  void clear_watchdog();
+
+  /**
+   * @brief Limit how fast set_duty_cycle_percent() raises the duty cycle (falls apply at once)
+   * @param percent_per_second Ramp rate (0 = off); a detected lamp or motor may raise it
+   */
+  void set_ramp_rate(float percent_per_second) { ramp_rate_ = percent_per_second; }
+
+  /**
+   * @brief Configure the load type, or let commissioning detect it
+   * @param type Known load type, or LOAD_TYPE_UNKNOWN with detect = true
+   * @param detect Run the commissioning test pattern once when no profile is stored (GPTimer output)
+   */
+  void set_load_type(LoadType type, bool detect) {
+    load_profile_.type = type;
+    load_detection_auto_ = detect;
+  }
+
+  /**
+   * @brief Switch the relay through the commissioning test pattern (off, full on) and classify the load
+   *
+   * Takes a few seconds. The result is stored in flash and its defaults applied; a changed modulation mode
+   * takes effect at the next boot.
+   */
+  void start_load_detection();
+
+  /**
+   * @brief Detected (or configured) load type
+   */
+  LoadType get_load_type() const { return static_cast<LoadType>(this->load_profile_.type); }
+
+  /**
+   * @brief Printable name of a load type
+   */
+  static const char *load_type_name(LoadType type);
+
+  /**
+   * @brief Relay switching operations over its lifetime (restored from flash)
+   */
+  uint32_t get_switch_operations() const { return this->wear_base_ + this->switch_log_.count; }
+
+  /**
+   * @brief Verify the relay against a feedback input after every commanded transition (GPTimer output)
+   * @param pin Output readback, or current-presence comparator (its edges are counted by a PCNT unit)
+   * @param type FEEDBACK_LEVEL or FEEDBACK_CURRENT
+   * @param fault_threshold Consecutive mismatching samples that trip the failsafe
+   */
+  void set_output_feedback(InternalGPIOPin *pin, FeedbackType type, uint32_t fault_threshold) {
+    feedback_pin_ = pin;
+    feedback_type_ = type;
+    feedback_fault_threshold_ = fault_threshold;
+  }
+
+  /**
+   * @brief Output held HIGH while no fault is latched, e.g. the coil of a series contactor
+   */
+  void set_failsafe_pin(InternalGPIOPin *pin) { failsafe_pin_ = pin; }
+
+  /**
+   * @brief Latched output fault (OUTPUT_FAULT_NONE while verification agrees)
+   */
+  OutputFault get_output_fault() const { return this->output_fault_; }
+
+  /**
+   * @brief Release a latched output fault: re-energise the failsafe output and accept setpoints again
+   *
+   * The relay stays off until the next setpoint; a fault that persists trips again within a few cycles.
+   */
+  void clear_output_fault();
+
+  /**
+   * @brief Whether the timer-only PWM fallback currently drives the relay
+   */
+  bool is_fallback_active() const { return this->fallback_active_; }
+
+  /**
+   * @brief Get the tracked half-cycle period
+   * @return uint32_t Half-cycle period in us (hardware timestamps if available, else window average)
+   */
+  uint32_t get_half_cycle_period_us() const { return this->measured_half_cycle_us_(); }
+
+  /**
+   * @brief Select how set_duty_cycle_flip_point() lays out on half-cycles in pattern mode
+   * @param distribution Even spread or single burst
+   */
+  void set_pattern_distribution(PatternDistribution distribution) { pattern_distribution_ = distribution; }
+
+  /**
+   * @brief Install the flicker-optimised pattern table (generated by flicker.py, must be called before setup())
+   * @param table Pattern per on-count, index 0 to pattern length (kept in flash, not copied)
+   * @param size Number of entries (pattern length + 1)
+   */
+  void set_pattern_table(const uint64_t *table, size_t size) {
+    pattern_table_ = table;
+    pattern_table_size_ = size;
+  }
+
+  /**
+   * @brief Set the pattern window length in half-cycles (pattern mode only, must be called before setup())
+   * @param length Window length, range 1-64 (default 20)
+   */
+  void set_pattern_length(uint8_t length) { pattern_length_ = length; }
+
+  /**
+   * @brief Install an arbitrary conduction pattern (pattern mode only)
+   * @param pattern Bit i set = conduct during half-cycle i of the window (LSB first).
+   *                Bits at or above the pattern length are ignored.
+   *
+   * @note Applied at the next window boundary, like duty cycle updates.
+   *       A later set_duty_cycle_flip_point() call replaces it with a built pattern.
+   */
+  void set_custom_pattern(uint64_t pattern);
+
+  /**
+   * @brief Get the pattern currently being shifted out by the ISR
+   * @return uint64_t Active pattern (0 when not in pattern mode)
+   */
+  uint64_t get_active_pattern() const { return this->active_pattern_; }
+
+  /**
+   * @brief Build a conduction pattern with on_count bits set out of length
+   * @param on_count Number of conducting half-cycles (clamped to length)
+   * @param length Window length in half-cycles (1-64)
+   * @param distribution Even spread or burst
+   * @return uint64_t Pattern, bit i = half-cycle i (LSB first)
+   */
+  static uint64_t build_pattern(int on_count, int length, PatternDistribution distribution);
+
+  /**
+   * @brief Component main loop (loop phase)
+   *
+   * Used for periodic tasks (such as frequency calculation)
+   */
+  void loop() override;
+
+  /**
+   * @brief Persist the switching operation count before a reboot
+   */
+  void on_shutdown() override;
+
+  /**
+   * @brief Get component priority
+   * @return float Priority (higher value initializes first)
+   */
+  float get_setup_priority() const override { return setup_priority::IO; }
+
+  /**
+   * @brief Output component configuration information to log
+   */
+  void dump_config() override;
+
+ protected:
+  InternalGPIOPin *zero_cross_pin_{nullptr};   ///< Zero-cross detection input pin
+  InternalGPIOPin *relay_output_pin_{nullptr}; ///< Relay output pin
+
+  const char *detector_name_{""};              ///< Detector policy name (for logs)
+  bool initialized_{false};                    ///< setup() completed, detector running
+
+  volatile uint32_t trigger_count_{0};         ///< Watch point trigger counter (total count of flip point and 20)
+  volatile uint32_t cycle_count_{0};           ///< Complete cycle counter (20 counts per cycle)
+  volatile uint32_t last_cycle_time_{0};       ///< Last cycle completion timestamp (us)
+  uint32_t last_boundary_timestamp_{0};        ///< esp_timer timestamp of the previous window boundary (ISR only)
+  volatile uint32_t zero_cross_timestamp_{0};  ///< esp_timer timestamp of the latest boundary or long-window segment edge (0 = none)
+  const volatile uint32_t *edge_time_{nullptr}; ///< Latest counted edge published by a timestamping detector (optional)
+  float estimated_frequency_{0.0f};            ///< Estimated AC frequency (Hz) - based on 20-count cycle
+
+  // Duty cycle control (configurable flip point, range: 0-20)
+  volatile int duty_cycle_flip_point_{10};     ///< GPIO flip point (when to pull LOW), range 0-20, default 10 (50% duty)
+  volatile int pending_duty_cycle_flip_point_{-1};  ///< Pending flip point request (0-20, -1=none)
+  volatile esp_err_t last_watch_point_update_err_{ESP_OK}; ///< Last watch point update result
+  volatile bool watch_point_update_event_{false}; ///< Flag indicating watch point update result pending for log output
+  volatile int window_cut_point_{10};          ///< Count at which the current window goes LOW (0 = LOW, 20 = HIGH throughout)
+  volatile int armed_watch_point_{-1};         ///< Flip watch point installed in the detector (-1 = none)
+  volatile bool watch_point_claimed_{false};   ///< Task moves the flip watch point outside window_lock_; ISRs defer theirs
+  volatile int deferred_watch_point_{NO_DEFERRED_WATCH_POINT}; ///< Watch point an ISR asked for while claimed
+  bool immediate_apply_{false};                ///< Apply flip point changes inside the current window
+  uint32_t switch_phase_q16_{DEFAULT_SWITCH_PHASE_Q16}; ///< Switch delay as a Q16 fraction of the half-cycle
+
+  // Hybrid mode (whole half-cycles in flip point form, plus one phase-cut half-cycle at the window start)
+  volatile int cut_fraction_{0};               ///< Phase-cut share of the current window, 0-255 of a half-cycle
+  volatile int pending_cut_fraction_{-1};      ///< Cut fraction queued with pending_duty_cycle_flip_point_ (-1 = none)
+  static uint16_t cut_phase_q16_[CUT_FRACTION_STEPS]; ///< Firing phase per fraction, Q16 of the half-cycle (DRAM)
+
+  // Idle fast path (flip point at 0 or 20: output latched, boundary watch point removed)
+  volatile bool idle_latched_{false};          ///< Boundary interrupt off until the next setpoint change
+  portMUX_TYPE window_lock_ = portMUX_INITIALIZER_UNLOCKED; ///< Guards window state (boundary ISR ↔ setpoint changes)
+  bool idle_edges_alive_{true};                ///< Liveness state last reported while idle (loop only)
+
+  // Timer-only PWM fallback (no zero-cross signal: DC SSR or failed detector)
+  uint64_t fallback_period_us_{0};             ///< Fallback PWM period (0 = disabled)
+  uint32_t fallback_timeout_ms_{500};          ///< Edge silence before the fallback takes over
+  esp_timer_handle_t fallback_timer_{nullptr}; ///< One-shot esp_timer stepping the PWM phases
+  volatile bool fallback_active_{false};       ///< PWM owns the relay pin; cleared by the ISR at a window start
+  bool fallback_in_on_phase_{false};           ///< PWM is in the on part of its period (timer task only)
+  uint64_t fallback_off_us_{0};                ///< Off time of the running PWM period (timer task only)
+  volatile bool fallback_exit_event_{false};   ///< ISR handed control back, pending log output
+  uint32_t fallback_entries_{0};               ///< Times the fallback was entered
+  portMUX_TYPE fallback_lock_ = portMUX_INITIALIZER_UNLOCKED; ///< Orders PWM pin writes against the ISR handover
+
+  // Interrupt-storm governor (window completions faster than any plausible mains rate)
+  volatile bool storm_active_{false};          ///< Watch point interrupts off, relay held off until edges are sane
+  volatile bool storm_probing_{false};         ///< Boundary watch point re-armed by loop to measure the edge rate
+  volatile bool storm_probe_armed_{false};     ///< Probe watch point installed in the detector
+  uint32_t storm_last_us_{0};                  ///< Time of the previous 20-edge mark, 0 = none (ISR only)
+  uint8_t storm_run_{0};                       ///< Consecutive fast windows, or sane ones while probing (ISR only)
+  uint8_t storm_edges_{0};                     ///< Edges since the last 20-edge mark (ISR only)
+  volatile bool storm_event_{false};           ///< ISR tripped the governor, pending log output
+  volatile bool storm_exit_event_{false};      ///< ISR handed control back, pending log output
+  volatile uint32_t storm_trips_{0};           ///< Times the governor tripped
+  uint32_t storm_probe_ms_{0};                 ///< millis() of the last probe (loop only)
+
+  // Mechanical relay (coil lead learned from contact feedback, wear counter in flash)
+  bool mechanical_{false};                     ///< Switch the coil ahead of the zero-cross
+  volatile uint32_t operate_us_{10000};        ///< Learned coil operate time (feedback ISR)
+  volatile uint32_t release_us_{5000};         ///< Learned coil release time (feedback ISR)
+  volatile uint32_t lead_half_cycles_{2};      ///< Zero-crosses between coil command and contact landing (loop)
+  InternalGPIOPin *contact_feedback_pin_{nullptr}; ///< Contact feedback input (optional)
+  gpio_num_t contact_gpio_num_{GPIO_NUM_NC};   ///< Contact feedback GPIO number
+  bool contact_inverted_{false};               ///< Feedback pin is active LOW
+  RelaySwitchLog switch_log_;                  ///< Transitions written by the output stage
+  uint32_t contact_matched_count_{0};          ///< Transition already timed by the feedback ISR (ISR only)
+  volatile uint32_t contact_learn_count_{0};   ///< Feedback edges accepted into the learned times
+  volatile uint32_t contact_reject_count_{0};  ///< Feedback edges outside the plausible operate time range
+  ESPPreferenceObject wear_pref_;              ///< Flash slot of the operation count
+  uint32_t wear_base_{0};                      ///< Operations recorded before this boot
+  uint32_t wear_saved_{0};                     ///< switch_log_.count at the last save
+  uint32_t wear_save_ms_{0};                   ///< millis() of the last save
+
+  // Zero-current turn-off (inductive loads: current zero lags the detected voltage zero)
+  InternalGPIOPin *current_zero_pin_{nullptr}; ///< Current sign comparator input (optional)
+  gpio_num_t current_zero_gpio_num_{GPIO_NUM_NC}; ///< Current-zero GPIO number
+  volatile uint32_t current_lag_us_{0};        ///< Filtered current lag after the voltage zero (current-zero ISR)
+  volatile uint32_t current_lag_samples_{0};   ///< Lag samples accepted
+  volatile uint32_t current_lag_rejects_{0};   ///< Current zeros outside 0-90° of lag (capacitive, noise)
+  uint32_t last_current_zero_us_{0};           ///< Previous accepted current zero (current-zero ISR only)
+
+  // Half-cycle RMS current (one continuous ADC stream for all relays, decoded by the first one's worker task)
+  InternalGPIOPin *current_sense_pin_{nullptr}; ///< Current transformer ADC input (optional)
+  float current_amps_per_volt_{1.0f};          ///< Pin voltage to load current
+  int current_adc_channel_{-1};                ///< ADC1 channel of current_sense_pin_ (set in setup)
+  uint32_t current_sum_{0};                    ///< Sample sum of the open half-cycle (DC offset removal)
+  uint64_t current_sum_sq_{0};                 ///< Sample square sum of the open half-cycle
+  uint32_t current_samples_{0};                ///< Samples in the open half-cycle
+  uint32_t current_start_us_{0};               ///< Time of the first sample of the open half-cycle
+  uint32_t current_end_us_{0};                 ///< Voltage zero-cross that closes the open half-cycle (0 = not aligned)
+  uint32_t current_zero_cross_seen_{0};        ///< Zero-cross timestamp the half-cycle grid was last aligned to
+  volatile float current_rms_{0.0f};           ///< RMS current of the last complete half-cycle (A)
+  volatile int current_conduction_{-1};        ///< Relay level during that half-cycle (-1 = unknown)
+  volatile float current_rms_on_{0.0f};        ///< Filtered RMS of conducting half-cycles (A)
+  volatile float current_rms_off_{0.0f};       ///< Filtered RMS of off half-cycles (A)
+  volatile uint32_t current_half_cycles_{0};   ///< Half-cycles measured
+  volatile uint32_t current_partial_{0};       ///< Half-cycles discarded for missing samples (gaps, realignment)
+#if SOC_ADC_DMA_SUPPORTED
+  static adc_continuous_handle_t adc_handle_;  ///< Continuous ADC driver (one per chip)
+  static uint8_t adc_frame_[ADC_FRAME_RESULTS * SOC_ADC_DIGI_RESULT_BYTES]; ///< Frame read by the worker task
+#endif
+  static volatile uint32_t adc_frames_done_;   ///< Frames queued by the driver (conversion done minus overflows)
+  static volatile uint32_t adc_frame_time_us_; ///< esp_timer time of the latest frame completion
+  static volatile uint32_t adc_overflows_;     ///< Frames lost because the worker fell behind
+  static uint32_t adc_frames_read_;            ///< Frames decoded (worker task only)
+  static uint32_t adc_result_interval_q8_;     ///< Time between two conversions of the stream, Q8 us
+
+  // Metering (voltage channel in the same stream, fundamental P/Q per mains cycle from a sine table)
+  InternalGPIOPin *voltage_sense_pin_{nullptr}; ///< Mains voltage ADC input (optional)
+  float voltage_volts_per_volt_{1.0f};         ///< Pin voltage to mains voltage
+  int voltage_adc_channel_{-1};                ///< ADC1 channel of voltage_sense_pin_ (set in setup)
+  CycleSums meter_voltage_;                    ///< Voltage sums of the open cycle
+  CycleSums meter_current_;                    ///< Current sums of the open cycle
+  uint32_t meter_cycle_start_us_{0};           ///< Zero-cross that opened the cycle (0 = waiting for one)
+  uint32_t meter_phase_step_q16_{0};           ///< Table steps per us of the open cycle, Q16
+  uint8_t meter_half_cycles_{0};               ///< Half-cycles of the open cycle already passed
+  uint8_t meter_on_halves_{0};                 ///< Of those, conducting
+  volatile float meter_pf_{0.0f};              ///< Power factor of the last cycle with current
+  volatile float meter_voltage_rms_{0.0f};     ///< RMS voltage of the last cycle (V)
+  volatile float meter_power_on_{0.0f};        ///< Filtered active power of fully conducting cycles (W)
+  volatile uint32_t meter_cycles_{0};          ///< Cycles metered
+  volatile uint32_t meter_partial_{0};         ///< Cycles discarded for missing samples
+  float meter_power_sum_{0.0f};                ///< Σ active power since loop() last averaged, guarded by meter_lock_
+  float meter_reactive_sum_{0.0f};             ///< Σ reactive power since loop() last averaged, guarded by meter_lock_
+  uint32_t meter_sum_cycles_{0};               ///< Cycles in the sums, guarded by meter_lock_
+  portMUX_TYPE meter_lock_ = portMUX_INITIALIZER_UNLOCKED; ///< Guards the averaging sums (worker task ↔ loop)
+  float power_avg_{0.0f};                      ///< Active power of the last averaging interval (W)
+  float reactive_avg_{0.0f};                   ///< Reactive power of the last averaging interval (var)
+  uint32_t power_update_ms_{0};                ///< millis() of the last averaging / regulation step
+  float rated_power_{0.0f};                    ///< Modelled full power (0 = unknown)
+  float target_power_{-1.0f};                  ///< Power setpoint (negative = regulation off)
+  float power_duty_percent_{-1.0f};            ///< Duty cycle last requested by the regulation
+  float power_integral_percent_{0.0f};         ///< Integral trim on the metered power error (reset per setpoint)
+  static int16_t sine_q15_[METER_TABLE_SIZE];  ///< One mains cycle of sine, Q15 (DRAM)
+
+  // Duty cycle ramp (rises stepped by loop)
+  float ramp_rate_{0.0f};                      ///< Percent per second (0 = off)
+  float ramp_percent_{0.0f};                   ///< Duty cycle last applied by either setpoint API (ramp start)
+  float ramp_target_percent_{-1.0f};           ///< Duty cycle the ramp is climbing to (-1 = none)
+  uint32_t ramp_step_ms_{0};                   ///< millis() of the last ramp step
+
+  // Load-type commissioning (test pattern in loop, result in flash)
+  LoadProfile load_profile_;                   ///< Configured, restored or detected profile
+  bool load_detection_auto_{false};            ///< Run commissioning once when no profile is stored
+  bool load_profile_stored_{false};            ///< A profile was restored from (or saved to) flash
+  bool load_auto_tried_{false};                ///< Automatic commissioning already ran this boot
+  ESPPreferenceObject load_pref_;              ///< Flash slot of the profile
+  LoadDetectionState load_detect_state_{LOAD_DETECT_IDLE}; ///< Test pattern phase
+  uint32_t load_detect_ms_{0};                 ///< millis() the phase started
+  uint32_t load_on_us_{0};                     ///< esp_timer time the test switch-on happened
+  uint32_t load_base_pulse_us_{0};             ///< Detector pulse width with the load off
+  uint32_t load_peak_sag_us_{0};               ///< Largest pulse widening while the inrush lasts
+  uint32_t load_lag_samples_base_{0};          ///< current_lag_samples_ at switch-on
+  uint32_t load_lag_rejects_base_{0};          ///< current_lag_rejects_ at switch-on
+  float load_inrush_rms_{0.0f};                ///< Peak half-cycle current of the inrush phase
+  volatile float current_peak_rms_{0.0f};      ///< Largest conducting half-cycle RMS since loop reset it (worker)
+
+  // SSR thermal model (temperatures Q8 °C, coefficients Q16, stepped by loop)
+  bool thermal_enabled_{false};                ///< set_thermal_model() was called
+  uint32_t thermal_on_mv_{1200};               ///< On-state voltage drop (mV)
+  uint32_t thermal_r_jh_q8_{256};              ///< Junction to heatsink (K/W, Q8)
+  uint32_t thermal_r_ratio_q8_{512};           ///< Heatsink to ambient over junction to heatsink resistance (Q8)
+  uint32_t thermal_a_j_q16_{0};                ///< Step over junction time constant (Q16, at most 1)
+  uint32_t thermal_a_h_q16_{0};                ///< Step over heatsink time constant (Q16, at most 1)
+  int32_t thermal_derate_start_q8_{80 * 256};  ///< Derating starts at this junction temperature
+  int32_t thermal_max_q8_{100 * 256};          ///< Allowed duty cycle reaches 0 here
+  int32_t thermal_ambient_q8_{40 * 256};       ///< Ambient (fixed, or the latest chip sensor reading)
+  bool thermal_chip_ambient_{false};           ///< Ambient from the chip temperature sensor
+  uint32_t thermal_rated_ma_{0};               ///< Full-on load current without a current transformer (mA)
+  int32_t thermal_junction_q8_{0};             ///< Estimated junction temperature
+  int32_t thermal_heatsink_q8_{0};             ///< Estimated heatsink temperature
+  uint32_t thermal_step_ms_{0};                ///< millis() of the last model step
+  uint32_t thermal_sum_ma_seen_{0};            ///< thermal_sum_ma_ at the last step
+  uint32_t thermal_half_cycles_seen_{0};       ///< thermal_half_cycles_ at the last step
+  uint32_t thermal_mean_ma_{0};                ///< Mean load current of the last step (held when no samples came)
+  volatile uint32_t thermal_sum_ma_{0};        ///< Running sum of half-cycle RMS currents in mA (worker)
+  volatile uint32_t thermal_half_cycles_{0};   ///< Half-cycles added to thermal_sum_ma_ (worker)
+  float duty_limit_percent_{100.0f};           ///< Derated duty cycle ceiling for every setpoint path
+  float requested_percent_{0.0f};              ///< Last requested setpoint (either API) before the ceiling
+
+  // Duty watchdog (window-boundary ISR; times in 1.024 ms ticks of esp_timer >> 10)
+  bool watchdog_enabled_{false};               ///< set_watchdog() was called and the output stage supports it
+  uint32_t watchdog_max_on_ticks_{0};          ///< Longest continuous conduction (0 = no limit)
+  uint32_t watchdog_min_off_ticks_{0};         ///< Shortest off-time before a burst (0 = no limit)
+  int32_t watchdog_max_average_q16_{65536};    ///< Highest rolling-average duty (65536 = no limit)
+  uint32_t watchdog_average_ticks_{1};         ///< Rolling average time constant
+  uint32_t watchdog_average_recip_q32_{0};     ///< 2^32 / watchdog_average_ticks_ (no division in the ISR)
+  float watchdog_safe_percent_{0.0f};          ///< Duty cycle forced while tripped
+  int watchdog_safe_flip_point_{0};            ///< watchdog_safe_percent_ as a flip point
+  uint64_t watchdog_safe_pattern_{0};          ///< watchdog_safe_percent_ as a pattern (pattern mode)
+  uint32_t watchdog_safe_window_on_{0};        ///< watchdog_safe_percent_ in half-cycles of a long window
+  bool watchdog_ends_on_{false};               ///< The last accounted block ended conducting (ISR only)
+  uint32_t watchdog_on_start_{0};              ///< Tick the running burst started (ISR only)
+  uint32_t watchdog_off_start_{0};             ///< Tick the relay last switched off (ISR only)
+  uint32_t watchdog_last_{0};                  ///< Tick of the last accounted block start (ISR only)
+  int32_t watchdog_average_q16_{0};            ///< Rolling-average duty (ISR only)
+  int32_t watchdog_block_duty_q16_{0};         ///< Duty of the last accounted block (ISR only)
+  volatile WatchdogTrip watchdog_trip_{WATCHDOG_OK}; ///< Latched until clear_watchdog()
+  volatile bool watchdog_event_{false};        ///< Tripped in the ISR, report pending in loop
+  uint32_t watchdog_trips_{0};                 ///< Times the watchdog tripped
+#if SOC_TEMP_SENSOR_SUPPORTED
+  static temperature_sensor_handle_t chip_sensor_; ///< Chip temperature sensor (one per chip, shared)
+#endif
+
+  // Output verification (feedback sampled by a periodic esp_timer, failsafe after consecutive mismatches)
+  InternalGPIOPin *feedback_pin_{nullptr};     ///< Output readback or current-presence input (optional)
+  gpio_num_t feedback_gpio_num_{GPIO_NUM_NC};  ///< Feedback GPIO number
+  bool feedback_inverted_{false};              ///< Feedback pin is active LOW
+  FeedbackType feedback_type_{FEEDBACK_LEVEL}; ///< What the feedback input reports
+  uint32_t feedback_fault_threshold_{3};       ///< Consecutive mismatches that trip the failsafe
+  pcnt_unit_handle_t feedback_unit_{nullptr};  ///< Edge counter of a current-presence input
+  pcnt_channel_handle_t feedback_channel_{nullptr}; ///< PCNT channel on the feedback pin
+  esp_timer_handle_t feedback_timer_{nullptr}; ///< Periodic sampling timer
+  uint32_t feedback_last_us_{0};               ///< Previous sample time (timer task only)
+  int feedback_last_edges_{-1};                ///< Detector count at the previous sample (timer task only)
+  uint32_t feedback_last_cycles_{0};           ///< Window count at the previous sample (timer task only)
+  uint32_t feedback_mismatch_run_{0};          ///< Consecutive mismatching samples (timer task only)
+  volatile uint32_t feedback_samples_{0};      ///< Samples compared against the commanded level
+  volatile uint32_t feedback_mismatches_{0};   ///< Samples that disagreed
+  volatile uint32_t feedback_skipped_{0};      ///< Samples too close to a transition, or without mains
+  volatile OutputFault output_fault_{OUTPUT_FAULT_NONE}; ///< Latched until clear_output_fault()
+  volatile bool output_fault_event_{false};    ///< Tripped in the timer task, failsafe pending in loop
+  InternalGPIOPin *failsafe_pin_{nullptr};     ///< Series contactor output (optional)
+  gpio_num_t failsafe_gpio_num_{GPIO_NUM_NC};  ///< Failsafe GPIO number
+
+  // Pattern mode (one bit per edge, window length up to 64 half-cycles)
+  ModulationMode modulation_mode_{MODULATION_FLIP_POINT};        ///< Window modulation mode
+  bool modulation_mode_configured_{false};     ///< modulation_mode set in YAML; load profiles only recommend a mode
+
+  // Time proportioning mode (software-extended window: segment counter on top of the 20-edge detector window)
+  uint16_t window_segments_{1};                ///< 20-edge segments per long window
+  volatile uint16_t window_segment_{0};        ///< Segment the detector is counting in (ISR-owned)
+  volatile uint32_t window_on_half_cycles_{0}; ///< On half-cycles of the current long window (ISR-owned)
+  volatile int32_t pending_window_on_{-1};     ///< On half-cycles queued for the next long window (-1 = none)
+  PatternDistribution pattern_distribution_{PATTERN_DISTRIBUTION_EVEN}; ///< Pattern builder distribution
+  const uint64_t *pattern_table_{nullptr};     ///< Flicker-optimised pattern per on-count (flash)
+  size_t pattern_table_size_{0};               ///< Entries in pattern_table_
+  uint8_t pattern_length_{20};                 ///< Pattern window length in half-cycles (1-64)
+  uint64_t active_pattern_{0};                 ///< Pattern of the current window (ISR-owned)
+  uint64_t pattern_shift_reg_{0};              ///< Remaining bits of the current window (ISR-owned)
+  uint8_t pattern_bits_left_{0};               ///< Edges left in the current window, 0 = at boundary (ISR-owned)
+  int pattern_watch_point_{1};                 ///< Watch point armed in pattern mode: 1, or the chunk size with window playback
+  volatile int commanded_level_{-1};           ///< Last level handed to the output stage (ISR-owned)
+  uint64_t pending_pattern_{0};                ///< Pattern queued by the API task, guarded by pattern_lock_
+  volatile bool pattern_update_pending_{false}; ///< pending_pattern_ is waiting for the next window boundary
+  portMUX_TYPE pattern_lock_ = portMUX_INITIALIZER_UNLOCKED; ///< Guards the 64-bit pattern handoff (API task ↔ ISR)
+
+  // Output stage
+  OutputMode output_mode_{OUTPUT_MODE_GPTIMER};  ///< Relay output stage (set by the output policy)
+  TaskHandle_t worker_task_handle_{nullptr};   ///< Deferred work task (RMT refill, RX decode), pinned to the interrupt core
+
+  // Period tracking (hardware timestamps from the detector or the RMT RX front end)
+  HalfCyclePeriodTracker period_tracker_;      ///< Filtered half-cycle period
+  volatile uint32_t isr_half_cycle_us_{0};     ///< Tracked half-cycle cached for ISRs (written by loop)
+  EdgeCaptureMode edge_capture_mode_{EDGE_CAPTURE_NONE}; ///< Batched edge telemetry front end
+#if SOC_RMT_SUPPORTED
+  rmt_channel_handle_t rx_channel_{nullptr};   ///< RMT RX channel on the zero-cross pin
+  rmt_symbol_word_t rx_buffer_[RMT_RX_BATCH_SYMBOLS]; ///< Driver receive buffer
+  rmt_symbol_word_t rx_batch_[RMT_RX_BATCH_SYMBOLS];  ///< Batch copied out by the ISR for the worker task
+#endif
+  volatile size_t rx_batch_symbols_{0};        ///< Valid symbols in rx_batch_
+  volatile bool rx_batch_last_{false};         ///< Batch ended the frame; worker re-arms the receiver
+  volatile bool rx_batch_busy_{false};         ///< rx_batch_ owned by the worker task until decoded
+  volatile uint32_t rx_batch_count_{0};        ///< Batches decoded
+  volatile uint32_t rx_drop_count_{0};         ///< Batches dropped because the worker was still busy
+  volatile uint32_t rx_min_interval_us_{0};    ///< Shortest half-cycle in the last batch
+  volatile uint32_t rx_max_interval_us_{0};    ///< Longest half-cycle in the last batch
+  uint32_t rx_since_rise_us_{0};               ///< Time since the last rising edge, carried across batches (worker only)
+  int rx_last_level_{0};                       ///< Level at the end of the previous batch (worker only)
+  bool rx_has_rise_{false};                    ///< rx_since_rise_us_ is valid (worker only)
+
+  int last_seen_count_{-1};                    ///< Detector count seen by the previous sync check
+  uint32_t last_seen_cycles_{0};               ///< cycle_count_ seen by the previous sync check
+  uint32_t last_edge_activity_ms_{0};          ///< millis() when edge activity was last observed
+
+  gpio_num_t zero_cross_gpio_num_;             ///< Zero-cross detection GPIO number (ESP-IDF format)
+  gpio_num_t relay_output_gpio_num_;           ///< Relay output GPIO number (ESP-IDF format)
+
+  /**
+   * @brief Validate the configuration and configure both GPIOs (setup Steps 1-2)
+   * @return bool true on success
+   */
+  bool setup_pins_();
+
+  /**
+   * @brief Level the relay starts at (0% => LOW, otherwise HIGH)
+   */
+  int initial_level_() const { return (this->duty_cycle_flip_point_ == 0) ? 0 : 1; }
+
+  /**
+   * @brief Watch points the detector needs at startup (setup Step 6), and log them
+   * @param switches_per_edge Output stage needs the flip point watch point
+   * @param points Receives up to two watch point values
+   * @return int Number of watch points written to points
+   */
+  int initial_watch_points_(bool switches_per_edge, int points[2]);
+
+  /**
+   * @brief Log a failed watch point installation during setup
+   */
+  void report_watch_point_error_(int value, esp_err_t err);
+
+  /**
+   * @brief Start the optional telemetry front end and the worker task (setup Steps 10-11)
+   * @param window_output Output stage is refilled per window by the worker task
+   * @return bool true on success
+   */
+  bool setup_telemetry_(bool window_output);
+
+  /**
+   * @brief Create the timer for the no-sync PWM fallback if configured (setup Step 12)
+   * @return bool true on success
+   */
+  bool setup_fallback_();
+
+  /**
+   * @brief Restore the wear counter and attach the contact feedback interrupt (setup Step 13)
+   * @return bool true on success
+   */
+  bool setup_mechanical_();
+
+  /**
+   * @brief Recompute the coil lead from the tracked period and learned times, save the wear counter (loop)
+   */
+  void update_mechanical_();
+
+  /**
+   * @brief Coil command delay after the watch point edge for a target level (task context)
+   */
+  uint32_t mechanical_delay_us_(int level) const;
+
+  /**
+   * @brief Contact feedback edge (ISR context): time the latest coil operation and refine the learned time
+   * @param arg Component pointer
+   */
+  static void IRAM_ATTR contact_feedback_isr_(void *arg);
+
+  /**
+   * @brief Attach the current-zero edge interrupt if configured (setup Step 14)
+   * @return bool true on success
+   */
+  bool setup_current_zero_();
+
+  /**
+   * @brief Turn-off delay after the voltage zero-cross for the measured current lag (task context)
+   * @return uint32_t Delay in us, 0 = use the switch delay (no lock yet, or lag shorter than it)
+   */
+  uint32_t turn_off_delay_us_() const;
+
+  /**
+   * @brief Current zero edge (ISR context): lag against the last window boundary, modulo the half-cycle
+   * @param arg Component pointer
+   */
+  static void IRAM_ATTR current_zero_isr_(void *arg);
+
+  /**
+   * @brief Start the continuous ADC stream for the current and voltage inputs (setup Step 15)
+   * @return bool true on success
+   */
+  bool setup_current_sense_();
+
+  /**
+   * @brief Configure the feedback input (PCNT unit for a current-presence comparator) and start sampling
+   *        (setup Step 16)
+   * @return bool true on success
+   */
+  bool setup_output_feedback_();
+
+  /**
+   * @brief Start the chip temperature sensor if it supplies the thermal model's ambient (setup Step 17)
+   * @return bool true on success
+   */
+  bool setup_thermal_();
+
+  /**
+   * @brief Advance the thermal model by one step and move the duty cycle ceiling (loop)
+   */
+  void update_thermal_();
+
+  /**
+   * @brief Compare the feedback with the commanded level, trip after consecutive mismatches (timer task)
+   */
+  void sample_output_feedback_();
+
+  /**
+   * @brief Sampling timer callback (esp_timer task)
+   * @param arg Component pointer
+   */
+  static void feedback_timer_callback_(void *arg);
+
+  /**
+   * @brief Command the relay off and report a fault tripped by the sampler (loop)
+   */
+  void trip_output_failsafe_();
+
+  /**
+   * @brief Warn and return true when a latched output fault blocks switching on (loop)
+   * @param on Setpoint would switch the relay on
+   */
+  bool output_fault_blocks_(bool on) const;
+
+  /**
+   * @brief Decode queued ADC frames into current and voltage half-cycles (worker task)
+   */
+  void read_adc_frames_();
+
+  /**
+   * @brief Add one current sample, closing the half-cycles it has passed (worker task)
+   * @param raw ADC result
+   * @param time_us esp_timer time of the conversion
+   */
+  void add_current_sample_(uint32_t raw, uint32_t time_us);
+
+  /**
+   * @brief Add one voltage sample to the open metering cycle (worker task)
+   */
+  void add_voltage_sample_(uint32_t raw, uint32_t time_us);
+
+  /**
+   * @brief Move the half-cycle grid up to a sample, closing half-cycles and metering cycles it has passed
+   * @return bool false while the zero-cross timebase is unknown (sample dropped)
+   */
+  bool advance_current_grid_(uint32_t time_us);
+
+  /**
+   * @brief Relay level at an instant, from the transitions logged by the output stage (-1 = unknown)
+   */
+  int conduction_at_(uint32_t time_us) const;
+
+  /**
+   * @brief Table kernel: accumulate one sample into a channel's cycle sums at its timestamp phase
+   */
+  void add_meter_sample_(CycleSums *sums, uint32_t raw, uint32_t time_us);
+
+  /**
+   * @brief A voltage zero-cross on the grid has passed: count the half-cycle, close the cycle after two
+   */
+  void advance_meter_cycle_();
+
+  /**
+   * @brief Compute P, Q, PF and RMS voltage of the closed cycle and publish them (worker task)
+   */
+  void finish_meter_cycle_();
+
+  /**
+   * @brief Average the metered power once per second and run the power setpoint regulation (loop)
+   */
+  void update_power_();
+
+  /**
+   * @brief Fill sine_q15_ (once, before the ADC stream starts)
+   */
+  static void build_sine_table_();
+
+  /**
+   * @brief Apply a duty cycle now, bypassing the ramp (set_duty_cycle_percent() body)
+   */
+  void apply_duty_percent_(float percent);
+
+  /**
+   * @brief Step a pending duty cycle rise at the ramp rate (loop)
+   */
+  void update_ramp_();
+
+  /**
+   * @brief Restore the stored load profile and apply its defaults before the detector starts (setup)
+   */
+  void restore_load_profile_();
+
+  /**
+   * @brief Apply the safe defaults of a load type: ramp rate now, modulation mode at boot only
+   * @param at_boot Still in setup (the modulation mode can change)
+   */
+  void apply_load_defaults_(bool at_boot);
+
+  /**
+   * @brief Advance the commissioning test pattern (loop)
+   */
+  void update_load_detection_();
+
+  /**
+   * @brief Stop the test pattern and restore the duty cycle (loop)
+   */
+  void abort_load_detection_(const char *reason);
+
+  /**
+   * @brief Classify the load from the test measurements, store, report and restore the duty cycle (loop)
+   */
+  void finish_load_detection_();
+
+  /**
+   * @brief Snap the half-cycle grid to the latest window boundary (worker task)
+   * @param time_us Time of the next sample
+   * @return bool false while the zero-cross timebase is unknown
+   */
+  bool align_current_grid_(uint32_t time_us);
+
+  /**
+   * @brief Publish the RMS of the open half-cycle and start the next one (worker task)
+   */
+  void finish_current_half_cycle_();
+
+#if SOC_ADC_DMA_SUPPORTED
+  /**
+   * @brief ADC conversion frame done (ISR context): timestamp the frame and wake the worker task
+   */
+  static bool IRAM_ATTR adc_conv_done_callback(adc_continuous_handle_t handle, const adc_continuous_evt_data_t *edata,
+                                               void *user_ctx);
+
+  /**
+   * @brief ADC pool overflow (ISR context): the frame was not queued, so it does not count
+   */
+  static bool IRAM_ATTR adc_pool_overflow_callback(adc_continuous_handle_t handle,
+                                                   const adc_continuous_evt_data_t *edata, void *user_ctx);
+#endif
+
+  /**
+   * @brief Log the setup summary
+   */
+  void log_setup_summary_();
+
+  /**
+   * @brief Start the timer-only PWM once the zero-cross input has been silent for the timeout (loop)
+   */
+  void check_sync_fallback_();
+
+  /**
+   * @brief On time per fallback PWM period for the current (or queued) setpoint
+   */
+  uint64_t fallback_on_us_() const;
+
+  /**
+   * @brief Write the next PWM level and arm the timer for the phase after it (esp_timer task context)
+   */
+  void step_fallback_pwm_();
+
+  /**
+   * @brief esp_timer callback for the fallback PWM
+   * @param arg Component pointer
+   */
+  static void fallback_timer_callback_(void *arg);
+
+  /**
+   * @brief Take the relay back from the fallback PWM and restart the window at this edge (ISR context)
+   *
+   * Once this returns the PWM no longer writes the pin, so the level scheduled next is the first
+   * zero-cross-aligned transition.
+   */
+  void IRAM_ATTR end_fallback_();
+
+  /**
+   * @brief Reset window state so the current edge starts a fresh window in every mode (ISR context)
+   */
+  void IRAM_ATTR restart_window_();
+
+  /**
+   * @brief Feed edges into the storm governor (ISR context, watch points armed normally)
+   * @param edges Edges since the previous call (20 at a boundary, 1 per pattern mode edge)
+   * @return bool true if the governor tripped; the caller removes the watch points
+   */
+  bool IRAM_ATTR storm_mark_(uint32_t edges);
+
+  /**
+   * @brief Judge one probe window while the governor is tripped (ISR context)
+   * @return int -1 = still storming (remove the probe watch point), 0 = keep probing, 1 = sane again
+   */
+  int IRAM_ATTR storm_probe_mark_();
+
+  /**
+   * @brief Log governor events and re-arm the probe at a low rate while tripped (task context)
+   */
+  void update_storm_();
+
+  /**
+   * @brief Whether zero-cross edges were seen recently (task context)
+   * @param count Current detector count
+   */
+  bool edges_active_(int count);
+
+  /**
+   * @brief Leave the idle fast path after a setpoint change (task context)
+   *
+   * Must be called after the new setpoint has been stored so idle entry in the ISR sees it.
+   */
+  void leave_idle_();
+
+  /**
+   * @brief Latch the output and drop the boundary watch point if the setpoint sits at a rail
+   *
+   * ISR context, window_lock_ held.
+   */
+  template<typename Detector> void IRAM_ATTR try_enter_idle_(Detector &detector) {
+    int flip_point = this->duty_cycle_flip_point_;
+    if ((flip_point != 0 && flip_point != WINDOW_LENGTH) || this->cut_fraction_ != 0) {
+      return;
+    }
+    if (flip_point == WINDOW_LENGTH && this->watchdog_enabled_) {
+      return;  // Conduction time is accounted at the boundary, which idle would remove
+    }
+    if (this->current_zero_pin_ != nullptr || this->current_sense_pin_ != nullptr) {
+      return;  // Current lag and the ADC half-cycle grid take their voltage zero from the boundary
+    }
+    if (this->pending_duty_cycle_flip_point_ < 0 && detector.remove_watch_point(WINDOW_LENGTH) == ESP_OK) {
+      this->idle_latched_ = true;
+    }
+  }
+
+  /**
+   * @brief Number of half-cycles in one modulation window for the active mode
+   */
+  int window_half_cycles_() const;
+
+  /**
+   * @brief Build the pattern for a flip point using the configured distribution
+   * @param flip_point Duty cycle flip point (0-20), scaled to the pattern length
+   * @return uint64_t Pattern, bit i = half-cycle i (LSB first)
+   */
+  uint64_t pattern_for_flip_point_(int flip_point) const;
+
+  /**
+   * @brief Pattern of the window that is playing (worker task context)
+   */
+  uint64_t window_pattern_();
+
+  /**
+   * @brief Hand a pattern to the ISR; it is swapped in at the next window boundary
+   * @param pattern Pattern to install (masked to pattern_length_)
+   * @param flip_point Flip point equivalent reported by get_duty_cycle_flip_point()
+   */
+  void queue_pattern_(uint64_t pattern, int flip_point);
+
+  /**
+   * @brief Record a window boundary for cycle time statistics (ISR context)
+   */
+  void IRAM_ATTR record_window_boundary_();
+
+  /**
+   * @brief Post event bits to the worker task (ISR context)
+   * @param events WORKER_EVENT_* bits
+   * @return bool Whether a higher priority task was woken
+   */
+  bool IRAM_ATTR notify_worker_from_isr_(uint32_t events);
+
+  /**
+   * @brief Pattern mode edge step (ISR context)
+   *
+   * Called on every zero-cross edge (watch point 1, count cleared each time) when the output stage
+   * switches per edge. Shifts out one pattern bit; the caller only arms the output stage when the level changes.
+   *
+   * @param window_start Set to true at a window boundary
+   * @return int Level to switch to, or -1 for no change
+   */
+  int IRAM_ATTR step_pattern_(bool *window_start);
+
+  /**
+   * @brief Count a chunk of edges of a pattern window the output stage plays back (ISR context)
+   *
+   * PCNT counts at most WINDOW_LENGTH edges, so a window takes ceil(pattern_length / 20) interrupts.
+   *
+   * @param edges Edges since the previous chunk (the watch point that fired)
+   * @param window_start Set to true at a window boundary
+   * @return int Watch point of the next chunk (edges to the next window start, at most WINDOW_LENGTH)
+   */
+  int IRAM_ATTR step_pattern_window_(int edges, bool *window_start);
+
+  /**
+   * @brief Window boundary of pattern mode: statistics, pattern swap and watchdog (ISR context)
+   */
+  void IRAM_ATTR begin_pattern_window_();
+
+  /**
+   * @brief Check the block about to play against the watchdog limits (ISR context)
+   *
+   * Blocks are laid out on-first (pattern windows are short enough to be treated alike).
+   *
+   * @param on On half-cycles the block would conduct
+   * @param length Half-cycles in the block
+   * @return bool true while tripped: the caller substitutes the safe duty cycle
+   */
+  bool IRAM_ATTR watchdog_check_(uint32_t on, uint32_t length);
+
+  /**
+   * @brief Record the block that actually plays (ISR context, after watchdog_check_())
+   */
+  void IRAM_ATTR watchdog_account_(uint32_t on, uint32_t length);
+
+  /**
+   * @brief Derive the safe flip point and pattern, start the accounting (setup Step 18)
+   * @return bool true on success
+   */
+  bool setup_watchdog_();
+
+  /**
+   * @brief Tracked half-cycle period: filtered hardware timestamps, else window average, else 50Hz nominal
+   * @return uint32_t Half-cycle period in us
+   */
+  uint32_t measured_half_cycle_us_() const;
+
+  /**
+   * @brief Switch delay in us for the tracked half-cycle period
+   */
+  uint32_t switch_delay_us_() const;
+
+  /**
+   * @brief Queue a hybrid setpoint for the next window boundary (task context)
+   * @param on_q8 On time in 1/256 half-cycles (0-5120): whole half-cycles plus the phase-cut fraction
+   */
+  void queue_hybrid_(uint32_t on_q8);
+
+  /**
+   * @brief Fill cut_phase_q16_: firing phase delivering each fraction of a half-cycle's energy (resistive load)
+   */
+  static void build_cut_phase_table_();
+
+  /**
+   * @brief Firing and release delays of the phase-cut half-cycle (ISR context)
+   * @param fraction Cut fraction (0-255)
+   * @param release_us Receives the release delay, just before the next zero-cross
+   * @return uint32_t Firing delay after the window start edge
+   */
+  uint32_t IRAM_ATTR cut_fire_us_(int fraction, uint32_t *release_us) const;
+
+  /**
+   * @brief Queue the on half-cycles of the next time proportioning window (task context)
+   */
+  void queue_window_on_(uint32_t on_half_cycles);
+
+  /**
+   * @brief Apply a flip point without touching the tracked setpoint (task context)
+   *
+   * Common path of both setpoint APIs and the ramp; clamps to the thermal ceiling.
+   */
+  void apply_flip_point_(int flip_point);
+
+  /**
+   * @brief Highest setpoint the thermal ceiling allows, rounded down
+   * @param steps Setpoint resolution at 100% (flip points, window half-cycles or hybrid cut steps)
+   */
+  uint32_t duty_ceiling_(uint32_t steps) const;
+
+  /**
+   * @brief Advance the long window by one 20-edge segment (ISR context)
+   *
+   * Refreshes the zero-cross timestamp every segment; records the window boundary and swaps in the
+   * queued setpoint when the last segment wraps.
+   * @return uint32_t Index of the segment that just started
+   */
+  uint32_t IRAM_ATTR advance_long_window_();
+
+  /**
+   * @brief Create the RMT RX channel on the zero-cross pin and start the first frame
+   * @return bool true on success
+   */
+  bool setup_rmt_capture_();
+
+  /**
+   * @brief Start (or restart) an RMT RX frame into rx_buffer_
+   * @return esp_err_t Result of rmt_receive()
+   */
+  esp_err_t arm_rmt_capture_();
+
+  /**
+   * @brief Decode rx_batch_ into edge statistics and the tracked period (worker task context)
+   */
+  void decode_rx_batch_();
+
+#if SOC_RMT_SUPPORTED
+  /**
+   * @brief RMT RX done callback (ISR context)
+   *
+   * Called once per filled buffer. Copies the symbols out and wakes the worker task.
+   *
+   * @param channel RMT channel handle
+   * @param edata Received symbols
+   * @param user_ctx User context pointer (this pointer)
+   * @return bool Whether to wake higher priority task
+   */
+  static bool IRAM_ATTR rmt_rx_done_callback(rmt_channel_handle_t channel, const rmt_rx_done_event_data_t *edata,
+                                             void *user_ctx);
+#endif
+
+  /**
+   * @brief Handle worker task events (worker task context)
+   * @param events WORKER_EVENT_* bits
+   */
+  virtual void process_worker_events_(uint32_t events);
+
+  /**
+   * @brief Current detector count (task context)
+   */
+  virtual int detector_count_() = 0;
+
+  /**
+   * @brief Push a setpoint that the output stage applies without waiting for a window boundary
+   */
+  virtual void apply_setpoint_now_() {}
+
+  /**
+   * @brief Install a flip point in the running window (task context)
+   * @return bool false if it has to wait for the window boundary
+   */
+  virtual bool apply_mid_window_(int flip_point) { return false; }
+
+  /**
+   * @brief Re-install the boundary watch point removed by the idle fast path (task context)
+   */
+  virtual esp_err_t restore_boundary_watch_point_() = 0;
+
+  /**
+   * @brief Re-arm the boundary watch point alone to measure the edge rate while the governor is tripped
+   */
+  virtual esp_err_t arm_storm_probe_() = 0;
+
+  /**
+   * @brief Log detector and output stage configuration
+   */
+  virtual void dump_stage_config_() = 0;
+
+  /**
+   * @brief Log detector and output stage statistics
+   */
+  virtual void log_stage_statistics_() = 0;
+
+  /**
+   * @brief Worker task entry (waits for ISR notifications)
+   * @param arg Component pointer
+   */
+  static void worker_task_loop_(void *arg);
+};
+
+/**
+ * @class ZeroCrossRelay
+ * @brief Component instantiated with a detector and an output policy
+ *
+ * ISR paths call the policies directly (no virtual dispatch); only the chosen
+ * detector and output stage are compiled into the firmware.
+ *
+ * @tparam Detector PcntDetector, GpioIsrDetector, EtmCaptureDetector or McpwmCaptureDetector
+ * @tparam Output GptimerOutput, RmtOutput or McpwmOutput
+ */
+template<typename Detector, typename Output> class ZeroCrossRelay : public ZeroCrossRelayComponent {
+ public:
+  ZeroCrossRelay() {
+    this->output_mode_ = Output::MODE;
+    this->detector_name_ = Detector::NAME;
+  }
+
+  /// Detector policy, for detector-specific configuration before setup (e.g. a second input)
+  Detector &get_detector() { return this->detector_; }
+
+  /**
+   * @brief Component initialization (setup phase)
+   *
+   * Configures GPIO pins, the detector, its watch points and the output stage
+   */
+  void setup() override {
+    if (!this->setup_pins_() || !this->detector_.setup(this->zero_cross_gpio_num_, &this->period_tracker_)) {
+      this->mark_failed();
+      return;
+    }
+    this->detector_name_ = this->detector_.name();
+
+    int points[2];
+    int num_points = this->initial_watch_points_(Output::SWITCHES_PER_EDGE, points);
+    for (int i = 0; i < num_points; i++) {
+      esp_err_t err = this->detector_.add_watch_point(points[i]);
+      if (err != ESP_OK) {
+        this->report_watch_point_error_(points[i], err);
+        this->mark_failed();
+        return;
+      }
+    }
+    if (this->modulation_mode_ == MODULATION_FLIP_POINT || this->modulation_mode_ == MODULATION_HYBRID) {
+      this->window_cut_point_ = this->duty_cycle_flip_point_;
+      this->armed_watch_point_ = watch_point_for_(this->duty_cycle_flip_point_);
+    }
+
+    if (this->detector_.template start<&ZeroCrossRelay::on_watch_point_>(this) != ESP_OK ||
+        !this->output_.setup(this->relay_output_gpio_num_, this->zero_cross_gpio_num_, this->initial_level_())) {
+      this->mark_failed();
+      return;
+    }
+    this->output_.update(this->duty_cycle_flip_point_, this->measured_half_cycle_us_(), this->switch_delay_us_(),
+                         false);
+
+    this->output_.set_switch_log(&this->switch_log_);
+    this->output_.set_edge_lag(this->detector_.edge_lag());
+    this->edge_time_ = this->detector_.edge_time();
+    if (!this->setup_telemetry_(Output::PLAYS_WINDOW) || !this->setup_fallback_() || !this->setup_mechanical_() ||
+        !this->setup_current_zero_() || !this->setup_current_sense_() || !this->setup_output_feedback_() ||
+        !this->setup_thermal_() || !this->setup_watchdog_()) {
+      this->mark_failed();
+      return;
+    }
+    this->initialized_ = true;
+    this->ramp_percent_ = this->get_duty_cycle_percentage();
+    this->requested_percent_ = this->ramp_percent_;
+    this->log_setup_summary_();
+  }
+
+  void loop() override {
+    // Rescale phase-relative timing to the tracked period (frequency may drift or change supply)
+    // A tripped storm governor holds MCPWM comparators off like a lost sync
+    bool synced = (Output::MODE == OUTPUT_MODE_MCPWM)
+                      ? this->edges_active_(this->detector_.get_count()) && !this->storm_active_
+                      : !this->fallback_active_;  // The fallback PWM writes the relay pin itself
+    this->output_.update(this->duty_cycle_flip_point_, this->measured_half_cycle_us_(), this->switch_delay_us_(),
+                         synced);
+    if (this->mechanical_) {
+      this->update_mechanical_();
+      this->output_.set_switch_delays(this->mechanical_delay_us_(1), this->mechanical_delay_us_(0));
+    } else if (this->current_zero_pin_ != nullptr) {
+      this->output_.set_switch_delays(0, this->turn_off_delay_us_());
+    }
+    ZeroCrossRelayComponent::loop();
+  }
+
+ protected:
+  /**
+   * @brief Watch point handler (ISR context), installed into the detector at compile time
+   *
+   * Flip point mode: count=flip point → output LOW, count=20 → window boundary (statistics,
+   * synchronous flip point swap, clear count, output HIGH or window refill).
+   * Hybrid mode is flip point mode whose window starts with a phase-cut half-cycle.
+   * Pattern mode: count=1 on every edge → next pattern bit; with window playback one interrupt per chunk
+   * of up to 20 edges, the chunk that ends the window refills the output stage.
+   * While the no-sync fallback PWM runs, everything up to the next window start is ignored;
+   * that window start hands the relay back.
+   * Every 20 edges feed the storm governor; once tripped only the probe boundary reaches this handler.
+   */
+  static bool IRAM_ATTR on_watch_point_(void *ctx, int watch_point_value) {
+    ZeroCrossRelay *self = static_cast<ZeroCrossRelay *>(ctx);
+    self->trigger_count_++;
+
+    if (self->storm_active_) {
+      if (watch_point_value != WINDOW_LENGTH) {
+        return false;
+      }
+      int probe = self->storm_probe_mark_();
+      if (probe <= 0) {
+        if (probe < 0) {
+          self->detector_.remove_watch_point(WINDOW_LENGTH);
+          self->storm_probe_armed_ = false;
+        }
+        return false;
+      }
+      // The probe watch point becomes the window boundary again (or makes way for the pattern one)
+      self->storm_probe_armed_ = false;
+      if (self->modulation_mode_ == MODULATION_PATTERN) {
+        // Back to the pattern watch point; the next edge starts a fresh pattern window
+        self->detector_.remove_watch_point(WINDOW_LENGTH);
+        self->detector_.add_watch_point(1);
+        self->pattern_watch_point_ = 1;
+        self->detector_.clear_count();
+        return false;
+      }
+      // Sane again: the other modes restart their window at this boundary below
+    } else {
+      int window_point = self->window_watch_point_();
+      if (watch_point_value == window_point && self->storm_mark_(static_cast<uint32_t>(window_point))) {
+        return self->trip_storm_();
+      }
+    }
+
+    if (self->fallback_active_) {
+      int window_start_point = self->window_watch_point_();
+      if (watch_point_value != window_start_point) {
+        return false;
+      }
+      self->end_fallback_();
+    }
+
+    if (self->modulation_mode_ == MODULATION_TIME_PROPORTIONING) {
+      if (watch_point_value == WINDOW_LENGTH) {
+        self->detector_.clear_count();
+        self->start_long_window_segment_();
+      } else if (watch_point_value == self->armed_watch_point_) {
+        self->output_.schedule(0);
+      }
+      return false;
+    }
+
+    if (self->modulation_mode_ == MODULATION_PATTERN) {
+      if (watch_point_value != self->pattern_watch_point_) {
+        return false;
+      }
+      self->detector_.clear_count();
+      bool window_start = false;
+      if (Output::PLAYS_WINDOW) {
+        // Output stage plays the whole window: only chunk ends interrupt, the window start refills it
+        int next = self->step_pattern_window_(watch_point_value, &window_start);
+        self->rearm_pattern_watch_point_(next);
+        return window_start ? self->notify_worker_from_isr_(WORKER_EVENT_RMT_REFILL) : false;
+      }
+      // Restart counting so the next edge hits watch point 1 again
+      int level = self->step_pattern_(&window_start);
+      if (level >= 0) {
+        self->output_.schedule(level);
+      }
+      return false;
+    }
+
+    if (watch_point_value == WINDOW_LENGTH) {
+      self->record_window_boundary_();
+      portENTER_CRITICAL_ISR(&self->window_lock_);
+      int pending_flip_point = self->pending_duty_cycle_flip_point_;
+      if (pending_flip_point >= 0 && pending_flip_point <= WINDOW_LENGTH &&
+          pending_flip_point != self->duty_cycle_flip_point_) {
+        self->apply_pending_flip_point_(pending_flip_point);
+      } else if (self->armed_watch_point_ != watch_point_for_(self->duty_cycle_flip_point_)) {
+        // A mid-window cut moved the watch point; the new window uses the plain flip point again
+        self->arm_watch_point_(watch_point_for_(self->duty_cycle_flip_point_));
+      }
+      int pending_fraction = self->pending_cut_fraction_;
+      if (pending_fraction >= 0 && (self->pending_duty_cycle_flip_point_ < 0 ||
+                                    self->pending_duty_cycle_flip_point_ == self->duty_cycle_flip_point_)) {
+        // Whole half-cycles are in place (or unchanged): the fraction swaps in with them
+        self->cut_fraction_ = pending_fraction;
+        self->pending_cut_fraction_ = -1;
+        self->pending_duty_cycle_flip_point_ = -1;
+        self->last_watch_point_update_err_ = ESP_OK;
+        self->watch_point_update_event_ = true;
+      }
+      int cut_fraction = self->cut_fraction_;
+      if (self->watchdog_enabled_) {
+        // The window about to play: whole half-cycles plus the phase-cut one
+        int flip_point = self->duty_cycle_flip_point_;
+        uint32_t on = static_cast<uint32_t>(flip_point) + ((cut_fraction > 0 && flip_point < WINDOW_LENGTH) ? 1U : 0U);
+        if (self->watchdog_check_(on, WINDOW_LENGTH)) {
+          if (flip_point != self->watchdog_safe_flip_point_) {
+            self->apply_pending_flip_point_(self->watchdog_safe_flip_point_);
+          }
+          self->cut_fraction_ = 0;
+          cut_fraction = 0;
+          on = static_cast<uint32_t>(self->duty_cycle_flip_point_);
+        }
+        self->watchdog_account_(on, WINDOW_LENGTH);
+      }
+      self->window_cut_point_ = self->duty_cycle_flip_point_;
+      self->detector_.clear_count();
+      // Rails need no further boundary work: the output level below holds until the setpoint changes
+      self->try_enter_idle_(self->detector_);
+      portEXIT_CRITICAL_ISR(&self->window_lock_);
+      if (Output::PLAYS_WINDOW) {
+        // Output plays back the whole window; the worker task encodes it after the swap above
+        return self->notify_worker_from_isr_(WORKER_EVENT_RMT_REFILL);
+      }
+      if (self->modulation_mode_ == MODULATION_HYBRID && (cut_fraction > 0 || self->duty_cycle_flip_point_ > 0)) {
+        // Random-fire SSR: the gate fired at the phase angle stays on into the whole half-cycles; with none it
+        // is released before the next zero-cross. A zero fraction fires just before that zero-cross.
+        uint32_t release_us;
+        uint32_t fire_us = self->cut_fire_us_(cut_fraction, &release_us);
+        self->output_.schedule_cut(fire_us, (self->duty_cycle_flip_point_ == 0) ? release_us : 0);
+        return false;
+      }
+      self->output_.schedule((self->duty_cycle_flip_point_ == 0) ? 0 : 1);
+      return false;
+    }
+
+    if (Output::SWITCHES_PER_EDGE && watch_point_value == self->armed_watch_point_) {
+      self->output_.schedule(0);
+    }
+    return false;
+  }
+
+  /// Watch point that ends a window (or pattern chunk) and feeds the storm governor
+  int IRAM_ATTR window_watch_point_() const {
+    return (this->modulation_mode_ == MODULATION_PATTERN) ? this->pattern_watch_point_ : WINDOW_LENGTH;
+  }
+
+  /// Move the pattern watch point to the next chunk size (ISR context)
+  void IRAM_ATTR rearm_pattern_watch_point_(int point) {
+    if (point == this->pattern_watch_point_) {
+      return;
+    }
+    this->detector_.remove_watch_point(this->pattern_watch_point_);
+    esp_err_t err = this->detector_.add_watch_point(point);
+    if (err == ESP_OK) {
+      this->pattern_watch_point_ = point;
+    } else {
+      // Keep the old chunk armed: windows drift until the next chunk of the right size, but edges still count
+      this->detector_.add_watch_point(this->pattern_watch_point_);
+      this->last_watch_point_update_err_ = err;
+      this->watch_point_update_event_ = true;
+    }
+  }
+
+  /**
+   * @brief Turn the watch point interrupts off and command the relay off after a storm trip (ISR context)
+   *
+   * MCPWM comparators are held off by loop(); the no-sync fallback PWM is stopped as well.
+   */
+  bool IRAM_ATTR trip_storm_() {
+    portENTER_CRITICAL_ISR(&this->window_lock_);
+    this->arm_watch_point_(-1);
+    this->detector_.remove_watch_point(this->window_watch_point_());
+    portEXIT_CRITICAL_ISR(&this->window_lock_);
+    portENTER_CRITICAL_ISR(&this->fallback_lock_);
+    this->fallback_active_ = false;
+    portEXIT_CRITICAL_ISR(&this->fallback_lock_);
+    if (Output::SWITCHES_PER_EDGE) {
+      this->output_.schedule(0);
+    }
+    if (Output::PLAYS_WINDOW) {
+      // window_pattern_() is empty while tripped, so the worker plays one all-off window
+      return this->notify_worker_from_isr_(WORKER_EVENT_RMT_REFILL);
+    }
+    return false;
+  }
+
+  /**
+   * @brief Program the segment that just started in time proportioning mode (ISR context)
+   *
+   * Constant cost per 20 edges regardless of window length: the window start switches HIGH, and the
+   * one segment holding the cut gets a watch point at its offset (or switches LOW at its start).
+   */
+  void IRAM_ATTR start_long_window_segment_() {
+    uint32_t segment_start = this->advance_long_window_() * WINDOW_LENGTH;
+    uint32_t on = this->window_on_half_cycles_;
+    if (this->watchdog_enabled_) {
+      // Long windows are checked per 20-edge segment
+      uint32_t segment_on = (on > segment_start) ? on - segment_start : 0U;
+      if (this->watchdog_check_((segment_on < WINDOW_LENGTH) ? segment_on : WINDOW_LENGTH, WINDOW_LENGTH)) {
+        // Cut the running window short; this segment's level is not covered by the switch points below
+        on = this->watchdog_safe_window_on_;
+        this->window_on_half_cycles_ = on;
+        this->duty_cycle_flip_point_ = this->watchdog_safe_flip_point_;
+        segment_on = (on > segment_start) ? on - segment_start : 0U;
+        if (segment_start > 0) {
+          this->output_.schedule((segment_on > 0) ? 1 : 0);
+        }
+      }
+      this->watchdog_account_((segment_on < WINDOW_LENGTH) ? segment_on : WINDOW_LENGTH, WINDOW_LENGTH);
+    }
+    if (segment_start == 0) {
+      this->output_.schedule((on > 0) ? 1 : 0);
+    } else if (on == segment_start) {
+      this->output_.schedule(0);
+    }
+    int watch_point = -1;
+    if (on > segment_start && on < segment_start + WINDOW_LENGTH) {
+      watch_point = static_cast<int>(on - segment_start);
+    }
+    this->arm_watch_point_(watch_point);
+  }
+
+  /**
+   * @brief Flip watch point needed for a flip point (-1 if the output stage or a rail needs none)
+   */
+  static int IRAM_ATTR watch_point_for_(int flip_point) {
+    return (Output::SWITCHES_PER_EDGE && flip_point > 0 && flip_point < WINDOW_LENGTH) ? flip_point : -1;
+  }
+
+  /**
+   * @brief Move the flip watch point (ISR context or task context with window_lock_ held)
+   * @param point New watch point (-1 = none)
+   */
+  esp_err_t IRAM_ATTR arm_watch_point_(int point) {
+    if (this->watch_point_claimed_ && xPortInIsrContext()) {
+      // The task is moving the watch point outside window_lock_; it installs this one when it lets go
+      this->deferred_watch_point_ = point;
+      return ESP_OK;
+    }
+    if (point == this->armed_watch_point_) {
+      return ESP_OK;
+    }
+    if (this->armed_watch_point_ >= 0) {
+      esp_err_t err = this->detector_.remove_watch_point(this->armed_watch_point_);
+      if (err != ESP_OK && err != ESP_ERR_NOT_FOUND) {
+        return err;
+      }
+      this->armed_watch_point_ = -1;
+    }
+    if (point >= 0) {
+      esp_err_t err = this->detector_.add_watch_point(point);
+      if (err != ESP_OK) {
+        return err;
+      }
+      this->armed_watch_point_ = point;
+    }
+    return ESP_OK;
+  }
+
+  /**
+   * @brief Move the flip point watch point at the window boundary (ISR context, window_lock_ held)
+   * @param pending_flip_point New flip point (0-20)
+   */
+  void IRAM_ATTR apply_pending_flip_point_(int pending_flip_point) {
+    int previous_watch_point = this->armed_watch_point_;
+    esp_err_t err = this->arm_watch_point_(watch_point_for_(pending_flip_point));
+    if (err == ESP_OK) {
+      this->duty_cycle_flip_point_ = pending_flip_point;
+      this->pending_duty_cycle_flip_point_ = -1;
+    } else if (this->armed_watch_point_ != previous_watch_point) {
+      // Restore previous watch point if it was removed successfully.
+      this->arm_watch_point_(previous_watch_point);
+    }
+    this->last_watch_point_update_err_ = err;
+    this->watch_point_update_event_ = true;
+  }
+
+  bool apply_mid_window_(int flip_point) override {
+    if (!Output::SWITCHES_PER_EDGE) {
+      return false;  // Window playback is already encoded; phase control applies immediately anyway
+    }
+    bool applied = false;
+    esp_err_t err = ESP_OK;
+    // Plan under window_lock_, move the watch point outside it (PCNT driver calls may log), then check that no
+    // boundary passed and no edge reached the new watch point before it was installed. An edge that outran the
+    // installation gets one re-plan from the newer count (the next edge is always >= 5ms away at up to 100Hz).
+    for (int attempt = 0; attempt < 2 && !applied; attempt++) {
+      int count = this->detector_.get_count();
+      portENTER_CRITICAL(&this->window_lock_);
+      MidWindowPlan plan = plan_mid_window_update(count, this->window_cut_point_, flip_point);
+      uint32_t window = this->cycle_count_;
+      bool proceed = plan.apply_now && !this->storm_active_;
+      if (proceed) {
+        this->watch_point_claimed_ = true;
+      }
+      portEXIT_CRITICAL(&this->window_lock_);
+      if (!proceed) {
+        break;
+      }
+
+      err = this->arm_watch_point_(plan.watch_point);
+      int after = this->detector_.get_count();
+
+      portENTER_CRITICAL(&this->window_lock_);
+      bool same_window = (this->cycle_count_ == window) && !this->storm_active_;
+      if (!same_window && this->deferred_watch_point_ == NO_DEFERRED_WATCH_POINT) {
+        // A boundary passed without asking for a move: the new window still needs its plain flip point
+        this->deferred_watch_point_ = watch_point_for_(this->duty_cycle_flip_point_);
+      }
+      if (err == ESP_OK && same_window && (plan.watch_point < 0 || after < plan.watch_point)) {
+        this->window_cut_point_ = plan.cut_point;
+        this->duty_cycle_flip_point_ = flip_point;
+        this->pending_duty_cycle_flip_point_ = -1;
+        applied = true;
+      }
+      portEXIT_CRITICAL(&this->window_lock_);
+      this->release_watch_point_();
+      if (err != ESP_OK || !same_window) {
+        break;
+      }
+    }
+    if (err != ESP_OK) {
+      // The boundary re-arms the flip point; fall back to the queued path
+      this->last_watch_point_update_err_ = err;
+      this->watch_point_update_event_ = true;
+    }
+    return applied;
+  }
+
+  /**
+   * @brief End a task-side watch point move and install what ISRs deferred meanwhile (task context)
+   */
+  void release_watch_point_() {
+    for (;;) {
+      portENTER_CRITICAL(&this->window_lock_);
+      int deferred = this->deferred_watch_point_;
+      this->deferred_watch_point_ = NO_DEFERRED_WATCH_POINT;
+      // Stay claimed while installing a deferred point, so a boundary meanwhile defers again
+      this->watch_point_claimed_ = (deferred != NO_DEFERRED_WATCH_POINT);
+      portEXIT_CRITICAL(&this->window_lock_);
+      if (deferred == NO_DEFERRED_WATCH_POINT) {
+        return;
+      }
+      esp_err_t err = this->arm_watch_point_(deferred);
+      if (err != ESP_OK) {
+        this->last_watch_point_update_err_ = err;
+        this->watch_point_update_event_ = true;
+      }
+    }
+  }
+
+  void process_worker_events_(uint32_t events) override {
+    if (Output::PLAYS_WINDOW && (events & WORKER_EVENT_RMT_REFILL)) {
+      this->output_.refill(this->window_pattern_(), this->window_half_cycles_(), this->measured_half_cycle_us_(),
+                           this->switch_delay_us_(), this->last_boundary_timestamp_);
+    }
+    ZeroCrossRelayComponent::process_worker_events_(events);
+  }
+
+  int detector_count_() override { return this->detector_.get_count(); }
+
+  esp_err_t restore_boundary_watch_point_() override { return this->detector_.add_watch_point(WINDOW_LENGTH); }
+
+  esp_err_t arm_storm_probe_() override {
+    if (this->storm_probe_armed_) {
+      return ESP_OK;
+    }
+    // Every watch point is off while tripped, so no ISR races these driver calls
+    this->detector_.clear_count();
+    esp_err_t err = this->detector_.add_watch_point(WINDOW_LENGTH);
+    if (err == ESP_OK) {
+      this->storm_probe_armed_ = true;
+    }
+    return err;
+  }
+
+  void apply_setpoint_now_() override {
+    this->output_.update(this->duty_cycle_flip_point_, this->measured_half_cycle_us_(), this->switch_delay_us_(),
+                         this->edges_active_(this->detector_.get_count()));
+  }
+
+  void dump_stage_config_() override {
+    this->detector_.dump_config();
+    this->output_.dump_config();
+  }
+
+  void log_stage_statistics_() override {
+    this->detector_.log_statistics();
+    this->output_.log_statistics();
+  }
+
+  Detector detector_;  ///< Zero-cross detector policy
+  Output output_;      ///< Relay output stage policy
 };
 
 }  // namespace zero_cross_relay